@@ -0,0 +1,56 @@
+// Compares the HashMap bucket policies on the lookup path for sequential,
+// strided and random integer keys under the identity std::hash.
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../include/HashMap.h"
+
+namespace {
+    constexpr size_t KEY_COUNT = 1 << 20;
+
+    template<typename Policy>
+    void run(const char *name, const std::vector<uint64_t> &keys) {
+        MySTL::HashMap<uint64_t, uint64_t, std::hash<uint64_t>, std::equal_to<uint64_t>, Policy> map;
+        map.reserve(keys.size());
+        for (auto key: keys) map.insert(key, key);
+
+        auto start = std::chrono::steady_clock::now();
+        uint64_t checksum = 0;
+        for (auto key: keys) checksum += *map.find(key);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+
+        auto stats = map.stats();
+        std::printf("%-10s find %6.1f ns/op  max_chain=%zu avg_chain=%.2f  (checksum %llu)\n", name,
+                    std::chrono::duration<double, std::nano>(elapsed).count() / keys.size(),
+                    stats.maxChainLength, stats.averageChainLength,
+                    static_cast<unsigned long long>(checksum));
+    }
+
+    void runAll(const char *title, const std::vector<uint64_t> &keys) {
+        std::printf("%s\n", title);
+        run<MySTL::ModuloPolicy>("modulo", keys);
+        run<MySTL::FibonacciPolicy>("fibonacci", keys);
+        run<MySTL::MixPolicy>("mix", keys);
+    }
+}
+
+int main() {
+    std::vector<uint64_t> sequential(KEY_COUNT);
+    for (size_t i = 0; i < KEY_COUNT; ++i) sequential[i] = i;
+
+    std::vector<uint64_t> strided(KEY_COUNT);
+    for (size_t i = 0; i < KEY_COUNT; ++i) strided[i] = i << 8;
+
+    std::mt19937_64 rng(42);
+    std::vector<uint64_t> random(KEY_COUNT);
+    for (auto &key: random) key = rng();
+
+    runAll("sequential keys", sequential);
+    runAll("strided keys (i << 8)", strided);
+    runAll("random keys", random);
+    return 0;
+}
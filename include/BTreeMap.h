@@ -0,0 +1,699 @@
+#ifndef MYSTL_BTREEMAP_H
+#define MYSTL_BTREEMAP_H
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+
+#include "Functional.h"
+#include "ReverseIterator.h"
+#include "Pair.h"
+
+namespace MySTL {
+
+    // Ordered map stored as a B+ tree. Each node holds up to CAPACITY keys in
+    // one contiguous array of about four cache lines, so a lookup touches one
+    // node per level, five levels for 100M keys, instead of one per key
+    // compared. Values live only in the leaves, which are linked in key order
+    // for iteration. Per entry overhead is a small share of a node header,
+    // against three pointers and a colour per key in Map.
+    //
+    // Node arrays default construct their slots, so K and V must be default
+    // constructible. Inserting or erasing shifts neighbouring entries, which
+    // invalidates iterators and value pointers into the same leaf.
+    template<typename K, typename V, typename Compare = std::less<K>>
+    class BTreeMap {
+        struct Node;
+        struct Leaf;
+        struct Inner;
+
+    public:
+        explicit BTreeMap(const Compare &comp = Compare());
+
+        BTreeMap(const BTreeMap &) = delete;
+
+        BTreeMap(BTreeMap &&other) noexcept;
+
+        BTreeMap &operator=(const BTreeMap &) = delete;
+
+        BTreeMap &operator=(BTreeMap &&other) noexcept;
+
+        ~BTreeMap() { clear(); }
+
+        [[nodiscard]] bool empty() const { return len == 0; }
+
+        [[nodiscard]] size_t size() const { return len; }
+
+        V *find(const K &key) { return findValue(key); }
+
+        const V *find(const K &key) const { return findValue(key); }
+
+        void insert(const K &key, const V &value);
+
+        void erase(const K &key);
+
+        void clear();
+
+        bool contains(const K &key) const { return findValue(key) != nullptr; }
+
+        V &at(const K &key);
+
+        // Heterogeneous lookup, enabled when Compare is transparent
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        V *find(const KeyLike &key) { return findValue(key); }
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        void erase(const KeyLike &key);
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        bool contains(const KeyLike &key) const { return findValue(key) != nullptr; }
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        V &at(const KeyLike &key);
+
+        // Bytes held by the nodes
+        [[nodiscard]] size_t memoryBytes() const { return leafCount * sizeof(Leaf) + innerCount * sizeof(Inner); }
+
+        class Iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = Pair<K, V>;
+            using difference_type = std::ptrdiff_t;
+            // Keys and values sit in separate arrays, so an entry is a pair of references
+            using reference = Pair<const K &, V &>;
+
+            struct pointer {
+                reference ref;
+
+                reference *operator->() { return &ref; }
+            };
+
+            Iterator() : tree(nullptr), leaf(nullptr), index(0) {}
+
+            Iterator(const BTreeMap *tree, Leaf *leaf, size_t index) : tree(tree), leaf(leaf), index(index) {}
+
+            reference operator*() const {
+                return reference(leaf->keys[index], leaf->values[index]);
+            }
+
+            pointer operator->() const {
+                return pointer{**this};
+            }
+
+            const K &key() const { return leaf->keys[index]; }
+
+            V &value() const { return leaf->values[index]; }
+
+            Iterator &operator++() {
+                if (++index == leaf->count) {
+                    leaf = leaf->next;
+                    index = 0;
+                }
+                return *this;
+            }
+
+            Iterator &operator--() {
+                if (leaf == nullptr) {
+                    leaf = tree->tail;
+                    index = leaf->count;
+                } else if (index == 0) {
+                    leaf = leaf->prev;
+                    index = leaf->count;
+                }
+                --index;
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const {
+                return leaf == other.leaf && index == other.index;
+            }
+
+            bool operator!=(const Iterator &other) const {
+                return !(*this == other);
+            }
+
+        private:
+            const BTreeMap *tree;
+            Leaf *leaf;
+            size_t index;
+        };
+
+        using iterator = Iterator;
+        using const_iterator = const Iterator;
+        using reverse_iterator = ReverseIterator<iterator>;
+        using reverse_const_iterator = ReverseIterator<const_iterator>;
+
+        iterator begin() {
+            return iterator(this, head, 0);
+        }
+
+        iterator end() {
+            return iterator(this, nullptr, 0);
+        }
+
+        const_iterator cbegin() const {
+            return const_iterator(this, head, 0);
+        }
+
+        const_iterator cend() const {
+            return const_iterator(this, nullptr, 0);
+        }
+
+        reverse_iterator rbegin() {
+            return reverse_iterator(end());
+        }
+
+        reverse_iterator rend() {
+            return reverse_iterator(begin());
+        }
+
+        reverse_const_iterator crbegin() const {
+            return reverse_const_iterator(cend());
+        }
+
+        reverse_const_iterator crend() const {
+            return reverse_const_iterator(cbegin());
+        }
+
+        // First entry whose key is not less than key
+        iterator lower_bound(const K &key) const;
+
+        // First entry whose key is greater than key
+        iterator upper_bound(const K &key) const;
+
+    private:
+        // Keys per node: a 256-byte key array, clamped so large keys still
+        // fan out and small ones keep the shifts on insert and erase short
+        static constexpr size_t NODE_BYTES = 256;
+        static constexpr size_t CAPACITY = std::clamp<size_t>(NODE_BYTES / sizeof(K), 8, 64);
+        // Fewest keys a node other than the root keeps after an erase
+        static constexpr size_t MIN_KEYS = (CAPACITY - 1) / 2;
+        // Arithmetic keys under the default order are searched by counting
+        static constexpr bool COUNTING_SEARCH =
+                std::is_arithmetic_v<K> && (std::is_same_v<Compare, std::less<K>> ||
+                                            std::is_same_v<Compare, std::less<>>);
+
+        struct Node {
+            bool leaf;
+            uint16_t count;
+            K keys[CAPACITY];
+        };
+
+        struct Leaf : Node {
+            V values[CAPACITY];
+            Leaf *prev;
+            Leaf *next;
+        };
+
+        // children[i] holds the keys below keys[i], and keys[i] is not
+        // greater than any key in children[i + 1]
+        struct Inner : Node {
+            Node *children[CAPACITY + 1];
+        };
+
+        // Right half of a node that split, to be linked into the parent
+        struct Split {
+            K separator;
+            Node *right = nullptr;
+        };
+
+        Node *root;
+        // First and last leaves, the ends of the leaf chain
+        Leaf *head;
+        Leaf *tail;
+        size_t len;
+        size_t leafCount;
+        size_t innerCount;
+        Compare cmp;
+
+        Leaf *newLeaf();
+
+        Inner *newInner();
+
+        void freeNode(Node *node);
+
+        // Number of keys in node ordered before key
+        template<typename KeyLike>
+        size_t lowerRank(const Node *node, const KeyLike &key) const;
+
+        // Number of keys in node not ordered after key
+        template<typename KeyLike>
+        size_t upperRank(const Node *node, const KeyLike &key) const;
+
+        // Leaf that key belongs in, nullptr when empty
+        template<typename KeyLike>
+        Leaf *findLeaf(const KeyLike &key) const;
+
+        template<typename KeyLike>
+        V *findValue(const KeyLike &key) const;
+
+        // Finds the value of key, inserting a default one when missing
+        V &findOrInsert(const K &key);
+
+        V *insertInto(Node *node, const K &key, Split &split);
+
+        V *insertAt(Leaf *leaf, size_t pos, const K &key);
+
+        void insertChild(Inner *inner, size_t pos, Split &split);
+
+        template<typename KeyLike>
+        bool eraseFrom(Node *node, const KeyLike &key);
+
+        template<typename KeyLike>
+        void eraseKey(const KeyLike &key);
+
+        // Refills parent->children[i] after it fell below MIN_KEYS
+        void rebalance(Inner *parent, size_t i);
+
+        void borrowFromLeft(Inner *parent, size_t i);
+
+        void borrowFromRight(Inner *parent, size_t i);
+
+        // Merges parent->children[i + 1] into parent->children[i]
+        void merge(Inner *parent, size_t i);
+
+        // Iterator at position pos of leaf, moving on to the next leaf past its end
+        iterator iteratorAt(Leaf *leaf, size_t pos) const;
+    };
+
+    template<typename K, typename V, typename Compare>
+    BTreeMap<K, V, Compare>::BTreeMap(const Compare &comp)
+            : root(nullptr), head(nullptr), tail(nullptr), len(0), leafCount(0), innerCount(0), cmp(comp) {}
+
+    template<typename K, typename V, typename Compare>
+    BTreeMap<K, V, Compare>::BTreeMap(BTreeMap &&other) noexcept
+            : root(other.root), head(other.head), tail(other.tail), len(other.len),
+              leafCount(other.leafCount), innerCount(other.innerCount), cmp(std::move(other.cmp)) {
+        other.root = nullptr;
+        other.head = other.tail = nullptr;
+        other.len = other.leafCount = other.innerCount = 0;
+    }
+
+    template<typename K, typename V, typename Compare>
+    BTreeMap<K, V, Compare> &BTreeMap<K, V, Compare>::operator=(BTreeMap &&other) noexcept {
+        if (this != &other) {
+            clear();
+            std::swap(root, other.root);
+            std::swap(head, other.head);
+            std::swap(tail, other.tail);
+            std::swap(len, other.len);
+            std::swap(leafCount, other.leafCount);
+            std::swap(innerCount, other.innerCount);
+            cmp = std::move(other.cmp);
+        }
+        return *this;
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::insert(const K &key, const V &value) {
+        findOrInsert(key) = value;
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::erase(const K &key) {
+        eraseKey(key);
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::clear() {
+        freeNode(root);
+        root = nullptr;
+        head = tail = nullptr;
+        len = 0;
+    }
+
+    template<typename K, typename V, typename Compare>
+    V &BTreeMap<K, V, Compare>::at(const K &key) {
+        return findOrInsert(key);
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    requires Transparent<Compare>
+    void BTreeMap<K, V, Compare>::erase(const KeyLike &key) {
+        eraseKey(key);
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    requires Transparent<Compare>
+    V &BTreeMap<K, V, Compare>::at(const KeyLike &key) {
+        if (auto value = findValue(key)) return *value;
+        // Only a miss pays for building the owning key
+        return findOrInsert(K(key));
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename BTreeMap<K, V, Compare>::iterator BTreeMap<K, V, Compare>::lower_bound(const K &key) const {
+        auto leaf = findLeaf(key);
+        return leaf ? iteratorAt(leaf, lowerRank(leaf, key)) : iterator(this, nullptr, 0);
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename BTreeMap<K, V, Compare>::iterator BTreeMap<K, V, Compare>::upper_bound(const K &key) const {
+        auto leaf = findLeaf(key);
+        return leaf ? iteratorAt(leaf, upperRank(leaf, key)) : iterator(this, nullptr, 0);
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename BTreeMap<K, V, Compare>::Leaf *BTreeMap<K, V, Compare>::newLeaf() {
+        // Value initialized, so the unused key slots the counting search
+        // reads hold defined values
+        auto leaf = new Leaf();
+        leaf->leaf = true;
+        leaf->count = 0;
+        leaf->prev = leaf->next = nullptr;
+        ++leafCount;
+        return leaf;
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename BTreeMap<K, V, Compare>::Inner *BTreeMap<K, V, Compare>::newInner() {
+        auto inner = new Inner();
+        inner->leaf = false;
+        inner->count = 0;
+        ++innerCount;
+        return inner;
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::freeNode(Node *node) {
+        if (node == nullptr) return;
+        if (node->leaf) {
+            delete static_cast<Leaf *>(node);
+            --leafCount;
+            return;
+        }
+        auto inner = static_cast<Inner *>(node);
+        for (size_t i = 0; i <= inner->count; ++i) freeNode(inner->children[i]);
+        delete inner;
+        --innerCount;
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    size_t BTreeMap<K, V, Compare>::lowerRank(const Node *node, const KeyLike &key) const {
+        if constexpr (COUNTING_SEARCH && std::is_same_v<KeyLike, K>) {
+            // Branch-free count over the whole array; the fixed trip count
+            // lets the compiler turn it into a few SIMD compares
+            uint32_t count = node->count, rank = 0;
+            for (uint32_t i = 0; i < CAPACITY; ++i) rank += (i < count) & (node->keys[i] < key);
+            return rank;
+        } else {
+            size_t lo = 0, hi = node->count;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (cmp(node->keys[mid], key))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    size_t BTreeMap<K, V, Compare>::upperRank(const Node *node, const KeyLike &key) const {
+        if constexpr (COUNTING_SEARCH && std::is_same_v<KeyLike, K>) {
+            uint32_t count = node->count, rank = 0;
+            for (uint32_t i = 0; i < CAPACITY; ++i) rank += (i < count) & !(key < node->keys[i]);
+            return rank;
+        } else {
+            size_t lo = 0, hi = node->count;
+            while (lo < hi) {
+                size_t mid = (lo + hi) / 2;
+                if (!cmp(key, node->keys[mid]))
+                    lo = mid + 1;
+                else
+                    hi = mid;
+            }
+            return lo;
+        }
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    typename BTreeMap<K, V, Compare>::Leaf *BTreeMap<K, V, Compare>::findLeaf(const KeyLike &key) const {
+        auto node = root;
+        if (node == nullptr) return nullptr;
+        while (!node->leaf) {
+            auto inner = static_cast<Inner *>(node);
+            node = inner->children[upperRank(inner, key)];
+        }
+        return static_cast<Leaf *>(node);
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    V *BTreeMap<K, V, Compare>::findValue(const KeyLike &key) const {
+        auto leaf = findLeaf(key);
+        if (leaf == nullptr) return nullptr;
+        size_t pos = lowerRank(leaf, key);
+        if (pos < leaf->count && !cmp(key, leaf->keys[pos])) return &leaf->values[pos];
+        return nullptr;
+    }
+
+    template<typename K, typename V, typename Compare>
+    V &BTreeMap<K, V, Compare>::findOrInsert(const K &key) {
+        if (root == nullptr) root = head = tail = newLeaf();
+        Split split;
+        auto value = insertInto(root, key, split);
+        if (split.right != nullptr) {
+            auto top = newInner();
+            top->count = 1;
+            top->keys[0] = std::move(split.separator);
+            top->children[0] = root;
+            top->children[1] = split.right;
+            root = top;
+        }
+        return *value;
+    }
+
+    template<typename K, typename V, typename Compare>
+    V *BTreeMap<K, V, Compare>::insertInto(Node *node, const K &key, Split &split) {
+        if (node->leaf) {
+            auto leaf = static_cast<Leaf *>(node);
+            size_t pos = lowerRank(leaf, key);
+            if (pos < leaf->count && !cmp(key, leaf->keys[pos])) return &leaf->values[pos];
+            ++len;
+            if (leaf->count < CAPACITY) return insertAt(leaf, pos, key);
+
+            auto right = newLeaf();
+            // Appending past the end, as ascending loads do, leaves this leaf
+            // full instead of half empty; otherwise split down the middle
+            size_t keep = pos == CAPACITY ? CAPACITY : CAPACITY / 2;
+            std::move(leaf->keys + keep, leaf->keys + CAPACITY, right->keys);
+            std::move(leaf->values + keep, leaf->values + CAPACITY, right->values);
+            right->count = CAPACITY - keep;
+            leaf->count = keep;
+            right->prev = leaf;
+            right->next = leaf->next;
+            if (leaf->next != nullptr)
+                leaf->next->prev = right;
+            else
+                tail = right;
+            leaf->next = right;
+
+            auto value = pos < keep ? insertAt(leaf, pos, key) : insertAt(right, pos - keep, key);
+            split.separator = right->keys[0];
+            split.right = right;
+            return value;
+        }
+
+        auto inner = static_cast<Inner *>(node);
+        size_t i = upperRank(inner, key);
+        Split below;
+        auto value = insertInto(inner->children[i], key, below);
+        if (below.right == nullptr) return value;
+        if (inner->count < CAPACITY) {
+            insertChild(inner, i, below);
+            return value;
+        }
+
+        // Full: the upper half moves to a new sibling and the middle key goes up
+        auto right = newInner();
+        size_t mid = CAPACITY / 2;
+        std::move(inner->keys + mid + 1, inner->keys + CAPACITY, right->keys);
+        std::copy(inner->children + mid + 1, inner->children + CAPACITY + 1, right->children);
+        right->count = CAPACITY - mid - 1;
+        inner->count = mid;
+        split.separator = std::move(inner->keys[mid]);
+        split.right = right;
+        if (i <= mid)
+            insertChild(inner, i, below);
+        else
+            insertChild(right, i - mid - 1, below);
+        return value;
+    }
+
+    template<typename K, typename V, typename Compare>
+    V *BTreeMap<K, V, Compare>::insertAt(Leaf *leaf, size_t pos, const K &key) {
+        std::move_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+        std::move_backward(leaf->values + pos, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+        leaf->keys[pos] = key;
+        leaf->values[pos] = V();
+        ++leaf->count;
+        return &leaf->values[pos];
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::insertChild(Inner *inner, size_t pos, Split &split) {
+        std::move_backward(inner->keys + pos, inner->keys + inner->count, inner->keys + inner->count + 1);
+        std::copy_backward(inner->children + pos + 1, inner->children + inner->count + 1,
+                           inner->children + inner->count + 2);
+        inner->keys[pos] = std::move(split.separator);
+        inner->children[pos + 1] = split.right;
+        ++inner->count;
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    bool BTreeMap<K, V, Compare>::eraseFrom(Node *node, const KeyLike &key) {
+        if (node->leaf) {
+            auto leaf = static_cast<Leaf *>(node);
+            size_t pos = lowerRank(leaf, key);
+            if (pos == leaf->count || cmp(key, leaf->keys[pos])) return false;
+            std::move(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+            std::move(leaf->values + pos + 1, leaf->values + leaf->count, leaf->values + pos);
+            --leaf->count;
+            // Release whatever the vacated slot still owns
+            leaf->keys[leaf->count] = K();
+            leaf->values[leaf->count] = V();
+            --len;
+            return true;
+        }
+        auto inner = static_cast<Inner *>(node);
+        size_t i = upperRank(inner, key);
+        if (!eraseFrom(inner->children[i], key)) return false;
+        if (inner->children[i]->count < MIN_KEYS) rebalance(inner, i);
+        return true;
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename KeyLike>
+    void BTreeMap<K, V, Compare>::eraseKey(const KeyLike &key) {
+        if (root == nullptr || !eraseFrom(root, key) || root->count > 0) return;
+        if (root->leaf) {
+            freeNode(root);
+            root = nullptr;
+            head = tail = nullptr;
+        } else {
+            // The root lost its last separator, its only child takes over
+            auto old = static_cast<Inner *>(root);
+            root = old->children[0];
+            delete old;
+            --innerCount;
+        }
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::rebalance(Inner *parent, size_t i) {
+        if (i > 0 && parent->children[i - 1]->count > MIN_KEYS)
+            borrowFromLeft(parent, i);
+        else if (i < parent->count && parent->children[i + 1]->count > MIN_KEYS)
+            borrowFromRight(parent, i);
+        else if (i > 0)
+            merge(parent, i - 1);
+        else
+            merge(parent, i);
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::borrowFromLeft(Inner *parent, size_t i) {
+        auto node = parent->children[i];
+        auto sibling = parent->children[i - 1];
+        std::move_backward(node->keys, node->keys + node->count, node->keys + node->count + 1);
+        if (node->leaf) {
+            auto leaf = static_cast<Leaf *>(node);
+            auto left = static_cast<Leaf *>(sibling);
+            std::move_backward(leaf->values, leaf->values + leaf->count, leaf->values + leaf->count + 1);
+            leaf->keys[0] = std::move(left->keys[left->count - 1]);
+            leaf->values[0] = std::move(left->values[left->count - 1]);
+            parent->keys[i - 1] = leaf->keys[0];
+        } else {
+            auto inner = static_cast<Inner *>(node);
+            auto left = static_cast<Inner *>(sibling);
+            std::copy_backward(inner->children, inner->children + inner->count + 1,
+                               inner->children + inner->count + 2);
+            inner->keys[0] = std::move(parent->keys[i - 1]);
+            inner->children[0] = left->children[left->count];
+            parent->keys[i - 1] = std::move(left->keys[left->count - 1]);
+        }
+        --sibling->count;
+        ++node->count;
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::borrowFromRight(Inner *parent, size_t i) {
+        auto node = parent->children[i];
+        auto sibling = parent->children[i + 1];
+        if (node->leaf) {
+            auto leaf = static_cast<Leaf *>(node);
+            auto right = static_cast<Leaf *>(sibling);
+            leaf->keys[leaf->count] = std::move(right->keys[0]);
+            leaf->values[leaf->count] = std::move(right->values[0]);
+            std::move(right->values + 1, right->values + right->count, right->values);
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            parent->keys[i] = right->keys[0];
+        } else {
+            auto inner = static_cast<Inner *>(node);
+            auto right = static_cast<Inner *>(sibling);
+            inner->keys[inner->count] = std::move(parent->keys[i]);
+            inner->children[inner->count + 1] = right->children[0];
+            parent->keys[i] = std::move(right->keys[0]);
+            std::move(right->keys + 1, right->keys + right->count, right->keys);
+            std::copy(right->children + 1, right->children + right->count + 1, right->children);
+        }
+        --sibling->count;
+        ++node->count;
+    }
+
+    template<typename K, typename V, typename Compare>
+    void BTreeMap<K, V, Compare>::merge(Inner *parent, size_t i) {
+        auto node = parent->children[i];
+        auto sibling = parent->children[i + 1];
+        if (node->leaf) {
+            auto leaf = static_cast<Leaf *>(node);
+            auto right = static_cast<Leaf *>(sibling);
+            std::move(right->keys, right->keys + right->count, leaf->keys + leaf->count);
+            std::move(right->values, right->values + right->count, leaf->values + leaf->count);
+            leaf->count += right->count;
+            leaf->next = right->next;
+            if (right->next != nullptr)
+                right->next->prev = leaf;
+            else
+                tail = leaf;
+            delete right;
+            --leafCount;
+        } else {
+            // The separator comes down between the two halves
+            auto inner = static_cast<Inner *>(node);
+            auto right = static_cast<Inner *>(sibling);
+            inner->keys[inner->count] = std::move(parent->keys[i]);
+            std::move(right->keys, right->keys + right->count, inner->keys + inner->count + 1);
+            std::copy(right->children, right->children + right->count + 1, inner->children + inner->count + 1);
+            inner->count += right->count + 1;
+            delete right;
+            --innerCount;
+        }
+        std::move(parent->keys + i + 1, parent->keys + parent->count, parent->keys + i);
+        std::copy(parent->children + i + 2, parent->children + parent->count + 1, parent->children + i + 1);
+        --parent->count;
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename BTreeMap<K, V, Compare>::iterator BTreeMap<K, V, Compare>::iteratorAt(Leaf *leaf, size_t pos) const {
+        if (pos == leaf->count) return iterator(this, leaf->next, 0);
+        return iterator(this, leaf, pos);
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_BTREEMAP_H
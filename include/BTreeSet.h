@@ -0,0 +1,95 @@
+#ifndef MYSTL_BTREESET_H
+#define MYSTL_BTREESET_H
+
+#include "BTreeMap.h"
+
+namespace MySTL {
+    template<typename T, typename Compare = std::less<T> >
+    class BTreeSet {
+        using MapType = BTreeMap<T, bool, Compare>;
+
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T *;
+            using reference = const T &;
+
+            Iterator() = default;
+
+            explicit Iterator(typename MapType::iterator it) : it(it) {}
+
+            reference operator*() const { return it.key(); }
+
+            pointer operator->() const { return &it.key(); }
+
+            Iterator &operator++() {
+                ++it;
+                return *this;
+            }
+
+            Iterator &operator--() {
+                --it;
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const { return it == other.it; }
+
+            bool operator!=(const Iterator &other) const { return it != other.it; }
+
+        private:
+            typename MapType::iterator it;
+        };
+
+        using iterator = Iterator;
+        using const_iterator = const Iterator;
+        using reverse_iterator = ReverseIterator<iterator>;
+        using reverse_const_iterator = ReverseIterator<const_iterator>;
+
+        explicit BTreeSet(const Compare &comp = Compare()) : map(comp) {}
+
+        [[nodiscard]] bool empty() const { return map.empty(); }
+
+        [[nodiscard]] size_t size() const { return map.size(); }
+
+        void insert(const T &t) { map.insert(t, true); }
+
+        void erase(const T &t) { map.erase(t); }
+
+        bool contains(const T &t) const { return map.contains(t); }
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        void erase(const KeyLike &key) { map.erase(key); }
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        bool contains(const KeyLike &key) const { return map.contains(key); }
+
+        void clear() { map.clear(); }
+
+        [[nodiscard]] size_t memoryBytes() const { return map.memoryBytes(); }
+
+        iterator begin() const { return iterator(map.cbegin()); }
+
+        iterator end() const { return iterator(map.cend()); }
+
+        reverse_iterator rbegin() const { return reverse_iterator(end()); }
+
+        reverse_iterator rend() const { return reverse_iterator(begin()); }
+
+        // First element not less than t
+        iterator lower_bound(const T &t) const { return iterator(map.lower_bound(t)); }
+
+        // First element greater than t
+        iterator upper_bound(const T &t) const { return iterator(map.upper_bound(t)); }
+
+    private:
+        MapType map;
+    };
+
+}  // namespace MySTL
+
+#endif  // MYSTL_BTREESET_H
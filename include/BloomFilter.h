@@ -0,0 +1,102 @@
+#ifndef MYSTL_BLOOMFILTER_H
+#define MYSTL_BLOOMFILTER_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+
+#include "utils/FrontFilter.h"
+
+#include "Vector.h"
+
+namespace MySTL {
+
+    // Blocked Bloom filter: a key touches a single 64-byte block, one cache
+    // line, and sets one bit in each of its eight 64-bit words. The eight bit
+    // positions come from multiplying the low hash bits by fixed odd salts,
+    // so a probe is eight independent multiply/shift/test lanes that the
+    // compiler vectorizes, with no data-dependent branches.
+    //
+    // Bits cannot be cleared, so remove is a no-op; stale bits only raise the
+    // false positive rate until the next reset.
+    class BloomFilter {
+    public:
+        static constexpr bool enabled = true;
+
+        explicit BloomFilter(size_t expectedItems = 0, double falsePositiveRate = 0.01);
+
+        // Clears the filter and sizes it for expectedItems
+        void reset(size_t expectedItems);
+
+        void add(size_t hash);
+
+        void remove(size_t) {}
+
+        [[nodiscard]] bool mayContain(size_t hash) const;
+
+        [[nodiscard]] size_t memoryBytes() const { return blockCount * sizeof(Block); }
+
+    private:
+        static constexpr size_t WORDS = 8;
+
+        struct alignas(64) Block {
+            uint64_t words[WORDS];
+        };
+
+        Vector<Block> blocks;
+        size_t blockCount;
+        double falsePositiveRate;
+
+        [[nodiscard]] size_t blockIndex(uint64_t h) const;
+
+        static void makeMask(uint32_t key, uint64_t (&mask)[WORDS]);
+    };
+
+    inline BloomFilter::BloomFilter(size_t expectedItems, double falsePositiveRate)
+            : blocks(1), blockCount(1), falsePositiveRate(falsePositiveRate) {
+        reset(expectedItems);
+    }
+
+    inline void BloomFilter::reset(size_t expectedItems) {
+        // Optimal bits per key for a classic filter, plus a fifth to make up
+        // for blocks filling unevenly
+        double bitsPerKey = -std::log(falsePositiveRate) / (std::log(2.0) * std::log(2.0)) * 1.2;
+        auto bits = static_cast<size_t>(std::ceil(bitsPerKey * static_cast<double>(expectedItems)));
+        size_t count = std::max<size_t>(1, (bits + 8 * sizeof(Block) - 1) / (8 * sizeof(Block)));
+        blocks = Vector<Block>(count, Block{});
+        blockCount = count;
+    }
+
+    inline void BloomFilter::makeMask(uint32_t key, uint64_t (&mask)[WORDS]) {
+        static constexpr uint32_t SALT[WORDS] = {
+                0x47B6137Bu, 0x44974D91u, 0x8824AD5Bu, 0xA2B7289Du,
+                0x705495C7u, 0x2DF1424Bu, 0x9EFC4947u, 0x5C6BFB31u};
+        for (size_t i = 0; i < WORDS; ++i)
+            mask[i] = uint64_t(1) << ((key * SALT[i]) >> 26);
+    }
+
+    inline size_t BloomFilter::blockIndex(uint64_t h) const {
+        // Block from the high half by multiply-shift, bits from the low half
+        return static_cast<size_t>(((h >> 32) * blockCount) >> 32);
+    }
+
+    inline void BloomFilter::add(size_t hash) {
+        uint64_t h = mixFilterHash(hash);
+        uint64_t mask[WORDS];
+        makeMask(static_cast<uint32_t>(h), mask);
+        auto &block = blocks[blockIndex(h)];
+        for (size_t i = 0; i < WORDS; ++i) block.words[i] |= mask[i];
+    }
+
+    inline bool BloomFilter::mayContain(size_t hash) const {
+        uint64_t h = mixFilterHash(hash);
+        uint64_t mask[WORDS];
+        makeMask(static_cast<uint32_t>(h), mask);
+        auto &block = blocks[blockIndex(h)];
+        uint64_t missing = 0;
+        for (size_t i = 0; i < WORDS; ++i) missing |= mask[i] & ~block.words[i];
+        return missing == 0;
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_BLOOMFILTER_H
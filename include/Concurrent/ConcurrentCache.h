@@ -0,0 +1,187 @@
+#ifndef MYSTL_CONCURRENTCACHE_H
+#define MYSTL_CONCURRENTCACHE_H
+
+#include "../LfuCache.h"
+#include "../LruCache.h"
+
+#include <algorithm>
+#include <bit>
+#include <limits>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+
+namespace MySTL {
+
+    // Thread-safe cache split into up to SHARD_COUNT independent caches, each
+    // behind its own mutex. The limits are split exactly, the first shards
+    // taking the remainder, so the whole cache never exceeds them. Small
+    // limits use fewer shards (a power of two), so that every shard holds at
+    // least one entry and a share of maxCost no smaller than maxItemCost:
+    // any entry costing up to maxItemCost is always accepted. Keys are routed
+    // as in ConcurrentHashMap, so eviction order is per shard: the entry
+    // evicted is the shard's least recently (or frequently) used one.
+    template<typename Cache, size_t SHARD_COUNT = 16>
+    class ConcurrentCache {
+        using K = typename Cache::key_type;
+        using V = typename Cache::mapped_type;
+        using Hash = typename Cache::hasher;
+
+    public:
+        // Throws std::invalid_argument when maxItemCost is 0 or exceeds maxCost
+        explicit ConcurrentCache(size_t maxEntries, size_t maxCost = std::numeric_limits<size_t>::max(),
+                                 size_t maxItemCost = 1);
+
+        // Number of shards in use
+        [[nodiscard]] size_t shardCount() const { return activeShards; }
+
+        // Copies the value out, the entry may be evicted once the lock drops
+        std::optional<V> get(const K &key);
+
+        // Calls f(value) under the shard lock on a hit, avoiding the copy
+        template<typename F>
+        bool visit(const K &key, F &&f);
+
+        bool put(const K &key, V value, size_t cost = 1);
+
+        bool erase(const K &key);
+
+        bool contains(const K &key) const;
+
+        size_t size() const;
+
+        bool empty() const;
+
+        size_t totalCost() const;
+
+        void clear();
+
+        // The callback runs under the lock of the evicting shard
+        void setEvictionCallback(typename Cache::EvictionCallback callback);
+
+    private:
+        struct Shard {
+            Cache cache_{0};
+            mutable std::mutex mutex_;
+        };
+
+        Shard shards[SHARD_COUNT];
+        // Keys route to the first activeShards shards only
+        size_t activeShards;
+        Hash hasher;
+
+        size_t shardOf(const K &key) const;
+    };
+
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    using ConcurrentLruCache = ConcurrentCache<LruCache<K, V, Hash, Equal>>;
+
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    using ConcurrentLfuCache = ConcurrentCache<LfuCache<K, V, Hash, Equal>>;
+
+    template<typename Cache, size_t SHARD_COUNT>
+    ConcurrentCache<Cache, SHARD_COUNT>::ConcurrentCache(size_t maxEntries, size_t maxCost, size_t maxItemCost) {
+        if (maxItemCost == 0 || maxItemCost > maxCost)
+            throw std::invalid_argument("maxItemCost must be in [1, maxCost]");
+        bool unlimited = maxCost == std::numeric_limits<size_t>::max();
+        size_t limit = std::min({SHARD_COUNT, maxEntries, unlimited ? SHARD_COUNT : maxCost / maxItemCost});
+        activeShards = std::bit_floor(std::max<size_t>(limit, 1));
+        for (size_t i = 0; i < activeShards; ++i) {
+            size_t entries = maxEntries / activeShards + (i < maxEntries % activeShards);
+            size_t cost = unlimited ? maxCost : maxCost / activeShards + (i < maxCost % activeShards);
+            shards[i].cache_ = Cache(entries, cost);
+        }
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    size_t ConcurrentCache<Cache, SHARD_COUNT>::shardOf(const K &key) const {
+        return MixPolicy::index(hasher(key), activeShards);
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    std::optional<typename ConcurrentCache<Cache, SHARD_COUNT>::V>
+    ConcurrentCache<Cache, SHARD_COUNT>::get(const K &key) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        auto value = shard.cache_.get(key);
+        if (value == nullptr) return std::nullopt;
+        return *value;
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    template<typename F>
+    bool ConcurrentCache<Cache, SHARD_COUNT>::visit(const K &key, F &&f) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        auto value = shard.cache_.get(key);
+        if (value == nullptr) return false;
+        f(*value);
+        return true;
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    bool ConcurrentCache<Cache, SHARD_COUNT>::put(const K &key, V value, size_t cost) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.cache_.put(key, std::move(value), cost);
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    bool ConcurrentCache<Cache, SHARD_COUNT>::erase(const K &key) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.cache_.erase(key);
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    bool ConcurrentCache<Cache, SHARD_COUNT>::contains(const K &key) const {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.cache_.contains(key);
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    size_t ConcurrentCache<Cache, SHARD_COUNT>::size() const {
+        size_t total = 0;
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            total += shard.cache_.size();
+        }
+        return total;
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    bool ConcurrentCache<Cache, SHARD_COUNT>::empty() const {
+        return size() == 0;
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    size_t ConcurrentCache<Cache, SHARD_COUNT>::totalCost() const {
+        size_t total = 0;
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            total += shard.cache_.totalCost();
+        }
+        return total;
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    void ConcurrentCache<Cache, SHARD_COUNT>::clear() {
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            shard.cache_.clear();
+        }
+    }
+
+    template<typename Cache, size_t SHARD_COUNT>
+    void ConcurrentCache<Cache, SHARD_COUNT>::setEvictionCallback(typename Cache::EvictionCallback callback) {
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            shard.cache_.setEvictionCallback(callback);
+        }
+    }
+
+}
+
+
+#endif //MYSTL_CONCURRENTCACHE_H
@@ -7,7 +7,11 @@
 
 namespace MySTL {
 
-    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    // The table is split into SHARD_COUNT independent HashMaps, each behind its
+    // own mutex. A key's shard comes from MixPolicy on the low hash bits, which
+    // stays independent of the bucket bits the shard's own Policy uses.
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>,
+            typename Policy = FibonacciPolicy>
     class ConcurrentHashMap {
     public:
         explicit ConcurrentHashMap(size_t initCap = 16, double loadFactor = 0.75);
@@ -30,74 +34,116 @@ namespace MySTL {
 
         void clear();
 
+        HashTableStats stats() const;
+
+        HashTableStats snapshot() const;
+
     private:
-        HashMap<K, V, Hash, Equal> map_;
-        mutable std::mutex mutex_;
-        mutable Vector<std::mutex> mutexes;
+        static constexpr size_t SHARD_COUNT = 16;
+
+        struct Shard {
+            HashMap<K, V, Hash, Equal, Policy> map_;
+            mutable std::mutex mutex_;
+        };
+
+        Shard shards[SHARD_COUNT];
+        Hash hasher;
+
+        size_t shardOf(const K &key) const;
     };
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    ConcurrentHashMap<K, V, Hash, Equal>::ConcurrentHashMap(size_t initCap, double loadFactor)
-            : map_(initCap, loadFactor), mutexes(initCap) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    ConcurrentHashMap<K, V, Hash, Equal, Policy>::ConcurrentHashMap(size_t initCap, double loadFactor) {
+        for (auto &shard: shards)
+            shard.map_ = HashMap<K, V, Hash, Equal, Policy>(initCap / SHARD_COUNT, loadFactor);
+    }
 
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    size_t ConcurrentHashMap<K, V, Hash, Equal, Policy>::shardOf(const K &key) const {
+        return MixPolicy::index(hasher(key), SHARD_COUNT);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void ConcurrentHashMap<K, V, Hash, Equal>::insert(const K &k, const V &v) {
-        size_t index = map_.getHasher()(k) % map_.getCap();
-        std::lock_guard<std::mutex> lock(mutexes[index]);
-        map_.insert(k, v);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void ConcurrentHashMap<K, V, Hash, Equal, Policy>::insert(const K &k, const V &v) {
+        auto &shard = shards[shardOf(k)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.map_.insert(k, v);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void ConcurrentHashMap<K, V, Hash, Equal>::erase(const K &key) {
-        size_t index = map_.getHasher()(key) % map_.getCap();
-        std::lock_guard<std::mutex> lock(mutexes[index]);
-        map_.erase(key);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void ConcurrentHashMap<K, V, Hash, Equal, Policy>::erase(const K &key) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        shard.map_.erase(key);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    V *ConcurrentHashMap<K, V, Hash, Equal>::find(const K &key) {
-        size_t index = map_.getHasher()(key) % map_.getCap();
-        std::lock_guard<std::mutex> lock(mutexes[index]);
-        return map_.find(key);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    V *ConcurrentHashMap<K, V, Hash, Equal, Policy>::find(const K &key) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.map_.find(key);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    V &ConcurrentHashMap<K, V, Hash, Equal>::at(const K &key) {
-        size_t index = map_.getHasher()(key) % map_.getCap();
-        std::lock_guard<std::mutex> lock(mutexes[index]);
-        return map_.at(key);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    V &ConcurrentHashMap<K, V, Hash, Equal, Policy>::at(const K &key) {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.map_.at(key);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    V &ConcurrentHashMap<K, V, Hash, Equal>::operator[](const K &key) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    V &ConcurrentHashMap<K, V, Hash, Equal, Policy>::operator[](const K &key) {
         return at(key);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    bool ConcurrentHashMap<K, V, Hash, Equal>::contains(const K &key) const {
-        size_t index = map_.getHasher()(key) % map_.getCap();
-        std::lock_guard<std::mutex> lock(mutexes[index]);
-        return map_.contains(key);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    bool ConcurrentHashMap<K, V, Hash, Equal, Policy>::contains(const K &key) const {
+        auto &shard = shards[shardOf(key)];
+        std::lock_guard<std::mutex> lock(shard.mutex_);
+        return shard.map_.contains(key);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    size_t ConcurrentHashMap<K, V, Hash, Equal, Policy>::size() const {
+        size_t total = 0;
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            total += shard.map_.size();
+        }
+        return total;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    bool ConcurrentHashMap<K, V, Hash, Equal, Policy>::empty() const {
+        return size() == 0;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    size_t ConcurrentHashMap<K, V, Hash, Equal>::size() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return map_.size();
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void ConcurrentHashMap<K, V, Hash, Equal, Policy>::clear() {
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            shard.map_.clear();
+        }
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    bool ConcurrentHashMap<K, V, Hash, Equal>::empty() const {
-        std::lock_guard<std::mutex> lock(mutex_);
-        return map_.empty();
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    HashTableStats ConcurrentHashMap<K, V, Hash, Equal, Policy>::stats() const {
+        HashTableStats total;
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            total.merge(shard.map_.stats());
+        }
+        return total;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void ConcurrentHashMap<K, V, Hash, Equal>::clear() {
-        std::lock_guard<std::mutex> lock(mutex_);
-        map_.clear();
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    HashTableStats ConcurrentHashMap<K, V, Hash, Equal, Policy>::snapshot() const {
+        HashTableStats total;
+        for (auto &shard: shards) {
+            std::lock_guard<std::mutex> lock(shard.mutex_);
+            total.merge(shard.map_.snapshot());
+        }
+        return total;
     }
 
 }
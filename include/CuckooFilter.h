@@ -0,0 +1,151 @@
+#ifndef MYSTL_CUCKOOFILTER_H
+#define MYSTL_CUCKOOFILTER_H
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <initializer_list>
+#include <utility>
+
+#include "utils/FrontFilter.h"
+
+#include "Vector.h"
+
+namespace MySTL {
+
+    // Cuckoo filter with 16-bit fingerprints in buckets of four. A key may
+    // sit in bucket i1 = hash & mask or i2 = i1 ^ mix(fingerprint), so a
+    // probe compares eight fingerprints in two 8-byte buckets. Unlike a
+    // Bloom filter it supports remove, which suits maps with heavy churn.
+    //
+    // When an insert still finds no room after MAX_KICKS relocations a
+    // fingerprint is lost, so the filter turns saturated and answers maybe
+    // for every key until the next reset.
+    class CuckooFilter {
+    public:
+        static constexpr bool enabled = true;
+
+        explicit CuckooFilter(size_t expectedItems = 0);
+
+        // Clears the filter and sizes it for expectedItems
+        void reset(size_t expectedItems);
+
+        void add(size_t hash);
+
+        // hash must have been added, otherwise another key's fingerprint
+        // may be dropped
+        void remove(size_t hash);
+
+        [[nodiscard]] bool mayContain(size_t hash) const;
+
+        [[nodiscard]] bool saturated() const { return overflowed; }
+
+        [[nodiscard]] size_t memoryBytes() const { return (mask + 1) * sizeof(Bucket); }
+
+    private:
+        static constexpr size_t SLOTS = 4;
+        static constexpr size_t MAX_KICKS = 500;
+        // Buckets are sized to stay below this fill
+        static constexpr double MAX_LOAD = 0.9;
+
+        struct Bucket {
+            uint16_t fingerprints[SLOTS];
+        };
+
+        Vector<Bucket> buckets;
+        size_t mask;
+        bool overflowed;
+        uint32_t kickState;
+
+        [[nodiscard]] static uint16_t fingerprintOf(uint64_t h);
+
+        [[nodiscard]] size_t altIndex(size_t index, uint16_t fingerprint) const;
+
+        [[nodiscard]] static bool holds(const Bucket &bucket, uint16_t fingerprint);
+
+        static bool place(Bucket &bucket, uint16_t fingerprint);
+    };
+
+    inline CuckooFilter::CuckooFilter(size_t expectedItems)
+            : buckets(1), mask(0), overflowed(false), kickState(0) {
+        reset(expectedItems);
+    }
+
+    inline void CuckooFilter::reset(size_t expectedItems) {
+        auto needed = static_cast<size_t>(static_cast<double>(expectedItems) / (SLOTS * MAX_LOAD)) + 1;
+        size_t count = std::bit_ceil(std::max<size_t>(needed, 2));
+        buckets = Vector<Bucket>(count, Bucket{});
+        mask = count - 1;
+        overflowed = false;
+    }
+
+    inline uint16_t CuckooFilter::fingerprintOf(uint64_t h) {
+        // 0 marks an empty slot
+        auto fingerprint = static_cast<uint16_t>(h >> 48);
+        return fingerprint ? fingerprint : 1;
+    }
+
+    inline size_t CuckooFilter::altIndex(size_t index, uint16_t fingerprint) const {
+        return (index ^ static_cast<size_t>(mixFilterHash(fingerprint))) & mask;
+    }
+
+    inline bool CuckooFilter::holds(const Bucket &bucket, uint16_t fingerprint) {
+        bool found = false;
+        for (size_t i = 0; i < SLOTS; ++i) found |= bucket.fingerprints[i] == fingerprint;
+        return found;
+    }
+
+    inline bool CuckooFilter::place(Bucket &bucket, uint16_t fingerprint) {
+        for (auto &slot: bucket.fingerprints) {
+            if (slot == 0) {
+                slot = fingerprint;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline void CuckooFilter::add(size_t hash) {
+        if (overflowed) return;
+        uint64_t h = mixFilterHash(hash);
+        uint16_t fingerprint = fingerprintOf(h);
+        size_t index = h & mask;
+        if (place(buckets[index], fingerprint)) return;
+        index = altIndex(index, fingerprint);
+        if (place(buckets[index], fingerprint)) return;
+        for (size_t kick = 0; kick < MAX_KICKS; ++kick) {
+            // Evict a pseudo-random resident and move it to its other bucket
+            kickState = kickState * 1664525u + 1013904223u;
+            auto &slot = buckets[index].fingerprints[(kickState >> 16) % SLOTS];
+            std::swap(slot, fingerprint);
+            index = altIndex(index, fingerprint);
+            if (place(buckets[index], fingerprint)) return;
+        }
+        overflowed = true;
+    }
+
+    inline void CuckooFilter::remove(size_t hash) {
+        if (overflowed) return;
+        uint64_t h = mixFilterHash(hash);
+        uint16_t fingerprint = fingerprintOf(h);
+        size_t first = h & mask;
+        for (size_t index: {first, altIndex(first, fingerprint)}) {
+            for (auto &slot: buckets[index].fingerprints) {
+                if (slot == fingerprint) {
+                    slot = 0;
+                    return;
+                }
+            }
+        }
+    }
+
+    inline bool CuckooFilter::mayContain(size_t hash) const {
+        if (overflowed) return true;
+        uint64_t h = mixFilterHash(hash);
+        uint16_t fingerprint = fingerprintOf(h);
+        size_t first = h & mask;
+        return holds(buckets[first], fingerprint) | holds(buckets[altIndex(first, fingerprint)], fingerprint);
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_CUCKOOFILTER_H
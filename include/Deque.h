@@ -2,30 +2,34 @@
 #define MYSTL_DEQUE_H
 
 #include <algorithm>
+#include <bit>
 #include <cstddef>
 #include <cstring>
+#include <memory>
 #include <stdexcept>
 
 #include "ReverseIterator.h"
 
 namespace MySTL {
 
+    // Double-ended queue over fixed-size blocks of uninitialized storage,
+    // reached through a map of block pointers that keeps free slots at both
+    // ends. Elements never move when either end grows, and a block is only
+    // allocated when an end crosses into it.
+    //
+    // Blocks hold about BLOCK_BYTES of elements, rounded down to a power of
+    // two so indexing is a shift and a mask. Blocks emptied by pops go to a
+    // small spare cache first, so a queue cycling through push_back and
+    // pop_front reaches a steady state without allocating.
     template<typename T>
     class Deque final {
-        static constexpr int ELEMENTS_PER_BLOCK = 16;
-
-        struct Block {
-            T *elements;
-            Block *prev;
-            Block *next;
-
-            Block()
-                    : elements(new T[ELEMENTS_PER_BLOCK]),
-                      prev(nullptr),
-                      next(nullptr) {}
-
-            ~Block() { delete[] elements; }
-        };
+        static constexpr size_t BLOCK_BYTES = 4096;
+        // Large elements still get a few per block
+        static constexpr size_t MIN_ELEMENTS_PER_BLOCK = 4;
+        static constexpr size_t ELEMENTS_PER_BLOCK =
+                std::bit_floor(std::max(BLOCK_BYTES / sizeof(T), MIN_ELEMENTS_PER_BLOCK));
+        static constexpr size_t MIN_MAP_SIZE = 8;
+        static constexpr size_t SPARE_BLOCKS = 2;
 
     public:
         class Iterator {
@@ -36,88 +40,70 @@ namespace MySTL {
             using pointer = T *;
             using reference = T &;
 
-            explicit Iterator(Block **blockMap = nullptr, size_t blockIndex = 0,
-                              size_t index = 0)
-                    : blockMap(blockMap), blockIndex(blockIndex), index(index) {}
+            explicit Iterator(const Deque *deque = nullptr, size_t offset = 0) : deque(deque), offset(offset) {}
 
-            reference operator*() const {
-                return blockMap[blockIndex]->elements[index];
-            }
+            reference operator*() const { return deque->element(offset); }
 
-            pointer operator->() { return &(operator*()); }
+            pointer operator->() const { return &(operator*()); }
 
             Iterator &operator++() {
-                ++index;
-                if (index >= ELEMENTS_PER_BLOCK) {
-                    ++blockIndex;
-                    index = 0;
-                }
+                ++offset;
                 return *this;
             }
 
             Iterator operator++(int) {
                 auto temp = *this;
-                ++(*this);
+                ++offset;
                 return temp;
             }
 
             Iterator &operator--() {
-                if (index == 0) {
-                    --blockIndex;
-                    index = ELEMENTS_PER_BLOCK - 1;
-                } else
-                    --index;
-                return index;
+                --offset;
+                return *this;
             }
 
             Iterator operator--(int) {
                 auto temp = *this;
-                --(*this);
+                --offset;
                 return temp;
             }
 
-            Iterator operator+(difference_type n) const {
-                auto temp = *this;
-                difference_type offset = n + index;
-                temp.blockIndex += offset / ELEMENTS_PER_BLOCK;
-                temp.index = offset % ELEMENTS_PER_BLOCK;
-                return temp;
-            }
+            Iterator operator+(difference_type n) const { return Iterator(deque, offset + n); }
 
-            Iterator operator-(difference_type n) const {
-                auto temp = *this;
-                difference_type offset =
-                        (index - n + ELEMENTS_PER_BLOCK) % ELEMENTS_PER_BLOCK;
-                temp.blockIndex -= offset / ELEMENTS_PER_BLOCK;
-                temp.index = offset % ELEMENTS_PER_BLOCK;
-                return temp;
-            }
+            Iterator operator-(difference_type n) const { return Iterator(deque, offset - n); }
 
             difference_type operator-(const Iterator &other) const {
-                return (blockIndex - other.blockIndex) * ELEMENTS_PER_BLOCK +
-                       index - other.index;
+                return static_cast<difference_type>(offset) - static_cast<difference_type>(other.offset);
             }
 
-            bool operator==(const Iterator &other) const {
-                return blockMap == other.blockMap &&
-                       blockIndex == other.blockIndex && index == other.index;
+            Iterator &operator+=(difference_type n) {
+                offset += n;
+                return *this;
             }
 
-            bool operator!=(const Iterator &other) const {
-                return !(*this == other);
+            Iterator &operator-=(difference_type n) {
+                offset -= n;
+                return *this;
             }
 
             reference operator[](difference_type n) const { return *(*this + n); }
 
-            Iterator &operator+=(difference_type n) {
-                *this = *this + n;
-                return *this;
-            }
+            bool operator==(const Iterator &other) const { return deque == other.deque && offset == other.offset; }
+
+            bool operator!=(const Iterator &other) const { return !(*this == other); }
+
+            bool operator<(const Iterator &other) const { return offset < other.offset; }
+
+            bool operator>(const Iterator &other) const { return offset > other.offset; }
+
+            bool operator<=(const Iterator &other) const { return offset <= other.offset; }
+
+            bool operator>=(const Iterator &other) const { return offset >= other.offset; }
 
         private:
-            Block **blockMap;
-            size_t blockIndex;
-            size_t index;
+            const Deque *deque;
+            // Position across the whole map, see head
+            size_t offset;
         };
 
         Deque();
@@ -138,12 +124,14 @@ namespace MySTL {
 
         [[nodiscard]] size_t max_size() const;
 
+        // Destroys the elements but keeps the map and up to SPARE_BLOCKS blocks
         void clear();
 
         T &operator[](size_t index);
 
         const T &operator[](size_t index) const;
 
+        // Throws std::out_of_range past the end
         T &at(size_t index);
 
         const T &at(size_t index) const;
@@ -174,6 +162,7 @@ namespace MySTL {
         template<typename... Args>
         void emplace_front(Args &&...args);
 
+        // Shifts the elements on the shorter side of index
         void insert(size_t index, const T &value);
 
         void erase(size_t index);
@@ -200,501 +189,360 @@ namespace MySTL {
         const_reverse_iterator crend();
 
     private:
-        Block **map;
+        // Block pointers, null outside the blocks holding elements
+        T **map;
         size_t mapSize;
-        size_t first;
-        size_t last;
+        // Offset of the front element across the map: its block is
+        // head / ELEMENTS_PER_BLOCK and its slot head % ELEMENTS_PER_BLOCK
+        size_t head;
         size_t len;
-        size_t cap;
-        size_t firstIndex{};
-        size_t lastIndex{};
+        T *spare[SPARE_BLOCKS];
+        size_t spareCount;
 
-        Iterator start{};
-        Iterator finish{};
+        T &element(size_t offset) const;
 
-        void expandMap();
+        T *acquireBlock();
+
+        // Keeps the block as a spare when there is room, else frees it
+        void releaseBlock(T *block);
+
+        // Constructs an element at offset, acquiring its block if needed
+        template<typename... Args>
+        void constructAt(size_t offset, Args &&...args);
+
+        // Recentres the blocks in use, growing the map when it is over half
+        // full, so both ends have a free slot again
+        void reallocateMap();
+
+        // Destroys the elements and frees every block
+        void freeAll();
     };
 
     template<typename T>
-    Deque<T>::Deque()
-            : map(new Block *[1]),
-              mapSize(1),
-              first(0),
-              last(0),
-              len(0),
-              cap(ELEMENTS_PER_BLOCK) {
-        map[0] = new Block();
-        ++mapSize;
-        start = Iterator(&(map[0]->elements[ELEMENTS_PER_BLOCK / 2]));
-        finish = Iterator(&(map[0]->elements[ELEMENTS_PER_BLOCK / 2]));
-        first = ELEMENTS_PER_BLOCK / 2;
-        last = ELEMENTS_PER_BLOCK / 2;
-    }
+    Deque<T>::Deque() : map(nullptr), mapSize(0), head(0), len(0), spare(), spareCount(0) {}
 
     template<typename T>
     Deque<T>::~Deque() {
-        for (size_t i = 0; i < mapSize; ++i) {
-            delete[] map[i];
-        }
-        delete[] map;
+        freeAll();
     }
 
     template<typename T>
-    void Deque<T>::expandMap() {
-        auto newMapSize = mapSize * 2;
-        auto newMap = new Block *[newMapSize];
-        std::copy(map, map + mapSize, newMap);
-        delete[] map;
-        map = newMap;
-        mapSize = newMapSize;
-        start = Iterator(&(map[first]->elements[firstIndex]));
-        finish = Iterator(&(map[last]->elements[lastIndex]));
+    Deque<T>::Deque(const Deque<T> &other) : Deque() {
+        for (size_t i = 0; i < other.len; ++i) push_back(other[i]);
     }
 
     template<typename T>
-    Deque<T>::iterator Deque<T>::begin() {
-        return Deque::start;
+    Deque<T>::Deque(Deque<T> &&other) noexcept
+            : map(other.map), mapSize(other.mapSize), head(other.head), len(other.len), spare(),
+              spareCount(other.spareCount) {
+        std::copy(other.spare, other.spare + other.spareCount, spare);
+        other.map = nullptr;
+        other.mapSize = 0;
+        other.head = 0;
+        other.len = 0;
+        other.spareCount = 0;
     }
 
     template<typename T>
-    Deque<T>::iterator Deque<T>::end() {
-        return Deque::finish + 1;
+    Deque<T> &Deque<T>::operator=(const Deque<T> &other) {
+        if (this != &other) {
+            clear();
+            for (size_t i = 0; i < other.len; ++i) push_back(other[i]);
+        }
+        return *this;
     }
 
     template<typename T>
-    Deque<T>::const_iterator Deque<T>::cbegin() {
-        return Deque::start;
+    Deque<T> &Deque<T>::operator=(Deque<T> &&other) noexcept {
+        if (this != &other) {
+            freeAll();
+            map = other.map;
+            mapSize = other.mapSize;
+            head = other.head;
+            len = other.len;
+            spareCount = other.spareCount;
+            std::copy(other.spare, other.spare + other.spareCount, spare);
+            other.map = nullptr;
+            other.mapSize = 0;
+            other.head = 0;
+            other.len = 0;
+            other.spareCount = 0;
+        }
+        return *this;
     }
 
     template<typename T>
-    Deque<T>::const_iterator Deque<T>::cend() {
-        return Deque::finish + 1;
+    bool Deque<T>::empty() const {
+        return len == 0;
     }
 
     template<typename T>
-    Deque<T>::reverse_iterator Deque<T>::rbegin() {
-        return Deque::finish;
+    size_t Deque<T>::size() const {
+        return len;
     }
 
     template<typename T>
-    Deque<T>::reverse_iterator Deque<T>::rend() {
-        return Deque::start - 1;
+    size_t Deque<T>::max_size() const {
+        return mapSize * ELEMENTS_PER_BLOCK;
     }
 
     template<typename T>
-    Deque<T>::const_reverse_iterator Deque<T>::crbegin() {
-        return Deque::finish;
+    void Deque<T>::clear() {
+        for (size_t i = 0; i < len; ++i) std::destroy_at(&element(head + i));
+        for (size_t i = 0; i < mapSize; ++i) {
+            if (map[i] != nullptr) releaseBlock(map[i]);
+            map[i] = nullptr;
+        }
+        head = mapSize / 2 * ELEMENTS_PER_BLOCK;
+        len = 0;
     }
 
     template<typename T>
-    Deque<T>::const_reverse_iterator Deque<T>::crend() {
-        return Deque::start - 1;
+    T &Deque<T>::operator[](size_t index) {
+        return element(head + index);
     }
 
     template<typename T>
-    void Deque<T>::erase(size_t index) {
-        if (index >= size()) throw std::out_of_range("Index is out of bounds.");
-
-        size_t blockIndex = index / ELEMENTS_PER_BLOCK;
-        size_t inBlockIndex = index % ELEMENTS_PER_BLOCK;
-
-        std::copy(map[blockIndex]->elements + inBlockIndex + 1,
-                  map[blockIndex]->elements + ELEMENTS_PER_BLOCK,
-                  map[blockIndex]->elements + inBlockIndex);
-        for (size_t i = blockIndex; i < last; ++i) {
-            map[i]->elements[ELEMENTS_PER_BLOCK - 1] = map[i + 1]->elements[0];
-            std::copy(map[i + 1]->elements + 1,
-                      map[i + 1]->elements + ELEMENTS_PER_BLOCK,
-                      map[i + 1]->elements);
-        }
-
-        --lastIndex;
-        if (lastIndex < 0 && last) {
-            lastIndex = ELEMENTS_PER_BLOCK - 1;
-            delete[] map[last];
-            map[last--] = nullptr;
-        }
-        --finish;
-        --len;
+    const T &Deque<T>::operator[](size_t index) const {
+        return element(head + index);
     }
 
     template<typename T>
-    void Deque<T>::insert(size_t index, const T &value) {
-        if (index > size()) throw std::out_of_range("Index is out of bounds.");
+    T &Deque<T>::at(size_t index) {
+        if (index >= len) throw std::out_of_range("Index is out of bounds.");
+        return element(head + index);
+    }
 
-        auto blockIndex = index / ELEMENTS_PER_BLOCK;
-        auto inBlockIndex = index % ELEMENTS_PER_BLOCK;
+    template<typename T>
+    const T &Deque<T>::at(size_t index) const {
+        if (index >= len) throw std::out_of_range("Index is out of bounds.");
+        return element(head + index);
+    }
 
-        if (lastIndex == ELEMENTS_PER_BLOCK - 1) {
-            if (last + 1 == mapSize) {
-                expandMap();
-            }
-            map[++last] = new Block();
-        }
+    template<typename T>
+    T &Deque<T>::front() {
+        return element(head);
+    }
 
-        for (size_t i = last; i > blockIndex; --i) {
-            map[i]->elements[0] = map[i - 1]->elements[ELEMENTS_PER_BLOCK - 1];
-            std::copy_backward(map[i - 1]->elements,
-                               map[i - 1]->elements + ELEMENTS_PER_BLOCK - 1,
-                               map[i - 1]->elements + ELEMENTS_PER_BLOCK);
-        }
-        std::copy_backward(map[blockIndex]->elements + inBlockIndex,
-                           map[blockIndex]->elements + lastIndex,
-                           map[blockIndex]->elements + lastIndex + 1);
-        map[blockIndex]->elements[inBlockIndex] = value;
-        ++lastIndex;
-        ++finish;
-        ++len;
+    template<typename T>
+    const T &Deque<T>::front() const {
+        return element(head);
     }
 
     template<typename T>
-    template<typename... Args>
-    void Deque<T>::emplace_front(Args &&...args) {
-        if (firstIndex > 0) {
-            --firstIndex;
-            std::copy_backward(map[first]->elements + firstIndex,
-                               map[first]->elements + ELEMENTS_PER_BLOCK - 1,
-                               map[first]->elements + ELEMENTS_PER_BLOCK);
-        } else {
-            if (first == 0) {
-                auto newMapSize = mapSize * 2;
-                auto newMap = new Block *[newMapSize];
-                std::copy(map, map + mapSize, newMap + 1);
-                delete[] map;
-                mapSize = newMapSize;
-                first = 1;
-            }
-            --first;
-            map[first] = new Block();
-            firstIndex = 0;
-        }
-        map[first]->elements[firstIndex] = T(std::forward<Args>(args)...);
-        start = Iterator(&(map[first]->elements[firstIndex]));
-        ++len;
+    T &Deque<T>::back() {
+        return element(head + len - 1);
     }
 
     template<typename T>
-    template<typename... Args>
-    void Deque<T>::emplace_back(Args &&...args) {
-        if (lastIndex == ELEMENTS_PER_BLOCK - 1) {
-            if (last + 1 >= mapSize) {
-                auto newMapSize = mapSize * 2;
-                auto newMap = new Block *[newMapSize];
-                std::copy(map, map + mapSize, newMap);
-                delete[] map;
-                map = newMap;
-                mapSize = newMapSize;
-            }
-            ++last;
-            lastIndex = 0;
-        } else
-            ++lastIndex;
-        map[last]->elements[lastIndex] = T(std::forward<Args>(args)...);
-        finish = Iterator(&(map[last]->elements[lastIndex]));
-        ++len;
+    const T &Deque<T>::back() const {
+        return element(head + len - 1);
     }
 
     template<typename T>
-    void Deque<T>::pop_front() {
-        if (len == 0) return;
-        if (firstIndex == ELEMENTS_PER_BLOCK - 1) {
-            if (first == last) {
-                // initialize
-                firstIndex = ELEMENTS_PER_BLOCK / 2;
-                lastIndex = ELEMENTS_PER_BLOCK / 2;
-            } else {
-                delete map[first];
-                ++first;
-                firstIndex = 0;
-            }
-        } else {
-            ++firstIndex;
-        }
-        --len;
+    void Deque<T>::push_back(const T &value) {
+        emplace_back(value);
     }
 
     template<typename T>
-    void Deque<T>::pop_back() {
-        if (len == 0) return;
-        if (lastIndex == 0) {
-            if (first == last) {
-                // initialize
-                firstIndex = ELEMENTS_PER_BLOCK / 2;
-                lastIndex = ELEMENTS_PER_BLOCK / 2;
-            } else {
-                delete map[last];
-                --last;
-                lastIndex = ELEMENTS_PER_BLOCK - 1;
-            }
-        } else {
-            --lastIndex;
-        }
-        --len;
+    void Deque<T>::push_back(T &&value) {
+        emplace_back(std::move(value));
     }
 
     template<typename T>
     void Deque<T>::push_front(const T &value) {
-        if (firstIndex > 0) {
-            --firstIndex;
-            std::copy_backward(map[first]->elements + firstIndex,
-                               map[first]->elements + ELEMENTS_PER_BLOCK - 1,
-                               map[first]->elements + ELEMENTS_PER_BLOCK);
-        } else {
-            if (first == 0) {
-                auto newMapSize = mapSize * 2;
-                auto newMap = new Block *[newMapSize];
-                std::copy(map, map + mapSize, newMap + 1);
-                delete[] map;
-                mapSize = newMapSize;
-                first = 1;
-            }
-            --first;
-            map[first] = new Block();
-            firstIndex = 0;
-        }
-        map[first]->elements[firstIndex] = value;
-        start = Iterator(&(map[first]->elements[firstIndex]));
-        ++len;
+        emplace_front(value);
     }
 
     template<typename T>
     void Deque<T>::push_front(T &&value) {
-        if (firstIndex > 0) {
-            --firstIndex;
-            std::copy_backward(map[first]->elements + firstIndex,
-                               map[first]->elements + ELEMENTS_PER_BLOCK - 1,
-                               map[first]->elements + ELEMENTS_PER_BLOCK);
-        } else {
-            if (first == 0) {
-                auto newMapSize = mapSize * 2;
-                auto newMap = new Block *[newMapSize];
-                std::copy(map, map + mapSize, newMap + 1);
-                delete[] map;
-                map = newMap;
-                mapSize = newMapSize;
-                first = 1;
-            }
-            --first;
-            map[first] = new Block();
-            firstIndex = 0;
+        emplace_front(std::move(value));
+    }
+
+    template<typename T>
+    void Deque<T>::pop_back() {
+        if (len == 0) return;
+        size_t offset = head + --len;
+        std::destroy_at(&element(offset));
+        // The block is empty once its first slot is popped
+        if (len == 0 || offset % ELEMENTS_PER_BLOCK == 0) {
+            releaseBlock(map[offset / ELEMENTS_PER_BLOCK]);
+            map[offset / ELEMENTS_PER_BLOCK] = nullptr;
         }
-        map[first]->elements[firstIndex] = std::move(value);
-        start = Iterator(&(map[first]->elements[firstIndex]));
-        ++len;
     }
 
     template<typename T>
-    void Deque<T>::push_back(const T &value) {
-        if (lastIndex == ELEMENTS_PER_BLOCK - 1) {
-            if (last == mapSize - 1) {
-                auto newMapSize = mapSize * 2;
-                auto newMap = new Block *[newMapSize];
-                std::copy(map, map + mapSize, newMap);
-                delete[] map;
-                map = newMap;
-                mapSize = newMapSize;
-                map[last] = new Block();
-            } else {
-                ++last;
-            }
-            lastIndex = 0;
-        } else
-            ++lastIndex;
-        map[last]->elements[lastIndex] = value;
-        finish = Iterator(&(map[last]->elements[lastIndex]));
-        ++len;
+    void Deque<T>::pop_front() {
+        if (len == 0) return;
+        size_t offset = head++;
+        --len;
+        std::destroy_at(&element(offset));
+        // The block is empty once its last slot is popped
+        if (len == 0 || head % ELEMENTS_PER_BLOCK == 0) {
+            releaseBlock(map[offset / ELEMENTS_PER_BLOCK]);
+            map[offset / ELEMENTS_PER_BLOCK] = nullptr;
+        }
     }
 
     template<typename T>
-    void Deque<T>::push_back(T &&value) {
-        if (lastIndex == ELEMENTS_PER_BLOCK - 1) {
-            if (last == mapSize - 1) {
-                auto newMapSize = mapSize * 2;
-                auto newMap = new Block *[newMapSize];
-                std::copy(map, map + mapSize, newMap);
-                delete[] map;
-                map = newMap;
-                mapSize = newMapSize;
-                map[last] = new Block();
-            } else {
-                ++last;
-            }
-            lastIndex = 0;
-        } else
-            ++lastIndex;
-        map[last]->elements[lastIndex] = std::move(value);
-        finish = Iterator(&(map[last]->elements[lastIndex]));
+    template<typename... Args>
+    void Deque<T>::emplace_back(Args &&...args) {
+        if ((head + len) / ELEMENTS_PER_BLOCK >= mapSize) reallocateMap();
+        constructAt(head + len, std::forward<Args>(args)...);
         ++len;
     }
 
     template<typename T>
-    const T &Deque<T>::back() const {
-        return map[last]->elements[lastIndex];
+    template<typename... Args>
+    void Deque<T>::emplace_front(Args &&...args) {
+        if (head == 0) reallocateMap();
+        constructAt(head - 1, std::forward<Args>(args)...);
+        --head;
+        ++len;
     }
 
     template<typename T>
-    T &Deque<T>::back() {
-        return map[last]->elements[lastIndex];
+    void Deque<T>::insert(size_t index, const T &value) {
+        if (index > len) throw std::out_of_range("Index is out of bounds.");
+        // value may be one of the elements about to move
+        T copy(value);
+        if (index == 0) {
+            emplace_front(std::move(copy));
+        } else if (index == len) {
+            emplace_back(std::move(copy));
+        } else if (index < len / 2) {
+            emplace_front(std::move(front()));
+            std::move(begin() + 2, begin() + index + 1, begin() + 1);
+            (*this)[index] = std::move(copy);
+        } else {
+            emplace_back(std::move(back()));
+            std::move_backward(begin() + index, end() - 2, end() - 1);
+            (*this)[index] = std::move(copy);
+        }
     }
 
     template<typename T>
-    const T &Deque<T>::front() const {
-        return map[first]->elements[firstIndex];
+    void Deque<T>::erase(size_t index) {
+        if (index >= len) throw std::out_of_range("Index is out of bounds.");
+        if (index < len / 2) {
+            std::move_backward(begin(), begin() + index, begin() + index + 1);
+            pop_front();
+        } else {
+            std::move(begin() + index + 1, end(), begin() + index);
+            pop_back();
+        }
     }
 
     template<typename T>
-    T &Deque<T>::front() {
-        return map[first]->elements[firstIndex];
+    Deque<T>::iterator Deque<T>::begin() {
+        return iterator(this, head);
     }
 
     template<typename T>
-    const T &Deque<T>::at(size_t index) const {
-        return map[first + index / ELEMENTS_PER_BLOCK]
-                ->elements[index % ELEMENTS_PER_BLOCK];
+    Deque<T>::iterator Deque<T>::end() {
+        return iterator(this, head + len);
     }
 
     template<typename T>
-    T &Deque<T>::at(size_t index) {
-        return map[first + index / ELEMENTS_PER_BLOCK]
-                ->elements[index % ELEMENTS_PER_BLOCK];
+    Deque<T>::const_iterator Deque<T>::cbegin() {
+        return const_iterator(this, head);
     }
 
     template<typename T>
-    const T &Deque<T>::operator[](size_t index) const {
-        return at(index);
+    Deque<T>::const_iterator Deque<T>::cend() {
+        return const_iterator(this, head + len);
     }
 
     template<typename T>
-    T &Deque<T>::operator[](size_t index) {
-        return at(index);
+    Deque<T>::reverse_iterator Deque<T>::rbegin() {
+        return reverse_iterator(end());
     }
 
     template<typename T>
-    void Deque<T>::clear() {
-        for (size_t i = 0; i < mapSize; ++i) {
-            delete map[i];
-        }
-        delete[] map;
-        map = new Block *[1];
-        map[0] = new Block();
-        mapSize = 1;
-        first = 0;
-        last = 0;
-        len = 0;
-        cap = ELEMENTS_PER_BLOCK;
-        start = Iterator(&(map[0]->elements[ELEMENTS_PER_BLOCK / 2]));
-        finish = Iterator(&(map[0]->elements[ELEMENTS_PER_BLOCK / 2]));
-        firstIndex = ELEMENTS_PER_BLOCK / 2;
-        lastIndex = ELEMENTS_PER_BLOCK / 2;
+    Deque<T>::reverse_iterator Deque<T>::rend() {
+        return reverse_iterator(begin());
     }
 
     template<typename T>
-    size_t Deque<T>::max_size() const {
-        return mapSize * ELEMENTS_PER_BLOCK;
+    Deque<T>::const_reverse_iterator Deque<T>::crbegin() {
+        return const_reverse_iterator(cend());
     }
 
     template<typename T>
-    size_t Deque<T>::size() const {
-        return len;
+    Deque<T>::const_reverse_iterator Deque<T>::crend() {
+        return const_reverse_iterator(cbegin());
     }
 
     template<typename T>
-    bool Deque<T>::empty() const {
-        return len == 0;
+    T &Deque<T>::element(size_t offset) const {
+        return map[offset / ELEMENTS_PER_BLOCK][offset % ELEMENTS_PER_BLOCK];
     }
 
     template<typename T>
-    Deque<T> &Deque<T>::operator=(Deque<T> &&other) noexcept {
-        if (this != &other) {
-            for (size_t i = 0; i < mapSize; ++i) delete[] map[i];
-            delete[] map;
-
-            map = other.map;
-            mapSize = other.mapSize;
-            first = other.first;
-            last = other.last;
-            firstIndex = other.firstIndex;
-            lastIndex = other.lastIndex;
-            start = other.start;
-            finish = other.finish;
-
-            other.map = nullptr;
-            other.mapSize = 0;
-            other.first = 0;
-            other.last = 0;
-            other.firstIndex = 0;
-            other.lastIndex = 0;
-            other.start = Iterator();
-            other.finish = Iterator();
-        }
-        return *this;
+    T *Deque<T>::acquireBlock() {
+        if (spareCount > 0) return spare[--spareCount];
+        return std::allocator<T>().allocate(ELEMENTS_PER_BLOCK);
     }
 
     template<typename T>
-    Deque<T> &Deque<T>::operator=(const Deque<T> &other) {
-        if (this != &other) {
-            for (size_t i = 0; i < mapSize; ++i) delete[] map[i];
-            delete[] map;
+    void Deque<T>::releaseBlock(T *block) {
+        if (spareCount < SPARE_BLOCKS)
+            spare[spareCount++] = block;
+        else
+            std::allocator<T>().deallocate(block, ELEMENTS_PER_BLOCK);
+    }
 
-            mapSize = other.mapSize;
-            map = new Block *[mapSize];
-            for (size_t i = 0; i < mapSize; ++i) {
-                map[i] = new Block();
-                std::copy(other.map[i]->elements,
-                          other.map[i]->elements + ELEMENTS_PER_BLOCK,
-                          map[i]->elements);
+    template<typename T>
+    template<typename... Args>
+    void Deque<T>::constructAt(size_t offset, Args &&...args) {
+        auto &block = map[offset / ELEMENTS_PER_BLOCK];
+        bool fresh = block == nullptr;
+        if (fresh) block = acquireBlock();
+        try {
+            std::construct_at(block + offset % ELEMENTS_PER_BLOCK, std::forward<Args>(args)...);
+        } catch (...) {
+            if (fresh) {
+                releaseBlock(block);
+                block = nullptr;
             }
-
-            first = other.first;
-            last = other.last;
-            firstIndex = other.firstIndex;
-            lastIndex = other.lastIndex;
-            len = other.len;
-            start = Iterator(&(map[first]->elements[firstIndex]));
-            finish = Iterator(&(map[last]->elements[lastIndex]));
+            throw;
         }
-        return *this;
     }
 
     template<typename T>
-    Deque<T>::Deque(Deque<T> &&other) noexcept {
-        map = other.map;
-        mapSize = other.mapSize;
-        first = other.first;
-        last = other.last;
-        firstIndex = other.firstIndex;
-        lastIndex = other.lastIndex;
-        start = other.start;
-        finish = other.finish;
-
-        other.map = nullptr;
-        other.mapSize = 0;
-        other.first = 0;
-        other.last = 0;
-        other.firstIndex = 0;
-        other.lastIndex = 0;
-        other.start = Iterator();
-        other.finish = Iterator();
+    void Deque<T>::reallocateMap() {
+        size_t firstBlock = head / ELEMENTS_PER_BLOCK;
+        size_t used = len == 0 ? 0 : (head + len - 1) / ELEMENTS_PER_BLOCK - firstBlock + 1;
+        // A queue drifting through a roomy map only slides its block pointers
+        size_t newSize = (used + 1) * 2 > mapSize ? std::max(MIN_MAP_SIZE, mapSize * 2) : mapSize;
+        size_t newFirst = (newSize - used) / 2;
+        if (newSize != mapSize) {
+            auto newMap = new T *[newSize]();
+            std::copy(map + firstBlock, map + firstBlock + used, newMap + newFirst);
+            delete[] map;
+            map = newMap;
+            mapSize = newSize;
+        } else {
+            std::memmove(map + newFirst, map + firstBlock, used * sizeof(T *));
+            std::fill(map, map + newFirst, nullptr);
+            std::fill(map + newFirst + used, map + mapSize, nullptr);
+        }
+        head = newFirst * ELEMENTS_PER_BLOCK + head % ELEMENTS_PER_BLOCK;
     }
 
     template<typename T>
-    Deque<T>::Deque(const Deque<T> &other) {
-        mapSize = other.mapSize;
-        map = new Block *[mapSize];
+    void Deque<T>::freeAll() {
+        for (size_t i = 0; i < len; ++i) std::destroy_at(&element(head + i));
         for (size_t i = 0; i < mapSize; ++i) {
-            map[i] = new Block();
-            std::copy(other.map[i]->elements,
-                      other.map[i]->elements + ELEMENTS_PER_BLOCK,
-                      map[i]->elements);
+            if (map[i] != nullptr) std::allocator<T>().deallocate(map[i], ELEMENTS_PER_BLOCK);
         }
-
-        first = other.first;
-        last = other.last;
-        firstIndex = other.firstIndex;
-        lastIndex = other.lastIndex;
-        len = other.len;
-        start = Iterator(&(map[first]->elements[firstIndex]));
-        finish = Iterator(&(map[last]->elements[lastIndex]));
+        for (size_t i = 0; i < spareCount; ++i) std::allocator<T>().deallocate(spare[i], ELEMENTS_PER_BLOCK);
+        delete[] map;
+        map = nullptr;
+        mapSize = 0;
+        head = 0;
+        len = 0;
+        spareCount = 0;
     }
 }  // namespace MySTL
 
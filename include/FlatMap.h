@@ -0,0 +1,368 @@
+#ifndef MYSTL_FLATMAP_H
+#define MYSTL_FLATMAP_H
+
+#include <algorithm>
+#include <bit>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "utils/Prefetch.h"
+
+#include "Pair.h"
+#include "Vector.h"
+
+namespace MySTL {
+
+    // Ordered map over two contiguous arrays, keys and values, for data that
+    // is built once and then mostly queried: no per-entry nodes, and a search
+    // reads keys only. Bulk construction is one sort plus a duplicate pass,
+    // and batches are merged in a single pass, while a single new key costs
+    // O(n).
+    //
+    // By default the arrays are sorted and searched with a branchless binary
+    // search. With Eytzinger set they are laid out in the BFS order of a
+    // complete binary search tree instead (children of slot k at 2k and
+    // 2k + 1, one-based), so the first levels of every search share a few
+    // cache lines and deeper ones are prefetched; iteration then walks that
+    // implicit tree in order.
+    template<typename K, typename V, typename Compare = std::less<K>, bool Eytzinger = false>
+    class FlatMap {
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Pair<K, V>;
+            using difference_type = std::ptrdiff_t;
+            // Keys and values sit in separate arrays, so an entry is a pair of
+            // references; values are updated through find and at
+            using reference = Pair<const K &, const V &>;
+
+            struct pointer {
+                reference ref;
+
+                reference *operator->() { return &ref; }
+            };
+
+            Iterator() : map(nullptr), index(0) {}
+
+            Iterator(const FlatMap *map, size_t index) : map(map), index(index) {}
+
+            reference operator*() const { return reference(key(), value()); }
+
+            pointer operator->() const { return pointer{**this}; }
+
+            const K &key() const { return map->keys[index]; }
+
+            const V &value() const { return map->values[index]; }
+
+            Iterator &operator++() {
+                index = map->nextIndex(index);
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                auto temp = *this;
+                ++*this;
+                return temp;
+            }
+
+            bool operator==(const Iterator &other) const { return index == other.index; }
+
+            bool operator!=(const Iterator &other) const { return index != other.index; }
+
+        private:
+            const FlatMap *map;
+            // Position in the arrays, len at the end
+            size_t index;
+        };
+
+        using iterator = Iterator;
+        using const_iterator = Iterator;
+
+        explicit FlatMap(const Compare &comp = Compare()) : len(0), cmp(comp) {}
+
+        // Builds from entries (anything with first and second) in any order;
+        // of equal keys the last one wins
+        template<typename InputIt>
+        requires std::input_iterator<InputIt>
+        FlatMap(InputIt first, InputIt last, const Compare &comp = Compare());
+
+        [[nodiscard]] bool empty() const { return len == 0; }
+
+        [[nodiscard]] size_t size() const { return len; }
+
+        V *find(const K &key);
+
+        const V *find(const K &key) const;
+
+        bool contains(const K &key) const { return find(key) != nullptr; }
+
+        // Throws std::out_of_range when key is absent
+        V &at(const K &key);
+
+        const V &at(const K &key) const;
+
+        // Assigns in place when key exists, otherwise merges it in O(n)
+        void insert(const K &key, const V &value);
+
+        // Merges a batch of entries in O(n + m log m): the batch is sorted on
+        // its own and merged in one pass. Batch entries win over existing ones.
+        template<typename InputIt>
+        requires std::input_iterator<InputIt>
+        void insert(InputIt first, InputIt last);
+
+        // O(n)
+        void erase(const K &key);
+
+        void clear();
+
+        iterator begin() const { return iterator(this, firstIndex()); }
+
+        iterator end() const { return iterator(this, len); }
+
+        // First entry whose key is not less than key
+        iterator lower_bound(const K &key) const { return iterator(this, search<false>(key)); }
+
+        // First entry whose key is greater than key
+        iterator upper_bound(const K &key) const { return iterator(this, search<true>(key)); }
+
+    private:
+        // Slots ahead of the current one prefetched by an Eytzinger search,
+        // four levels down
+        static constexpr size_t PREFETCH_AHEAD = 16;
+
+        // Only the first len elements are live; erase leaves moved-from ones
+        // behind in the sorted layout
+        Vector<K> keys;
+        Vector<V> values;
+        size_t len;
+        Compare cmp;
+
+        // Index of the first key greater than key when Upper, else not less
+        // than it; len when there is none
+        template<bool Upper>
+        size_t search(const K &key) const;
+
+        size_t findIndex(const K &key) const;
+
+        size_t firstIndex() const;
+
+        // Index of the next key in order, len after the last one
+        size_t nextIndex(size_t index) const;
+
+        // Sorts entries[0, n) by key and drops all but the last of equal keys
+        void sortUnique(Vector<Pair<K, V>> &entries, size_t &n) const;
+
+        // Takes over n ascending keys and their values, laying them out
+        void assignSorted(Vector<K> &sortedKeys, Vector<V> &sortedValues, size_t n);
+    };
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    template<typename InputIt>
+    requires std::input_iterator<InputIt>
+    FlatMap<K, V, Compare, Eytzinger>::FlatMap(InputIt first, InputIt last, const Compare &comp) : len(0), cmp(comp) {
+        insert(first, last);
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    V *FlatMap<K, V, Compare, Eytzinger>::find(const K &key) {
+        size_t index = findIndex(key);
+        return index != len ? &values[index] : nullptr;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    const V *FlatMap<K, V, Compare, Eytzinger>::find(const K &key) const {
+        size_t index = findIndex(key);
+        return index != len ? &values[index] : nullptr;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    V &FlatMap<K, V, Compare, Eytzinger>::at(const K &key) {
+        auto value = find(key);
+        if (value == nullptr) throw std::out_of_range("Key not found");
+        return *value;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    const V &FlatMap<K, V, Compare, Eytzinger>::at(const K &key) const {
+        auto value = find(key);
+        if (value == nullptr) throw std::out_of_range("Key not found");
+        return *value;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    void FlatMap<K, V, Compare, Eytzinger>::insert(const K &key, const V &value) {
+        if (auto existing = find(key)) {
+            *existing = value;
+            return;
+        }
+        const Pair<K, V> entry(key, value);
+        insert(&entry, &entry + 1);
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    template<typename InputIt>
+    requires std::input_iterator<InputIt>
+    void FlatMap<K, V, Compare, Eytzinger>::insert(InputIt first, InputIt last) {
+        Vector<Pair<K, V>> batch;
+        for (; first != last; ++first) {
+            const auto &entry = *first;
+            batch.push_back(Pair<K, V>(entry.first, entry.second));
+        }
+        size_t count = batch.size();
+        if (count == 0) return;
+        sortUnique(batch, count);
+
+        Vector<K> mergedKeys(len + count);
+        Vector<V> mergedValues(len + count);
+        size_t merged = 0;
+        size_t index = firstIndex();
+        for (size_t j = 0; index != len || j < count; ++merged) {
+            if (j == count || (index != len && cmp(keys[index], batch[j].first))) {
+                mergedKeys[merged] = std::move(keys[index]);
+                mergedValues[merged] = std::move(values[index]);
+                index = nextIndex(index);
+            } else {
+                if (index != len && !cmp(batch[j].first, keys[index])) index = nextIndex(index);
+                mergedKeys[merged] = std::move(batch[j].first);
+                mergedValues[merged] = std::move(batch[j].second);
+                ++j;
+            }
+        }
+        assignSorted(mergedKeys, mergedValues, merged);
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    void FlatMap<K, V, Compare, Eytzinger>::erase(const K &key) {
+        size_t index = findIndex(key);
+        if (index == len) return;
+        if constexpr (Eytzinger) {
+            Vector<K> sortedKeys(len - 1);
+            Vector<V> sortedValues(len - 1);
+            size_t kept = 0;
+            for (size_t i = firstIndex(); i != len; i = nextIndex(i)) {
+                if (i == index) continue;
+                sortedKeys[kept] = std::move(keys[i]);
+                sortedValues[kept] = std::move(values[i]);
+                ++kept;
+            }
+            assignSorted(sortedKeys, sortedValues, kept);
+        } else {
+            std::move(&keys[index + 1], &keys[0] + len, &keys[index]);
+            std::move(&values[index + 1], &values[0] + len, &values[index]);
+            --len;
+        }
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    void FlatMap<K, V, Compare, Eytzinger>::clear() {
+        keys = Vector<K>();
+        values = Vector<V>();
+        len = 0;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    template<bool Upper>
+    size_t FlatMap<K, V, Compare, Eytzinger>::search(const K &key) const {
+        // Whether a key belongs before the result
+        auto before = [&](const K &x) { return Upper ? !cmp(key, x) : cmp(x, key); };
+        if (len == 0) return 0;
+        const K *base = &keys[0];
+        if constexpr (Eytzinger) {
+            size_t k = 1;
+            while (k <= len) {
+                prefetch(base + std::min(PREFETCH_AHEAD * k, len) - 1);
+                k = 2 * k + before(base[k - 1]);
+            }
+            // Undo the right turns taken after the last left one
+            k >>= std::countr_one(k) + 1;
+            return k == 0 ? len : k - 1;
+        } else {
+            // Halving without branches, so the compiler can use a conditional move
+            const K *first = base;
+            for (size_t n = len; n > 1;) {
+                size_t half = n / 2;
+                first = before(first[half]) ? first + half : first;
+                n -= half;
+            }
+            return static_cast<size_t>(first - base) + before(*first);
+        }
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    size_t FlatMap<K, V, Compare, Eytzinger>::findIndex(const K &key) const {
+        size_t index = search<false>(key);
+        return index != len && !cmp(key, keys[index]) ? index : len;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    size_t FlatMap<K, V, Compare, Eytzinger>::firstIndex() const {
+        if constexpr (Eytzinger) {
+            if (len == 0) return 0;
+            size_t k = 1;
+            while (2 * k <= len) k *= 2;
+            return k - 1;
+        } else {
+            return 0;
+        }
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    size_t FlatMap<K, V, Compare, Eytzinger>::nextIndex(size_t index) const {
+        if constexpr (Eytzinger) {
+            size_t k = index + 1;
+            if (2 * k + 1 <= len) {
+                // Leftmost slot of the right subtree
+                k = 2 * k + 1;
+                while (2 * k <= len) k *= 2;
+            } else {
+                // Up past the right children, then to the parent
+                k >>= std::countr_one(k) + 1;
+            }
+            return k == 0 ? len : k - 1;
+        } else {
+            return index + 1;
+        }
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    void FlatMap<K, V, Compare, Eytzinger>::sortUnique(Vector<Pair<K, V>> &entries, size_t &n) const {
+        auto first = &entries[0];
+        std::stable_sort(first, first + n, [this](const Pair<K, V> &a, const Pair<K, V> &b) {
+            return cmp(a.first, b.first);
+        });
+        size_t unique = 0;
+        for (size_t i = 0; i < n; ++i) {
+            if (unique > 0 && !cmp(first[unique - 1].first, first[i].first))
+                first[unique - 1] = std::move(first[i]);
+            else if (unique++ != i)
+                // Moving an entry onto itself would empty it
+                first[unique - 1] = std::move(first[i]);
+        }
+        n = unique;
+    }
+
+    template<typename K, typename V, typename Compare, bool Eytzinger>
+    void FlatMap<K, V, Compare, Eytzinger>::assignSorted(Vector<K> &sortedKeys, Vector<V> &sortedValues, size_t n) {
+        len = n;
+        if constexpr (Eytzinger) {
+            Vector<K> laidKeys(n);
+            Vector<V> laidValues(n);
+            size_t index = firstIndex();
+            for (size_t i = 0; i < n; ++i, index = nextIndex(index)) {
+                laidKeys[index] = std::move(sortedKeys[i]);
+                laidValues[index] = std::move(sortedValues[i]);
+            }
+            keys.swap(laidKeys);
+            values.swap(laidValues);
+        } else {
+            keys.swap(sortedKeys);
+            values.swap(sortedValues);
+        }
+    }
+
+}  // namespace MySTL
+
+#endif  // MYSTL_FLATMAP_H
@@ -0,0 +1,102 @@
+#ifndef MYSTL_FLATSET_H
+#define MYSTL_FLATSET_H
+
+#include <ranges>
+
+#include "FlatMap.h"
+
+namespace MySTL {
+    // Sorted-array set for read-mostly data, see FlatMap
+    template<typename T, typename Compare = std::less<T>, bool Eytzinger = false>
+    class FlatSet {
+        using MapType = FlatMap<T, bool, Compare, Eytzinger>;
+
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T *;
+            using reference = const T &;
+
+            Iterator() = default;
+
+            explicit Iterator(typename MapType::iterator it) : it(it) {}
+
+            reference operator*() const { return it.key(); }
+
+            pointer operator->() const { return &it.key(); }
+
+            Iterator &operator++() {
+                ++it;
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                auto temp = *this;
+                ++it;
+                return temp;
+            }
+
+            bool operator==(const Iterator &other) const { return it == other.it; }
+
+            bool operator!=(const Iterator &other) const { return it != other.it; }
+
+        private:
+            typename MapType::iterator it;
+        };
+
+        using iterator = Iterator;
+        using const_iterator = Iterator;
+
+        explicit FlatSet(const Compare &comp = Compare()) : map(comp) {}
+
+        // Builds from elements in any order with one sort
+        template<typename InputIt>
+        requires std::input_iterator<InputIt>
+        FlatSet(InputIt first, InputIt last, const Compare &comp = Compare()) : map(comp) {
+            insert(first, last);
+        }
+
+        [[nodiscard]] bool empty() const { return map.empty(); }
+
+        [[nodiscard]] size_t size() const { return map.size(); }
+
+        // O(n) for a new element, prefer the batch insert
+        void insert(const T &t) {
+            if (!map.contains(t)) map.insert(t, true);
+        }
+
+        // Merges a batch of elements in one pass, see FlatMap::insert
+        template<typename InputIt>
+        requires std::input_iterator<InputIt>
+        void insert(InputIt first, InputIt last) {
+            auto entries = std::ranges::subrange(first, last) |
+                           std::views::transform([](const T &t) { return Pair<T, bool>(t, true); });
+            map.insert(entries.begin(), entries.end());
+        }
+
+        void erase(const T &t) { map.erase(t); }
+
+        bool contains(const T &t) const { return map.contains(t); }
+
+        void clear() { map.clear(); }
+
+        iterator begin() const { return iterator(map.begin()); }
+
+        iterator end() const { return iterator(map.end()); }
+
+        // First element not less than t
+        iterator lower_bound(const T &t) const { return iterator(map.lower_bound(t)); }
+
+        // First element greater than t
+        iterator upper_bound(const T &t) const { return iterator(map.upper_bound(t)); }
+
+    private:
+        MapType map;
+    };
+
+}  // namespace MySTL
+
+#endif  // MYSTL_FLATSET_H
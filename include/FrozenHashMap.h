@@ -0,0 +1,323 @@
+#ifndef MYSTL_FROZENHASHMAP_H
+#define MYSTL_FROZENHASHMAP_H
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <stdexcept>
+#include <type_traits>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "Vector.h"
+
+namespace MySTL {
+
+    // Read-only map over an image written by HashMap::freeze. The image holds
+    // no pointers, only offsets from its start, so it can be mmapped by any
+    // number of processes and queried in place without deserializing.
+    //
+    // Layout, each section aligned to 8 bytes:
+    //   Header | uint32_t seeds[bucketCount] | K keys[count] | V values[count]
+    //
+    // Keys are placed by a minimal perfect hash (hash and displace): a key's
+    // bucket is hashBytes(key, 0) % bucketCount and its slot is
+    // hashBytes(key, seeds[bucket]) % count, so a lookup reads one seed and
+    // compares one key. Buckets holding a single key store its slot directly
+    // (seed with DIRECT_SLOT set), which spares searching seeds for the last,
+    // nearly full slots. Keys are hashed by their bytes, which therefore need
+    // a unique object representation.
+    template<typename K, typename V>
+    class FrozenHashMap {
+        static_assert(std::is_trivially_copyable_v<K> && std::is_trivially_copyable_v<V>,
+                      "frozen images store keys and values as raw bytes");
+        static_assert(std::has_unique_object_representations_v<K>,
+                      "keys are hashed by their bytes and must not contain padding");
+        static_assert(alignof(K) <= 8 && alignof(V) <= 8, "sections are only 8-byte aligned");
+
+    public:
+        FrozenHashMap() = default;
+
+        // Views an image in memory, data must stay valid and 8-byte aligned
+        FrozenHashMap(const void *data, size_t size);
+
+        FrozenHashMap(FrozenHashMap &&other) noexcept;
+
+        FrozenHashMap &operator=(FrozenHashMap &&other) noexcept;
+
+        FrozenHashMap(const FrozenHashMap &) = delete;
+
+        FrozenHashMap &operator=(const FrozenHashMap &) = delete;
+
+        ~FrozenHashMap();
+
+        // Maps an image file read-only for the lifetime of the returned map
+        static FrozenHashMap open(const char *path);
+
+        [[nodiscard]] bool empty() const { return count() == 0; }
+
+        [[nodiscard]] size_t size() const { return count(); }
+
+        const V *find(const K &key) const;
+
+        bool contains(const K &key) const { return find(key) != nullptr; }
+
+        // Writes the image of entries[0, n), each entry a pointer to a pair
+        template<typename Entries>
+        static void write(std::ostream &out, const Entries &entries, size_t n);
+
+    private:
+        static constexpr uint64_t MAGIC = 0x4D4846314C545359ull;  // "YSTL1FHM"
+        static constexpr uint32_t VERSION = 1;
+        // Average keys per first-level bucket
+        static constexpr size_t BUCKET_LOAD = 4;
+        static constexpr uint32_t MAX_SEED = 1u << 30;
+        static constexpr uint32_t DIRECT_SLOT = 1u << 31;
+
+        struct Header {
+            uint64_t magic;
+            uint32_t version;
+            uint32_t keySize;
+            uint32_t valueSize;
+            uint32_t reserved;
+            uint64_t count;
+            uint64_t bucketCount;
+            uint64_t seedsOffset;
+            uint64_t keysOffset;
+            uint64_t valuesOffset;
+            uint64_t totalSize;
+        };
+
+        const unsigned char *base = nullptr;
+        size_t bytes = 0;
+        bool mapped = false;
+
+        [[nodiscard]] const Header &header() const {
+            return *reinterpret_cast<const Header *>(base);
+        }
+
+        [[nodiscard]] size_t count() const { return base ? header().count : 0; }
+
+        void release();
+
+        static size_t align(size_t offset) { return (offset + 7) & ~size_t(7); }
+
+        static uint64_t hashBytes(const K &key, uint64_t seed);
+    };
+
+    template<typename K, typename V>
+    uint64_t FrozenHashMap<K, V>::hashBytes(const K &key, uint64_t seed) {
+        // FNV-1a over the key bytes, then the murmur3 finalizer
+        auto data = reinterpret_cast<const unsigned char *>(&key);
+        uint64_t h = 0xCBF29CE484222325ull ^ (seed * 0x9E3779B97F4A7C15ull);
+        for (size_t i = 0; i < sizeof(K); ++i) {
+            h ^= data[i];
+            h *= 0x100000001B3ull;
+        }
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    template<typename K, typename V>
+    FrozenHashMap<K, V>::FrozenHashMap(const void *data, size_t size)
+            : base(static_cast<const unsigned char *>(data)), bytes(size) {
+        if (size < sizeof(Header)) throw std::invalid_argument("Frozen image is truncated");
+        const auto &h = header();
+        if (h.magic != MAGIC || h.version != VERSION)
+            throw std::invalid_argument("Not a frozen hash map image");
+        if (h.keySize != sizeof(K) || h.valueSize != sizeof(V))
+            throw std::invalid_argument("Frozen image has different key or value types");
+        if (h.totalSize > size) throw std::invalid_argument("Frozen image is truncated");
+    }
+
+    template<typename K, typename V>
+    FrozenHashMap<K, V>::FrozenHashMap(FrozenHashMap &&other) noexcept
+            : base(other.base), bytes(other.bytes), mapped(other.mapped) {
+        other.base = nullptr;
+        other.bytes = 0;
+        other.mapped = false;
+    }
+
+    template<typename K, typename V>
+    FrozenHashMap<K, V> &FrozenHashMap<K, V>::operator=(FrozenHashMap &&other) noexcept {
+        if (this == &other) return *this;
+        release();
+        base = other.base;
+        bytes = other.bytes;
+        mapped = other.mapped;
+        other.base = nullptr;
+        other.bytes = 0;
+        other.mapped = false;
+        return *this;
+    }
+
+    template<typename K, typename V>
+    FrozenHashMap<K, V>::~FrozenHashMap() {
+        release();
+    }
+
+    template<typename K, typename V>
+    void FrozenHashMap<K, V>::release() {
+#if defined(__unix__) || defined(__APPLE__)
+        if (mapped) munmap(const_cast<unsigned char *>(base), bytes);
+#endif
+        base = nullptr;
+        bytes = 0;
+        mapped = false;
+    }
+
+    template<typename K, typename V>
+    FrozenHashMap<K, V> FrozenHashMap<K, V>::open(const char *path) {
+#if defined(__unix__) || defined(__APPLE__)
+        int fd = ::open(path, O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot open frozen image");
+        struct stat st{};
+        if (fstat(fd, &st) != 0 || st.st_size == 0) {
+            close(fd);
+            throw std::runtime_error("Cannot read frozen image");
+        }
+        auto size = static_cast<size_t>(st.st_size);
+        void *data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+        close(fd);
+        if (data == MAP_FAILED) throw std::runtime_error("Cannot map frozen image");
+        try {
+            FrozenHashMap map(data, size);
+            map.mapped = true;
+            return map;
+        } catch (...) {
+            munmap(data, size);
+            throw;
+        }
+#else
+        (void) path;
+        throw std::runtime_error("Mapping frozen images is not supported on this platform");
+#endif
+    }
+
+    template<typename K, typename V>
+    const V *FrozenHashMap<K, V>::find(const K &key) const {
+        size_t n = count();
+        if (n == 0) return nullptr;
+        const auto &h = header();
+        uint32_t seed;
+        std::memcpy(&seed, base + h.seedsOffset + sizeof(uint32_t) * (hashBytes(key, 0) % h.bucketCount),
+                    sizeof(seed));
+        size_t slot = seed & DIRECT_SLOT ? seed & ~DIRECT_SLOT : hashBytes(key, seed) % n;
+        auto keys = reinterpret_cast<const K *>(base + h.keysOffset);
+        if (std::memcmp(&keys[slot], &key, sizeof(K)) != 0) return nullptr;
+        return reinterpret_cast<const V *>(base + h.valuesOffset) + slot;
+    }
+
+    template<typename K, typename V>
+    template<typename Entries>
+    void FrozenHashMap<K, V>::write(std::ostream &out, const Entries &entries, size_t n) {
+        if (n >= DIRECT_SLOT) throw std::length_error("Too many entries for a frozen image");
+        size_t bucketCount = n / BUCKET_LOAD + 1;
+
+        // Group entry indices by first-level bucket
+        Vector<size_t> bucketOf(n, 0);
+        Vector<size_t> bucketStart(bucketCount + 1, 0);
+        for (size_t i = 0; i < n; ++i) {
+            bucketOf[i] = hashBytes(entries[i]->first, 0) % bucketCount;
+            ++bucketStart[bucketOf[i] + 1];
+        }
+        size_t maxBucket = 0;
+        for (size_t b = 0; b < bucketCount; ++b) {
+            maxBucket = std::max(maxBucket, bucketStart[b + 1]);
+            bucketStart[b + 1] += bucketStart[b];
+        }
+        Vector<size_t> members(n, 0);
+        Vector<size_t> fill(bucketCount, 0);
+        for (size_t i = 0; i < n; ++i)
+            members[bucketStart[bucketOf[i]] + fill[bucketOf[i]]++] = i;
+
+        // Place the largest buckets first while most slots are still free
+        Vector<size_t> bySize(maxBucket + 2, 0);
+        for (size_t b = 0; b < bucketCount; ++b) ++bySize[maxBucket - (bucketStart[b + 1] - bucketStart[b]) + 1];
+        for (size_t s = 1; s < bySize.size(); ++s) bySize[s] += bySize[s - 1];
+        Vector<size_t> order(bucketCount, 0);
+        for (size_t b = 0; b < bucketCount; ++b)
+            order[bySize[maxBucket - (bucketStart[b + 1] - bucketStart[b])]++] = b;
+
+        Vector<uint32_t> seeds(bucketCount, 0);
+        Vector<size_t> slotEntry(n, 0);
+        Vector<unsigned char> taken(n, 0);
+        Vector<size_t> slots(maxBucket + 1, 0);
+        size_t freeSlot = 0;
+        for (size_t o = 0; o < bucketCount; ++o) {
+            size_t b = order[o];
+            size_t first = bucketStart[b], last = bucketStart[b + 1];
+            if (first == last) break;
+            if (last - first == 1) {
+                while (taken[freeSlot]) ++freeSlot;
+                seeds[b] = DIRECT_SLOT | static_cast<uint32_t>(freeSlot);
+                taken[freeSlot] = 1;
+                slotEntry[freeSlot] = members[first];
+                continue;
+            }
+            uint32_t seed = 1;
+            for (;; ++seed) {
+                if (seed == MAX_SEED) throw std::runtime_error("No perfect hash found, are keys unique?");
+                bool fits = true;
+                for (size_t i = first; i < last && fits; ++i) {
+                    size_t slot = hashBytes(entries[members[i]]->first, seed) % n;
+                    fits = !taken[slot];
+                    for (size_t j = first; j < i && fits; ++j) fits = slots[j - first] != slot;
+                    slots[i - first] = slot;
+                }
+                if (fits) break;
+            }
+            seeds[b] = seed;
+            for (size_t i = first; i < last; ++i) {
+                taken[slots[i - first]] = 1;
+                slotEntry[slots[i - first]] = members[i];
+            }
+        }
+
+        Header h{};
+        h.magic = MAGIC;
+        h.version = VERSION;
+        h.keySize = sizeof(K);
+        h.valueSize = sizeof(V);
+        h.count = n;
+        h.bucketCount = bucketCount;
+        h.seedsOffset = align(sizeof(Header));
+        h.keysOffset = align(h.seedsOffset + bucketCount * sizeof(uint32_t));
+        h.valuesOffset = align(h.keysOffset + n * sizeof(K));
+        h.totalSize = align(h.valuesOffset + n * sizeof(V));
+
+        const char padding[8]{};
+        size_t offset = sizeof(Header);
+        auto pad = [&](size_t to) {
+            out.write(padding, static_cast<std::streamsize>(to - offset));
+            offset = to;
+        };
+        out.write(reinterpret_cast<const char *>(&h), sizeof(Header));
+        pad(h.seedsOffset);
+        for (size_t b = 0; b < bucketCount; ++b)
+            out.write(reinterpret_cast<const char *>(&seeds[b]), sizeof(uint32_t));
+        offset += bucketCount * sizeof(uint32_t);
+        pad(h.keysOffset);
+        for (size_t s = 0; s < n; ++s)
+            out.write(reinterpret_cast<const char *>(&entries[slotEntry[s]]->first), sizeof(K));
+        offset += n * sizeof(K);
+        pad(h.valuesOffset);
+        for (size_t s = 0; s < n; ++s)
+            out.write(reinterpret_cast<const char *>(&entries[slotEntry[s]]->second), sizeof(V));
+        offset += n * sizeof(V);
+        pad(h.totalSize);
+        if (!out) throw std::runtime_error("Failed to write frozen image");
+    }
+}
+
+
+#endif //MYSTL_FROZENHASHMAP_H
@@ -5,6 +5,11 @@
 #include <exception>
 
 namespace MySTL {
+    // Satisfied by hashers and comparators that declare is_transparent, which
+    // lets associative containers look up keys with any comparable type
+    template<typename T>
+    concept Transparent = requires { typename T::is_transparent; };
+
     template<typename T>
     struct Plus {
         T operator()(const T &a, const T &b) const {
@@ -1,21 +1,72 @@
 #ifndef MYSTL_HASHMAP_H
 #define MYSTL_HASHMAP_H
 
+#include <chrono>
+#include <algorithm>
 #include <functional>
-
+#include <iterator>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+
+#include "utils/BucketPolicy.h"
+#include "utils/FrontFilter.h"
+#include "utils/HashStats.h"
+#include "utils/Prefetch.h"
+
+#include "FrozenHashMap.h"
+#include "Functional.h"
 #include "List.h"
 #include "Pair.h"
 #include "Vector.h"
 
 namespace MySTL {
+    // Policy maps hashes to buckets, see utils/BucketPolicy.h. Filter is an
+    // optional front filter (BloomFilter, CuckooFilter) consulted before any
+    // bucket is walked and rebuilt whenever the table grows, see
+    // utils/FrontFilter.h.
     template<typename K, typename V, typename Hash = std::hash<K>,
-            typename Equal = std::equal_to<K>>
+            typename Equal = std::equal_to<K>, typename Policy = FibonacciPolicy,
+            typename Filter = NoFilter>
     class HashMap {
+        using PairType = Pair<K, V>;
+        using ListType = List<PairType>;
+        using VectorType = Vector<ListType>;
+
     public:
-        explicit HashMap(size_t initCap = 16, double loadFactor = 0.75);
+        // Owns an entry detached from a map; it moves between maps by
+        // relinking its list node, so neither key nor value is copied
+        class NodeHandle {
+        public:
+            NodeHandle() = default;
+
+            [[nodiscard]] bool empty() const { return list.empty(); }
+
+            explicit operator bool() const { return !list.empty(); }
+
+            const K &key() const { return list.begin()->first; }
+
+            V &mapped() const { return list.begin()->second; }
+
+        private:
+            friend class HashMap;
+
+            ListType list;
+        };
+
+        explicit HashMap(size_t initCap = 16, double loadFactor = 0.75,
+                         bool incrementalRehash = false);
+
+        HashMap(HashMap &&other) noexcept = default;
+
+        HashMap &operator=(HashMap &&other) noexcept = default;
 
         ~HashMap() = default;
 
+        // Builds a map sized for [first, last) in a single pass
+        template<typename InputIt>
+        static HashMap build_from(InputIt first, InputIt last, double loadFactor = 0.75);
+
         [[nodiscard]] bool empty() const;
 
         [[nodiscard]] size_t size() const;
@@ -26,6 +77,42 @@ namespace MySTL {
 
         void insert(const Pair<K, V> &pair);
 
+        // Bulk insert of pair-like elements. Forward ranges are reserved up
+        // front and hashed BATCH_SIZE keys at a time, prefetching every target
+        // bucket before any of them is walked.
+        template<typename InputIt>
+        requires std::input_iterator<InputIt>
+        void insert(InputIt first, InputIt last);
+
+        // Grow the table so that n entries fit without exceeding the load factor
+        void reserve(size_t n);
+
+        // The following return the stored value and whether an insert happened
+
+        // Builds the entry from args first, keeps it only if the key is new
+        template<typename... Args>
+        Pair<V *, bool> emplace(Args &&...args);
+
+        // Constructs V from args only when the key is absent
+        template<typename... Args>
+        Pair<V *, bool> try_emplace(const K &k, Args &&...args);
+
+        template<typename... Args>
+        Pair<V *, bool> try_emplace(K &&k, Args &&...args);
+
+        template<typename M>
+        Pair<V *, bool> insert_or_assign(const K &k, M &&obj);
+
+        template<typename M>
+        Pair<V *, bool> insert_or_assign(K &&k, M &&obj);
+
+        // Unlinks the entry for key, the handle is empty if key is absent
+        NodeHandle extract(const K &key);
+
+        // Links the handle's entry in if its key is absent, otherwise the
+        // handle keeps it
+        bool insert(NodeHandle &&node);
+
         void erase(const K &key);
 
         V &at(const K &key);
@@ -36,14 +123,73 @@ namespace MySTL {
 
         V *find(const K &key);
 
+        const V *find(const K &key) const;
+
+        // As find and try_emplace, but return the stored entry with its key,
+        // for callers that link entries to each other. The key must not be
+        // modified; the entry keeps its address until it is erased.
+        Pair<K, V> *find_entry(const K &key);
+
+        const Pair<K, V> *find_entry(const K &key) const;
+
+        template<typename... Args>
+        Pair<Pair<K, V> *, bool> try_emplace_entry(const K &k, Args &&...args);
+
+        // Batched lookups: out[i] = find(keys[i]) and out[i] = contains(keys[i]).
+        // Keys are hashed BATCH_SIZE at a time and the buckets, then the first
+        // chain nodes, of the whole batch are prefetched before any key is
+        // resolved, so cache misses overlap instead of queueing one by one.
+        void find_many(std::span<const K> keys, std::span<V *> out);
+
+        // Returns how many keys were found
+        size_t contains_many(std::span<const K> keys, std::span<bool> out) const;
+
+        // Heterogeneous lookup, enabled when both Hash and Equal are transparent
+        template<typename KeyLike>
+        requires Transparent<Hash> && Transparent<Equal>
+        void erase(const KeyLike &key);
+
+        template<typename KeyLike>
+        requires Transparent<Hash> && Transparent<Equal>
+        V &at(const KeyLike &key);
+
+        template<typename KeyLike>
+        requires Transparent<Hash> && Transparent<Equal>
+        bool contains(const KeyLike &key) const;
+
+        template<typename KeyLike>
+        requires Transparent<Hash> && Transparent<Equal>
+        V *find(const KeyLike &key);
+
+        // Calls f(key, value) for every entry, in no particular order
+        template<typename F>
+        void forEach(F &&f) const;
+
         Hash &getHasher() { return hasher; }
 
         size_t getCap() { return cap; }
 
+        // In incremental mode growing the table does not move every entry at
+        // once: the old table is kept alongside the new one and each mutating
+        // operation migrates at most MIGRATE_STEP buckets.
+        void setIncrementalRehash(bool enable);
+
+        [[nodiscard]] bool isRehashing() const { return rehashing; }
+
+        // Walks every bucket, O(bucket count)
+        [[nodiscard]] HashTableStats stats() const;
+
+        // Counters only, O(1)
+        [[nodiscard]] HashTableStats snapshot() const;
+
+        // Writes the contents as a FrozenHashMap<K, V> image, which can be
+        // mmapped and queried without rebuilding the map
+        void freeze(std::ostream &out) const;
+
     private:
-        using PairType = Pair<K, V>;
-        using ListType = List<PairType>;
-        using VectorType = Vector<ListType>;
+        static constexpr size_t MIGRATE_STEP = 4;
+
+        static constexpr size_t BATCH_SIZE = 16;
 
         VectorType table;
         size_t len;
@@ -52,107 +198,590 @@ namespace MySTL {
         Hash hasher;
         Equal equal;
 
+        VectorType oldTable;
+        size_t oldCap;
+        size_t migrateIndex;
+        bool incremental;
+        bool rehashing;
+
+        size_t rehashCount;
+        std::chrono::nanoseconds rehashTime;
+
+        Filter filter;
+        // Built bucket by bucket as an incremental rehash migrates keys, and
+        // swapped in for filter when it completes, so growing never walks
+        // every key at once
+        Filter nextFilter;
+
         void rehash();
+
+        // Resizes the filter for the current capacity and re-adds every key
+        void rebuildFilter();
+
+        // Records a key added to the new table, in nextFilter as well while
+        // a rehash runs
+        void filterAdd(size_t hash);
+
+        // Drops a key from the filters; inNewTable tells whether nextFilter
+        // holds it
+        void filterRemove(size_t hash, bool inNewTable);
+
+        void rehashTo(size_t newCap);
+
+        void insertHashed(const K &k, const V &v, size_t hash);
+
+        template<typename... Args>
+        V *emplaceHashed(size_t hash, Args &&...args);
+
+        template<typename... Args>
+        PairType *emplacePair(size_t hash, Args &&...args);
+
+        void migrateBucket(size_t index);
+
+        void migrateStep();
+
+        void finishRehash();
+
+        template<typename KeyLike>
+        PairType *findPair(const KeyLike &key, size_t hash) const;
+
+        template<typename KeyLike>
+        ListType *locate(const KeyLike &key, size_t hash, typename ListType::iterator &it);
+
+        template<typename KeyLike>
+        void eraseKey(const KeyLike &key);
+
+        // Calls resolve(i, findPair(keys[i])) for every key, batched as in find_many
+        template<typename Resolve>
+        void probeMany(std::span<const K> keys, Resolve &&resolve) const;
     };
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    V *HashMap<K, V, Hash, Equal>::find(const K &key) {
-        size_t index = hasher(key) % cap;
-        for (auto &pair: table[index])
-            if (equal(pair.first, key)) return &pair.second;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    typename HashMap<K, V, Hash, Equal, Policy, Filter>::PairType *
+    HashMap<K, V, Hash, Equal, Policy, Filter>::findPair(const KeyLike &key, size_t hash) const {
+        if (!filter.mayContain(hash)) return nullptr;
+        if (rehashing) {
+            size_t oldIndex = Policy::index(hash, oldCap);
+            if (oldIndex >= migrateIndex)
+                for (auto &pair: oldTable[oldIndex])
+                    if (equal(pair.first, key)) return &pair;
+        }
+        for (auto &pair: table[Policy::index(hash, cap)])
+            if (equal(pair.first, key)) return &pair;
         return nullptr;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMap<K, V, Hash, Equal>::rehash() {
-        VectorType newTable(cap * 2);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    V *HashMap<K, V, Hash, Equal, Policy, Filter>::find(const K &key) {
+        auto pair = findPair(key, hasher(key));
+        return pair ? &pair->second : nullptr;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    const V *HashMap<K, V, Hash, Equal, Policy, Filter>::find(const K &key) const {
+        auto pair = findPair(key, hasher(key));
+        return pair ? &pair->second : nullptr;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    Pair<K, V> *HashMap<K, V, Hash, Equal, Policy, Filter>::find_entry(const K &key) {
+        return findPair(key, hasher(key));
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    const Pair<K, V> *HashMap<K, V, Hash, Equal, Policy, Filter>::find_entry(const K &key) const {
+        return findPair(key, hasher(key));
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename... Args>
+    Pair<Pair<K, V> *, bool> HashMap<K, V, Hash, Equal, Policy, Filter>::try_emplace_entry(const K &k, Args &&...args) {
+        migrateStep();
+        size_t hash = hasher(k);
+        if (auto pair = findPair(k, hash)) return Pair<PairType *, bool>(pair, false);
+        return Pair<PairType *, bool>(
+                emplacePair(hash, std::piecewise_construct, std::forward_as_tuple(k),
+                            std::forward_as_tuple(std::forward<Args>(args)...)),
+                true);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename Resolve>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::probeMany(std::span<const K> keys, Resolve &&resolve) const {
+        size_t hashes[BATCH_SIZE];
+        const ListType *lists[BATCH_SIZE];
+        for (size_t base = 0; base < keys.size(); base += BATCH_SIZE) {
+            size_t n = std::min(BATCH_SIZE, keys.size() - base);
+            // Keys the filter rules out get neither a prefetch nor a probe
+            for (size_t i = 0; i < n; ++i) {
+                hashes[i] = hasher(keys[base + i]);
+                lists[i] = nullptr;
+                if (!filter.mayContain(hashes[i])) continue;
+                lists[i] = &table[Policy::index(hashes[i], cap)];
+                prefetch(lists[i]);
+            }
+            for (size_t i = 0; i < n; ++i)
+                if (lists[i] && !lists[i]->empty()) prefetch(&*lists[i]->begin());
+            for (size_t i = 0; i < n; ++i)
+                resolve(base + i, lists[i] ? findPair(keys[base + i], hashes[i]) : nullptr);
+        }
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::find_many(std::span<const K> keys, std::span<V *> out) {
+        if (out.size() < keys.size()) throw std::invalid_argument("Output is shorter than the keys");
+        probeMany(keys, [&](size_t i, PairType *pair) { out[i] = pair ? &pair->second : nullptr; });
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    size_t HashMap<K, V, Hash, Equal, Policy, Filter>::contains_many(std::span<const K> keys,
+                                                                     std::span<bool> out) const {
+        if (out.size() < keys.size()) throw std::invalid_argument("Output is shorter than the keys");
+        size_t found = 0;
+        probeMany(keys, [&](size_t i, PairType *pair) {
+            out[i] = pair != nullptr;
+            found += out[i];
+        });
+        return found;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::rehash() {
+        if (rehashing) finishRehash();
+
+        if (incremental) {
+            auto start = std::chrono::steady_clock::now();
+            oldTable = std::move(table);
+            oldCap = cap;
+            table = VectorType(cap * 2);
+            cap *= 2;
+            migrateIndex = 0;
+            rehashing = true;
+            // filter keeps answering for every key until migration ends
+            if constexpr (Filter::enabled)
+                nextFilter.reset(static_cast<size_t>(static_cast<double>(cap) * loadFactor) + 1);
+            ++rehashCount;
+            rehashTime += std::chrono::steady_clock::now() - start;
+            return;
+        }
+
+        rehashTo(cap * 2);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::rehashTo(size_t newCap) {
+        auto start = std::chrono::steady_clock::now();
+        VectorType newTable(newCap);
         for (auto &list: table) {
-            for (auto &pair: list) {
-                size_t index = hasher(pair.first) % (cap * 2);
-                newTable[index].emplace_back(pair.first, pair.second);
+            while (!list.empty()) {
+                auto it = list.begin();
+                size_t index = Policy::index(hasher(it->first), newCap);
+                newTable[index].splice(newTable[index].end(), list, it);
             }
         }
         table = std::move(newTable);
-        cap *= 2;
+        cap = newCap;
+        rebuildFilter();
+        ++rehashCount;
+        rehashTime += std::chrono::steady_clock::now() - start;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMap<K, V, Hash, Equal>::insert(const K &k, const V &v) {
-        size_t index = hasher(k) % cap;
-        for (auto &pair: table[index]) {
-            if (equal(pair.first, k)) {
-                pair.second = v;
-                return;
-            }
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::rebuildFilter() {
+        if constexpr (Filter::enabled) {
+            filter.reset(static_cast<size_t>(static_cast<double>(cap) * loadFactor) + 1);
+            forEach([this](const K &key, const V &) { filter.add(hasher(key)); });
+        }
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::filterAdd(size_t hash) {
+        filter.add(hash);
+        if (rehashing) nextFilter.add(hash);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::filterRemove(size_t hash, bool inNewTable) {
+        filter.remove(hash);
+        if (rehashing && inNewTable) nextFilter.remove(hash);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::reserve(size_t n) {
+        finishRehash();
+        size_t newCap = cap;
+        while (static_cast<double>(n) / newCap > loadFactor) newCap *= 2;
+        if (newCap != cap) rehashTo(newCap);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::migrateBucket(size_t index) {
+        auto &list = oldTable[index];
+        while (!list.empty()) {
+            auto it = list.begin();
+            size_t hash = hasher(it->first);
+            size_t newIndex = Policy::index(hash, cap);
+            table[newIndex].splice(table[newIndex].end(), list, it);
+            nextFilter.add(hash);
+        }
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::migrateStep() {
+        if (!rehashing) return;
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < MIGRATE_STEP && migrateIndex < oldCap; ++i)
+            migrateBucket(migrateIndex++);
+        rehashTime += std::chrono::steady_clock::now() - start;
+        if (migrateIndex == oldCap) {
+            if constexpr (Filter::enabled) filter = std::move(nextFilter);
+            oldTable = VectorType(0);
+            oldCap = 0;
+            migrateIndex = 0;
+            rehashing = false;
+        }
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::finishRehash() {
+        while (rehashing) migrateStep();
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::setIncrementalRehash(bool enable) {
+        if (!enable) finishRehash();
+        incremental = enable;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::insert(const K &k, const V &v) {
+        insertHashed(k, v, hasher(k));
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::insertHashed(const K &k, const V &v, size_t hash) {
+        migrateStep();
+        if (auto pair = findPair(k, hash)) {
+            pair->second = v;
+            return;
+        }
+        emplaceHashed(hash, k, v);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename... Args>
+    V *HashMap<K, V, Hash, Equal, Policy, Filter>::emplaceHashed(size_t hash, Args &&...args) {
+        return &emplacePair(hash, std::forward<Args>(args)...)->second;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename... Args>
+    typename HashMap<K, V, Hash, Equal, Policy, Filter>::PairType *
+    HashMap<K, V, Hash, Equal, Policy, Filter>::emplacePair(size_t hash, Args &&...args) {
+        auto &pair = table[Policy::index(hash, cap)].emplace_back(std::forward<Args>(args)...);
+        ++len;
+        filterAdd(hash);
+        // Buckets are relinked, never copied, so pair stays valid across a rehash
+        if (static_cast<double>(len) / cap > loadFactor) {
+            rehash();
+        }
+        return &pair;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename... Args>
+    Pair<V *, bool> HashMap<K, V, Hash, Equal, Policy, Filter>::emplace(Args &&...args) {
+        NodeHandle node;
+        node.list.emplace_back(std::forward<Args>(args)...);
+        V *value = &node.mapped();
+        if (insert(std::move(node))) return Pair<V *, bool>(value, true);
+        return Pair<V *, bool>(find(node.key()), false);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename... Args>
+    Pair<V *, bool> HashMap<K, V, Hash, Equal, Policy, Filter>::try_emplace(const K &k, Args &&...args) {
+        migrateStep();
+        size_t hash = hasher(k);
+        if (auto pair = findPair(k, hash)) return Pair<V *, bool>(&pair->second, false);
+        return Pair<V *, bool>(
+                emplaceHashed(hash, std::piecewise_construct, std::forward_as_tuple(k),
+                              std::forward_as_tuple(std::forward<Args>(args)...)),
+                true);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename... Args>
+    Pair<V *, bool> HashMap<K, V, Hash, Equal, Policy, Filter>::try_emplace(K &&k, Args &&...args) {
+        migrateStep();
+        size_t hash = hasher(k);
+        if (auto pair = findPair(k, hash)) return Pair<V *, bool>(&pair->second, false);
+        return Pair<V *, bool>(
+                emplaceHashed(hash, std::piecewise_construct, std::forward_as_tuple(std::move(k)),
+                              std::forward_as_tuple(std::forward<Args>(args)...)),
+                true);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename M>
+    Pair<V *, bool> HashMap<K, V, Hash, Equal, Policy, Filter>::insert_or_assign(const K &k, M &&obj) {
+        migrateStep();
+        size_t hash = hasher(k);
+        if (auto pair = findPair(k, hash)) {
+            pair->second = std::forward<M>(obj);
+            return Pair<V *, bool>(&pair->second, false);
+        }
+        return Pair<V *, bool>(emplaceHashed(hash, k, std::forward<M>(obj)), true);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename M>
+    Pair<V *, bool> HashMap<K, V, Hash, Equal, Policy, Filter>::insert_or_assign(K &&k, M &&obj) {
+        migrateStep();
+        size_t hash = hasher(k);
+        if (auto pair = findPair(k, hash)) {
+            pair->second = std::forward<M>(obj);
+            return Pair<V *, bool>(&pair->second, false);
         }
-        table[index].emplace_back(k, v);
+        return Pair<V *, bool>(emplaceHashed(hash, std::move(k), std::forward<M>(obj)), true);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    typename HashMap<K, V, Hash, Equal, Policy, Filter>::NodeHandle
+    HashMap<K, V, Hash, Equal, Policy, Filter>::extract(const K &key) {
+        migrateStep();
+        NodeHandle node;
+        typename ListType::iterator it;
+        size_t hash = hasher(key);
+        if (auto list = locate(key, hash, it)) {
+            node.list.splice(node.list.end(), *list, it);
+            --len;
+            filterRemove(hash, list == &table[Policy::index(hash, cap)]);
+        }
+        return node;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    bool HashMap<K, V, Hash, Equal, Policy, Filter>::insert(NodeHandle &&node) {
+        if (node.empty()) return false;
+        migrateStep();
+        size_t hash = hasher(node.key());
+        if (findPair(node.key(), hash)) return false;
+        auto &list = table[Policy::index(hash, cap)];
+        list.splice(list.end(), node.list, node.list.begin());
         ++len;
+        filterAdd(hash);
         if (static_cast<double>(len) / cap > loadFactor) {
             rehash();
         }
+        return true;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename InputIt>
+    requires std::input_iterator<InputIt>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::insert(InputIt first, InputIt last) {
+        using Category = typename std::iterator_traits<InputIt>::iterator_category;
+        if constexpr (std::is_base_of_v<std::forward_iterator_tag, Category>) {
+            reserve(len + static_cast<size_t>(std::distance(first, last)));
+            InputIt batch[BATCH_SIZE];
+            size_t hashes[BATCH_SIZE];
+            while (first != last) {
+                size_t n = 0;
+                for (; n < BATCH_SIZE && first != last; ++n, ++first) {
+                    batch[n] = first;
+                    hashes[n] = hasher(first->first);
+                    prefetch(&table[Policy::index(hashes[n], cap)]);
+                }
+                for (size_t i = 0; i < n; ++i)
+                    insertHashed(batch[i]->first, batch[i]->second, hashes[i]);
+            }
+        } else {
+            for (; first != last; ++first) insert(first->first, first->second);
+        }
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename InputIt>
+    HashMap<K, V, Hash, Equal, Policy, Filter>
+    HashMap<K, V, Hash, Equal, Policy, Filter>::build_from(InputIt first, InputIt last, double loadFactor) {
+        HashMap map(16, loadFactor);
+        map.insert(first, last);
+        return map;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    HashMap<K, V, Hash, Equal, Policy, Filter>::HashMap(size_t initCap, double loadFactor,
+                                                bool incrementalRehash)
+            : table(Policy::capacity(initCap)), len(0), loadFactor(loadFactor),
+              cap(Policy::capacity(initCap)),
+              oldTable(0), oldCap(0), migrateIndex(0),
+              incremental(incrementalRehash), rehashing(false),
+              rehashCount(0), rehashTime(0) {
+        rebuildFilter();
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    HashTableStats HashMap<K, V, Hash, Equal, Policy, Filter>::snapshot() const {
+        HashTableStats stats;
+        stats.size = len;
+        stats.bucketCount = cap + oldCap - migrateIndex;
+        stats.loadFactor = static_cast<double>(len) / cap;
+        stats.rehashCount = rehashCount;
+        stats.rehashTime = rehashTime;
+        // List nodes carry a prev and next pointer next to the pair
+        stats.memoryBytes = sizeof(*this) + (cap + oldCap) * sizeof(ListType) +
+                            len * (sizeof(PairType) + 2 * sizeof(void *)) + filter.memoryBytes() +
+                            (rehashing ? nextFilter.memoryBytes() : 0);
+        return stats;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::freeze(std::ostream &out) const {
+        Vector<const PairType *> entries(len, nullptr);
+        size_t n = 0;
+        for (size_t i = 0; i < cap; ++i)
+            for (auto &pair: table[i]) entries[n++] = &pair;
+        if (rehashing)
+            for (size_t i = migrateIndex; i < oldCap; ++i)
+                for (auto &pair: oldTable[i]) entries[n++] = &pair;
+        FrozenHashMap<K, V>::write(out, entries, n);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename F>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::forEach(F &&f) const {
+        for (size_t i = 0; i < cap; ++i)
+            for (auto &pair: table[i]) f(pair.first, pair.second);
+        if (rehashing)
+            for (size_t i = migrateIndex; i < oldCap; ++i)
+                for (auto &pair: oldTable[i]) f(pair.first, pair.second);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    HashMap<K, V, Hash, Equal>::HashMap(size_t initCap, double loadFactor)
-            : table(initCap), len(0), loadFactor(loadFactor), cap(initCap) {}
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    HashTableStats HashMap<K, V, Hash, Equal, Policy, Filter>::stats() const {
+        auto stats = snapshot();
+        stats.addChains(table, 0, cap);
+        // Old buckets below migrateIndex are already empty
+        if (rehashing) stats.addChains(oldTable, migrateIndex, oldCap);
+        return stats;
+    }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    bool HashMap<K, V, Hash, Equal>::empty() const {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    bool HashMap<K, V, Hash, Equal, Policy, Filter>::empty() const {
         return len == 0;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    size_t HashMap<K, V, Hash, Equal>::size() const {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    size_t HashMap<K, V, Hash, Equal, Policy, Filter>::size() const {
         return len;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMap<K, V, Hash, Equal>::clear() {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::clear() {
         table.clear();
         len = 0;
         table.resize(cap);
+        oldTable = VectorType(0);
+        oldCap = 0;
+        migrateIndex = 0;
+        rehashing = false;
+        rebuildFilter();
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMap<K, V, Hash, Equal>::insert(const Pair<K, V> &pair) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::insert(const Pair<K, V> &pair) {
         insert(pair.first, pair.second);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMap<K, V, Hash, Equal>::erase(const K &key) {
-        size_t index = hasher(key) % cap;
-        for (auto it = table[index].begin(); it != table[index].end(); ++it) {
-            if (equal(it->first, key)) {
-                table[index].erase(it);
-                --len;
-                return;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::erase(const K &key) {
+        eraseKey(key);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    typename HashMap<K, V, Hash, Equal, Policy, Filter>::ListType *
+    HashMap<K, V, Hash, Equal, Policy, Filter>::locate(const KeyLike &key, size_t hash,
+                                               typename ListType::iterator &it) {
+        if (!filter.mayContain(hash)) return nullptr;
+        if (rehashing) {
+            size_t oldIndex = Policy::index(hash, oldCap);
+            if (oldIndex >= migrateIndex) {
+                auto &list = oldTable[oldIndex];
+                for (it = list.begin(); it != list.end(); ++it)
+                    if (equal(it->first, key)) return &list;
             }
         }
+        auto &list = table[Policy::index(hash, cap)];
+        for (it = list.begin(); it != list.end(); ++it)
+            if (equal(it->first, key)) return &list;
+        return nullptr;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    V &HashMap<K, V, Hash, Equal>::at(const K &key) {
-        size_t index = hasher(key) % cap;
-        for (auto &pair: table[index]) {
-            if (equal(pair.first, key)) return pair.second;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::eraseKey(const KeyLike &key) {
+        migrateStep();
+        typename ListType::iterator it;
+        size_t hash = hasher(key);
+        if (auto list = locate(key, hash, it)) {
+            list->erase(it);
+            --len;
+            filterRemove(hash, list == &table[Policy::index(hash, cap)]);
         }
-        table[index].emplace_back(key, V());
-        ++len;
-        if (static_cast<double>(len) / cap > loadFactor) rehash();
-        return table[index].back().second;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    V &HashMap<K, V, Hash, Equal>::operator[](const K &key) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    V &HashMap<K, V, Hash, Equal, Policy, Filter>::at(const K &key) {
+        migrateStep();
+        size_t hash = hasher(key);
+        if (auto pair = findPair(key, hash)) return pair->second;
+        return *emplaceHashed(hash, std::piecewise_construct, std::forward_as_tuple(key),
+                              std::forward_as_tuple());
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    V &HashMap<K, V, Hash, Equal, Policy, Filter>::operator[](const K &key) {
         return at(key);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    bool HashMap<K, V, Hash, Equal>::contains(const K &key) const {
-        size_t index = hasher(key) % cap;
-        for (auto &pair: table[index])
-            if (equal(pair.first, key)) return true;
-        return false;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    bool HashMap<K, V, Hash, Equal, Policy, Filter>::contains(const K &key) const {
+        return findPair(key, hasher(key)) != nullptr;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    requires Transparent<Hash> && Transparent<Equal>
+    void HashMap<K, V, Hash, Equal, Policy, Filter>::erase(const KeyLike &key) {
+        eraseKey(key);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    requires Transparent<Hash> && Transparent<Equal>
+    V &HashMap<K, V, Hash, Equal, Policy, Filter>::at(const KeyLike &key) {
+        migrateStep();
+        if (auto pair = findPair(key, hasher(key))) return pair->second;
+        // Only a miss pays for building the owning key
+        return at(K(key));
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    requires Transparent<Hash> && Transparent<Equal>
+    bool HashMap<K, V, Hash, Equal, Policy, Filter>::contains(const KeyLike &key) const {
+        return findPair(key, hasher(key)) != nullptr;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy, typename Filter>
+    template<typename KeyLike>
+    requires Transparent<Hash> && Transparent<Equal>
+    V *HashMap<K, V, Hash, Equal, Policy, Filter>::find(const KeyLike &key) {
+        auto pair = findPair(key, hasher(key));
+        return pair ? &pair->second : nullptr;
     }
 
 }  // namespace MySTL
@@ -1,15 +1,24 @@
 #ifndef MYSTL_HASHMULTIMAP_H
 #define MYSTL_HASHMULTIMAP_H
 
+#include <chrono>
 #include <functional>
+#include <span>
+
+#include "utils/BucketPolicy.h"
+#include "utils/HashStats.h"
 
 #include "List.h"
 #include "Pair.h"
+#include "SmallVector.h"
 #include "Vector.h"
 
 namespace MySTL {
+    // Values are grouped per distinct key: each chain entry holds a key and a
+    // contiguous SmallVector of its values, so count is O(1) after the key is
+    // found and find hands out a view instead of copying.
     template<typename K, typename V, typename Hash = std::hash<K>,
-            typename Equal = std::equal_to<K> >
+            typename Equal = std::equal_to<K>, typename Policy = FibonacciPolicy>
     class HashMultiMap {
     public:
         explicit HashMultiMap(size_t initCap = 16, double loadFactor = 0.75);
@@ -28,129 +37,206 @@ namespace MySTL {
 
         size_t erase(const K &key);
 
+        // Removes the first occurrence of value under key
         void erase(const K &key, const V &value);
 
         bool contains(const K &key) const;
 
-        List<V> find(const K &key) const;
+        // Values of key in insertion order, empty if absent. The view is
+        // invalidated by the next insert or erase of the same key.
+        std::span<const V> find(const K &key) const;
 
         size_t count(const K &key) const;
 
+        // Number of distinct keys
+        [[nodiscard]] size_t keyCount() const;
+
+        // Walks every bucket, O(bucket count)
+        [[nodiscard]] HashTableStats stats() const;
+
+        // Counters only, O(1). Value storage spilled out of the inline
+        // groups is only counted by stats().
+        [[nodiscard]] HashTableStats snapshot() const;
+
     private:
-        using PairType = Pair<K, V>;
+        static constexpr size_t GROUP_INLINE = 2;
+
+        using GroupType = SmallVector<V, GROUP_INLINE>;
+        using PairType = Pair<K, GroupType>;
         using ListType = List<PairType>;
         using VectorType = Vector<ListType>;
 
         VectorType table;
+        // Values and distinct keys; the load factor is taken over keys
         size_t len;
+        size_t keys;
         double loadFactor;
         size_t cap;
         Hash hasher;
         Equal equal;
 
+        size_t rehashCount;
+        std::chrono::nanoseconds rehashTime;
+
         void rehash();
+
+        const GroupType *findGroup(const K &key) const;
     };
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    size_t HashMultiMap<K, V, Hash, Equal>::count(const K &key) const {
-        size_t index = hasher(key) % cap;
-        size_t count = 0;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    const typename HashMultiMap<K, V, Hash, Equal, Policy>::GroupType *
+    HashMultiMap<K, V, Hash, Equal, Policy>::findGroup(const K &key) const {
+        size_t index = Policy::index(hasher(key), cap);
         for (auto &pair: table[index])
-            if (equal(pair.first, key)) ++count;
-        return count;
+            if (equal(pair.first, key)) return &pair.second;
+        return nullptr;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    List<V> HashMultiMap<K, V, Hash, Equal>::find(const K &key) const {
-        size_t index = hasher(key) % cap;
-        List<V> res;
-        for (auto &pair: table[index])
-            if (equal(pair.first, key)) res.push_back(pair.second);
-        return res;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    size_t HashMultiMap<K, V, Hash, Equal, Policy>::count(const K &key) const {
+        auto group = findGroup(key);
+        return group ? group->size() : 0;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    std::span<const V> HashMultiMap<K, V, Hash, Equal, Policy>::find(const K &key) const {
+        auto group = findGroup(key);
+        if (group == nullptr) return {};
+        return {group->data(), group->size()};
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    size_t HashMultiMap<K, V, Hash, Equal, Policy>::keyCount() const {
+        return keys;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMultiMap<K, V, Hash, Equal>::rehash() {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void HashMultiMap<K, V, Hash, Equal, Policy>::rehash() {
+        auto start = std::chrono::steady_clock::now();
         VectorType newTable(cap * 2);
         for (auto &list: table) {
-            for (auto &pair: list) {
-                size_t index = hasher(pair.first) % (cap * 2);
-                newTable[index].emplace_back(pair.first, pair.second);
+            while (!list.empty()) {
+                auto it = list.begin();
+                size_t index = Policy::index(hasher(it->first), cap * 2);
+                newTable[index].splice(newTable[index].end(), list, it);
             }
         }
         table = std::move(newTable);
         cap *= 2;
+        ++rehashCount;
+        rehashTime += std::chrono::steady_clock::now() - start;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMultiMap<K, V, Hash, Equal>::insert(const K &k, const V &v) {
-        size_t index = hasher(k) % cap;
-        table[index].emplace_back(k, v);
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void HashMultiMap<K, V, Hash, Equal, Policy>::insert(const K &k, const V &v) {
+        size_t index = Policy::index(hasher(k), cap);
         ++len;
-        if (static_cast<double>(len) / cap > loadFactor) {
+        for (auto &pair: table[index]) {
+            if (equal(pair.first, k)) {
+                pair.second.push_back(v);
+                return;
+            }
+        }
+        table[index].emplace_back(k, GroupType()).second.push_back(v);
+        ++keys;
+        if (static_cast<double>(keys) / cap > loadFactor) {
             rehash();
         }
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    HashMultiMap<K, V, Hash, Equal>::HashMultiMap(size_t initCap, double loadFactor)
-            : table(initCap), len(0), loadFactor(loadFactor), cap(initCap) {}
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    HashMultiMap<K, V, Hash, Equal, Policy>::HashMultiMap(size_t initCap, double loadFactor)
+            : table(Policy::capacity(initCap)), len(0), keys(0), loadFactor(loadFactor),
+              cap(Policy::capacity(initCap)),
+              rehashCount(0), rehashTime(0) {}
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    HashTableStats HashMultiMap<K, V, Hash, Equal, Policy>::snapshot() const {
+        // Chains hold one entry per distinct key, so size counts keys
+        HashTableStats stats;
+        stats.size = keys;
+        stats.bucketCount = cap;
+        stats.loadFactor = static_cast<double>(keys) / cap;
+        stats.rehashCount = rehashCount;
+        stats.rehashTime = rehashTime;
+        // List nodes carry a prev and next pointer next to the pair
+        stats.memoryBytes = sizeof(*this) + cap * sizeof(ListType) +
+                            keys * (sizeof(PairType) + 2 * sizeof(void *));
+        return stats;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    HashTableStats HashMultiMap<K, V, Hash, Equal, Policy>::stats() const {
+        auto stats = snapshot();
+        stats.addChains(table, 0, cap);
+        for (size_t i = 0; i < cap; ++i)
+            for (auto &pair: table[i]) stats.memoryBytes += pair.second.heapBytes();
+        return stats;
+    }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    bool HashMultiMap<K, V, Hash, Equal>::empty() const {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    bool HashMultiMap<K, V, Hash, Equal, Policy>::empty() const {
         return len == 0;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    size_t HashMultiMap<K, V, Hash, Equal>::size() const {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    size_t HashMultiMap<K, V, Hash, Equal, Policy>::size() const {
         return len;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMultiMap<K, V, Hash, Equal>::clear() {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void HashMultiMap<K, V, Hash, Equal, Policy>::clear() {
         for (auto &x: table) x.clear();
         table.clear();
         len = 0;
+        keys = 0;
         table.resize(cap);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMultiMap<K, V, Hash, Equal>::insert(const Pair<K, V> &pair) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void HashMultiMap<K, V, Hash, Equal, Policy>::insert(const Pair<K, V> &pair) {
         insert(pair.first, pair.second);
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    size_t HashMultiMap<K, V, Hash, Equal>::erase(const K &key) {
-        size_t index = hasher(key) % cap;
-        int count = 0;
-        for (auto it = table[index].begin(); it != table[index].end();) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    size_t HashMultiMap<K, V, Hash, Equal, Policy>::erase(const K &key) {
+        size_t index = Policy::index(hasher(key), cap);
+        for (auto it = table[index].begin(); it != table[index].end(); ++it) {
             if (equal(it->first, key)) {
-                it = table[index].erase(it);
-                --len;
-                ++count;
-            } else ++it;
+                size_t count = it->second.size();
+                table[index].erase(it);
+                len -= count;
+                --keys;
+                return count;
+            }
         }
-        return count;
+        return 0;
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    void HashMultiMap<K, V, Hash, Equal>::erase(const K &key, const V &value) {
-        size_t index = hasher(key) % cap;
-        for (auto it = table[index].begin(); it != table[index].end();) {
-            if (equal(it->first, key) && it->second == value) {
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    void HashMultiMap<K, V, Hash, Equal, Policy>::erase(const K &key, const V &value) {
+        size_t index = Policy::index(hasher(key), cap);
+        for (auto it = table[index].begin(); it != table[index].end(); ++it) {
+            if (!equal(it->first, key)) continue;
+            auto &group = it->second;
+            for (size_t i = 0; i < group.size(); ++i) {
+                if (group[i] == value) {
+                    group.erase(i);
+                    --len;
+                    break;
+                }
+            }
+            if (group.empty()) {
                 table[index].erase(it);
-                --len;
-                break;
-            } else ++it;
+                --keys;
+            }
+            return;
         }
     }
 
-    template<typename K, typename V, typename Hash, typename Equal>
-    bool HashMultiMap<K, V, Hash, Equal>::contains(const K &key) const {
-        size_t index = hasher(key) % cap;
-        for (auto &pair: table[index])
-            if (equal(pair.first, key)) return true;
-        return false;
+    template<typename K, typename V, typename Hash, typename Equal, typename Policy>
+    bool HashMultiMap<K, V, Hash, Equal, Policy>::contains(const K &key) const {
+        return findGroup(key) != nullptr;
     }
 
 }  // namespace MySTL
@@ -1,72 +1,260 @@
 #ifndef MYSTL_HASHMULTISET_H
 #define MYSTL_HASHMULTISET_H
 
-#include "HashMultiMap.h"
+#include <algorithm>
+#include <stdexcept>
+
+#include "HashMap.h"
+#include "Pair.h"
+#include "SmallVector.h"
+#include "Vector.h"
 
 
 namespace MySTL {
 
+    // Stores each distinct element once together with its count, so
+    // duplicates cost nothing and count/insert/erase_one are O(1).
+    //
+    // With topCapacity > 0 the topCapacity most frequent elements are kept in
+    // a min-heap that inserts update incrementally. Lowering the count of a
+    // tracked element may let an untracked one overtake it, so it marks the
+    // heap stale and the next top_k rebuilds it with one pass over the counts.
     template<typename T, typename Hash = std::hash<T>, typename Equal = std::equal_to<T>>
     class HashMultiSet {
     public:
-        explicit HashMultiSet(size_t initCap = 16, double loadFactor = 0.75);
+        explicit HashMultiSet(size_t initCap = 16, double loadFactor = 0.75, size_t topCapacity = 0);
 
         [[nodiscard]] bool empty() const;
 
+        // Number of occurrences, duplicates included
         [[nodiscard]] size_t size() const;
 
+        [[nodiscard]] size_t distinctCount() const;
+
         void clear();
 
-        void insert(const T &t);
+        // Adds n occurrences of t
+        void insert(const T &t, size_t n = 1);
 
-        void erase(const T &t);
+        // Removes one occurrence, returns false if t is absent
+        bool erase_one(const T &t);
+
+        // Removes every occurrence, returns how many there were
+        size_t erase(const T &t);
 
         bool contains(const T &t) const;
 
         size_t count(const T &t) const;
 
+        // The k most frequent elements with their counts, most frequent
+        // first. k beyond the tracked capacity costs a pass over the counts.
+        Vector<Pair<T, size_t>> top_k(size_t k);
+
+        // Adds every occurrence in other, e.g. a per-thread partial count
+        void merge(const HashMultiSet &other);
+
     private:
-        HashMultiMap<T, bool, Hash, Equal> hashMap;
+        using Entry = Pair<T, size_t>;
+        using Heap = SmallVector<Entry, 8>;
+
+        HashMap<T, size_t, Hash, Equal> counts;
+        size_t len;
+
+        size_t topCapacity;
+        // Min-heap on count, heapIndex maps a tracked element to its slot
+        Heap heap;
+        HashMap<T, size_t, Hash, Equal> heapIndex;
+        bool topStale;
+
+        static bool moreFrequent(const Entry &a, const Entry &b) { return a.second > b.second; }
+
+        void track(const T &t, size_t c);
+
+        void untrack(const T &t);
+
+        // Min-heap of the k most frequent elements, from a pass over the counts
+        Heap scanTop(size_t k) const;
+
+        void rebuildTop();
+
+        void place(size_t i, Entry entry);
+
+        void siftUp(size_t i);
+
+        void siftDown(size_t i);
     };
 
     template<typename T, typename Hash, typename Equal>
-    HashMultiSet<T, Hash, Equal>::HashMultiSet(size_t initCap, double loadFactor) {
-        hashMap = HashMultiMap<T, bool, Hash, Equal>(initCap, loadFactor);
-    }
+    HashMultiSet<T, Hash, Equal>::HashMultiSet(size_t initCap, double loadFactor, size_t topCapacity)
+            : counts(initCap, loadFactor), len(0), topCapacity(topCapacity), topStale(false) {}
 
     template<typename T, typename Hash, typename Equal>
     bool HashMultiSet<T, Hash, Equal>::empty() const {
-        return hashMap.empty();
+        return len == 0;
     }
 
     template<typename T, typename Hash, typename Equal>
     size_t HashMultiSet<T, Hash, Equal>::size() const {
-        return hashMap.size();
+        return len;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    size_t HashMultiSet<T, Hash, Equal>::distinctCount() const {
+        return counts.size();
     }
 
     template<typename T, typename Hash, typename Equal>
     void HashMultiSet<T, Hash, Equal>::clear() {
-        hashMap.clear();
+        counts.clear();
+        len = 0;
+        heap.clear();
+        heapIndex.clear();
+        topStale = false;
     }
 
     template<typename T, typename Hash, typename Equal>
-    void HashMultiSet<T, Hash, Equal>::insert(const T &t) {
-        hashMap.insert(t, true);
+    void HashMultiSet<T, Hash, Equal>::insert(const T &t, size_t n) {
+        if (n == 0) return;
+        auto res = counts.try_emplace(t, 0);
+        *res.first += n;
+        len += n;
+        track(t, *res.first);
     }
 
     template<typename T, typename Hash, typename Equal>
-    void HashMultiSet<T, Hash, Equal>::erase(const T &t) {
-        hashMap.erase(t);
+    bool HashMultiSet<T, Hash, Equal>::erase_one(const T &t) {
+        auto c = counts.find(t);
+        if (c == nullptr) return false;
+        untrack(t);
+        --len;
+        if (--*c == 0) counts.erase(t);
+        return true;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    size_t HashMultiSet<T, Hash, Equal>::erase(const T &t) {
+        auto c = counts.find(t);
+        if (c == nullptr) return 0;
+        size_t removed = *c;
+        untrack(t);
+        len -= removed;
+        counts.erase(t);
+        return removed;
     }
 
     template<typename T, typename Hash, typename Equal>
     bool HashMultiSet<T, Hash, Equal>::contains(const T &t) const {
-        return hashMap.contains(t);
+        return counts.contains(t);
     }
 
     template<typename T, typename Hash, typename Equal>
     size_t HashMultiSet<T, Hash, Equal>::count(const T &t) const {
-        return hashMap.count(t);
+        auto c = counts.find(t);
+        return c ? *c : 0;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    Vector<Pair<T, size_t>> HashMultiSet<T, Hash, Equal>::top_k(size_t k) {
+        Heap top;
+        if (k > topCapacity) {
+            top = scanTop(k);
+        } else {
+            if (topStale) rebuildTop();
+            top = heap;
+        }
+        std::sort(top.begin(), top.end(), moreFrequent);
+        size_t n = std::min(k, top.size());
+        Vector<Entry> res(n);
+        for (size_t i = 0; i < n; ++i) res[i] = top[i];
+        return res;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::merge(const HashMultiSet &other) {
+        if (this == &other) throw std::invalid_argument("Cannot merge a multiset into itself");
+        other.counts.forEach([this](const T &t, size_t c) { insert(t, c); });
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::track(const T &t, size_t c) {
+        if (topCapacity == 0 || topStale) return;
+        if (auto slot = heapIndex.find(t)) {
+            // A larger count moves the element away from the minimum
+            heap[*slot].second = c;
+            siftDown(*slot);
+        } else if (heap.size() < topCapacity) {
+            heap.emplace_back(t, c);
+            heapIndex.insert(t, heap.size() - 1);
+            siftUp(heap.size() - 1);
+        } else if (c > heap[0].second) {
+            heapIndex.erase(heap[0].first);
+            heapIndex.insert(t, size_t{0});
+            place(0, Entry(t, c));
+            siftDown(0);
+        }
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::untrack(const T &t) {
+        if (topCapacity == 0 || topStale) return;
+        if (heapIndex.contains(t)) topStale = true;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    typename HashMultiSet<T, Hash, Equal>::Heap HashMultiSet<T, Hash, Equal>::scanTop(size_t k) const {
+        Heap top;
+        if (k == 0) return top;
+        counts.forEach([&](const T &t, size_t c) {
+            if (top.size() < k) {
+                top.emplace_back(t, c);
+                std::push_heap(top.begin(), top.end(), moreFrequent);
+            } else if (c > top[0].second) {
+                std::pop_heap(top.begin(), top.end(), moreFrequent);
+                top.back() = Entry(t, c);
+                std::push_heap(top.begin(), top.end(), moreFrequent);
+            }
+        });
+        return top;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::rebuildTop() {
+        heap = scanTop(topCapacity);
+        heapIndex.clear();
+        for (size_t i = 0; i < heap.size(); ++i) heapIndex.insert(heap[i].first, i);
+        topStale = false;
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::place(size_t i, Entry entry) {
+        heapIndex.at(entry.first) = i;
+        heap[i] = std::move(entry);
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::siftUp(size_t i) {
+        Entry entry = std::move(heap[i]);
+        while (i > 0) {
+            size_t parent = (i - 1) / 2;
+            if (heap[parent].second <= entry.second) break;
+            place(i, std::move(heap[parent]));
+            i = parent;
+        }
+        place(i, std::move(entry));
+    }
+
+    template<typename T, typename Hash, typename Equal>
+    void HashMultiSet<T, Hash, Equal>::siftDown(size_t i) {
+        Entry entry = std::move(heap[i]);
+        size_t n = heap.size();
+        while (2 * i + 1 < n) {
+            size_t child = 2 * i + 1;
+            if (child + 1 < n && heap[child + 1].second < heap[child].second) ++child;
+            if (entry.second <= heap[child].second) break;
+            place(i, std::move(heap[child]));
+            i = child;
+        }
+        place(i, std::move(entry));
     }
 }
 
@@ -4,8 +4,9 @@
 #include "HashMap.h"
 
 namespace MySTL {
+    // Filter is an optional front filter, see HashMap
     template<typename T, typename Hash = std::hash<T>,
-            typename Equal = std::equal_to<T> >
+            typename Equal = std::equal_to<T>, typename Filter = NoFilter>
     class HashSet {
     public:
         explicit HashSet(const size_t &initialCap = 16,
@@ -23,44 +24,74 @@ namespace MySTL {
 
         bool contains(const T &t) const;
 
+        // Batched contains with prefetching, see HashMap::contains_many
+        size_t contains_many(std::span<const T> keys, std::span<bool> out) const;
+
+        template<typename KeyLike>
+        requires Transparent<Hash> && Transparent<Equal>
+        void erase(const KeyLike &key);
+
+        template<typename KeyLike>
+        requires Transparent<Hash> && Transparent<Equal>
+        bool contains(const KeyLike &key) const;
+
         void clear();
 
     private:
-        HashMap<T, bool, Hash, Equal> hashMap;
+        HashMap<T, bool, Hash, Equal, FibonacciPolicy, Filter> hashMap;
     };
 
-    template<typename T, typename Hash, typename Equal>
-    HashSet<T, Hash, Equal>::HashSet(const size_t &initialCap,
-                                     const double &loadFactor)
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    HashSet<T, Hash, Equal, Filter>::HashSet(const size_t &initialCap,
+                                             const double &loadFactor)
             : hashMap(initialCap, loadFactor) {}
 
-    template<typename T, typename Hash, typename Equal>
-    bool HashSet<T, Hash, Equal>::empty() const {
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    bool HashSet<T, Hash, Equal, Filter>::empty() const {
         return hashMap.empty();
     }
 
-    template<typename T, typename Hash, typename Equal>
-    size_t HashSet<T, Hash, Equal>::size() const {
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    size_t HashSet<T, Hash, Equal, Filter>::size() const {
         return hashMap.size();
     }
 
-    template<typename T, typename Hash, typename Equal>
-    void HashSet<T, Hash, Equal>::insert(const T &t) {
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    void HashSet<T, Hash, Equal, Filter>::insert(const T &t) {
         hashMap.insert(t, true);
     }
 
-    template<typename T, typename Hash, typename Equal>
-    void HashSet<T, Hash, Equal>::erase(const T &t) {
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    void HashSet<T, Hash, Equal, Filter>::erase(const T &t) {
         hashMap.erase(t);
     }
 
-    template<typename T, typename Hash, typename Equal>
-    bool HashSet<T, Hash, Equal>::contains(const T &t) const {
-        return hashMap.contains(t, true);
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    bool HashSet<T, Hash, Equal, Filter>::contains(const T &t) const {
+        return hashMap.contains(t);
+    }
+
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    size_t HashSet<T, Hash, Equal, Filter>::contains_many(std::span<const T> keys, std::span<bool> out) const {
+        return hashMap.contains_many(keys, out);
+    }
+
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    template<typename KeyLike>
+    requires Transparent<Hash> && Transparent<Equal>
+    void HashSet<T, Hash, Equal, Filter>::erase(const KeyLike &key) {
+        hashMap.erase(key);
+    }
+
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    template<typename KeyLike>
+    requires Transparent<Hash> && Transparent<Equal>
+    bool HashSet<T, Hash, Equal, Filter>::contains(const KeyLike &key) const {
+        return hashMap.contains(key);
     }
 
-    template<typename T, typename Hash, typename Equal>
-    void HashSet<T, Hash, Equal>::clear() {
+    template<typename T, typename Hash, typename Equal, typename Filter>
+    void HashSet<T, Hash, Equal, Filter>::clear() {
         hashMap.clear();
     }
 
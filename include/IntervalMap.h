@@ -0,0 +1,188 @@
+#ifndef MYSTL_INTERVALMAP_H
+#define MYSTL_INTERVALMAP_H
+
+#include <ranges>
+#include <stdexcept>
+
+#include "MultiMap.h"
+
+namespace MySTL {
+
+    // Map from half-open intervals [low, high) to values, several of which may
+    // share bounds. It is a MultiMap keyed by low whose nodes also keep the
+    // largest high in their subtree, so overlap and stabbing queries skip
+    // every subtree that ends before the query starts: each reported interval
+    // costs O(log n) at most, and a query that finds nothing O(log n).
+    //
+    // Compare is default constructed to order high ends.
+    template<typename K, typename V, typename Compare = std::less<K>, typename Alloc = PoolAllocator<Pair<K, V>>>
+    class IntervalMap {
+        struct Entry {
+            K high;
+            // Largest high in the subtree
+            K maxHigh;
+            V value;
+        };
+
+        // Max-endpoint augmentation
+        struct MaxHigh {
+            static constexpr bool enabled = true;
+
+            template<typename Node>
+            static void update(Node *x) {
+                Compare cmp;
+                auto &entry = x->value();
+                entry.maxHigh = entry.high;
+                if (x->left != nullptr && cmp(entry.maxHigh, x->left->value().maxHigh))
+                    entry.maxHigh = x->left->value().maxHigh;
+                if (x->right != nullptr && cmp(entry.maxHigh, x->right->value().maxHigh))
+                    entry.maxHigh = x->right->value().maxHigh;
+            }
+        };
+
+        using TreeType = MultiMap<K, Entry, Compare, Alloc, false, MaxHigh>;
+        using Node = RBTreeNode<K, Entry, false>;
+
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using difference_type = std::ptrdiff_t;
+
+            explicit Iterator(typename TreeType::iterator it) : it(it) {}
+
+            const K &low() const { return it->first; }
+
+            const K &high() const { return it->second.high; }
+
+            V &value() const { return it->second.value; }
+
+            Iterator &operator++() {
+                ++it;
+                return *this;
+            }
+
+            Iterator &operator--() {
+                --it;
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const { return it == other.it; }
+
+            bool operator!=(const Iterator &other) const { return it != other.it; }
+
+        private:
+            friend class IntervalMap;
+
+            typename TreeType::iterator it;
+        };
+
+        using iterator = Iterator;
+
+        IntervalMap() = default;
+
+        // Builds from entries whose first is an interval (low and high as its
+        // first and second) and second a value, ascending by low, in O(n).
+        // Throws std::invalid_argument when a low descends or an interval is empty.
+        template<typename ForwardIt>
+        static IntervalMap from_sorted(ForwardIt first, ForwardIt last);
+
+        [[nodiscard]] bool empty() const { return tree.empty(); }
+
+        [[nodiscard]] size_t size() const { return tree.size(); }
+
+        // Throws std::invalid_argument unless low < high
+        void insert(const K &low, const K &high, const V &value);
+
+        // Erases every entry for exactly [low, high) and returns how many
+        size_t erase(const K &low, const K &high);
+
+        iterator erase(iterator pos) { return iterator(tree.erase(pos.it)); }
+
+        void clear() { tree.clear(); }
+
+        // Calls fn(low, high, value) for every interval overlapping [lo, hi),
+        // by ascending low
+        template<typename Fn>
+        void overlapping(const K &lo, const K &hi, Fn &&fn);
+
+        // Calls fn(low, high, value) for every interval containing point, by
+        // ascending low
+        template<typename Fn>
+        void stabbing(const K &point, Fn &&fn);
+
+        iterator begin() { return iterator(tree.begin()); }
+
+        iterator end() { return iterator(tree.end()); }
+
+    private:
+        TreeType tree;
+
+        explicit IntervalMap(TreeType &&tree) : tree(std::move(tree)) {}
+
+        // Visits the intervals in x's subtree that end after lo and start
+        // before hi, or at hi too when closed
+        template<typename Fn>
+        void visit(Node *x, const K &lo, const K &hi, bool closed, Fn &fn);
+    };
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    template<typename ForwardIt>
+    IntervalMap<K, V, Compare, Alloc> IntervalMap<K, V, Compare, Alloc>::from_sorted(ForwardIt first, ForwardIt last) {
+        auto entries = std::ranges::subrange(first, last) | std::views::transform([](const auto &entry) {
+            const auto &[low, high] = entry.first;
+            if (!Compare()(low, high)) throw std::invalid_argument("Interval must have low < high");
+            return Pair<K, Entry>(low, Entry{high, high, entry.second});
+        });
+        return IntervalMap(TreeType::from_sorted(entries.begin(), entries.end()));
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    void IntervalMap<K, V, Compare, Alloc>::insert(const K &low, const K &high, const V &value) {
+        if (!tree.cmp(low, high)) throw std::invalid_argument("Interval must have low < high");
+        tree.insert(low, Entry{high, high, value});
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    size_t IntervalMap<K, V, Compare, Alloc>::erase(const K &low, const K &high) {
+        const auto &cmp = tree.cmp;
+        size_t count = 0;
+        for (auto it = tree.lower_bound(low); it != tree.end() && !cmp(low, it->first);) {
+            if (!cmp(it->second.high, high) && !cmp(high, it->second.high)) {
+                it = tree.erase(it);
+                ++count;
+            } else {
+                ++it;
+            }
+        }
+        return count;
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    template<typename Fn>
+    void IntervalMap<K, V, Compare, Alloc>::overlapping(const K &lo, const K &hi, Fn &&fn) {
+        if (tree.cmp(lo, hi)) visit(tree.root, lo, hi, false, fn);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    template<typename Fn>
+    void IntervalMap<K, V, Compare, Alloc>::stabbing(const K &point, Fn &&fn) {
+        visit(tree.root, point, point, true, fn);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc>
+    template<typename Fn>
+    void IntervalMap<K, V, Compare, Alloc>::visit(Node *x, const K &lo, const K &hi, bool closed, Fn &fn) {
+        const auto &cmp = tree.cmp;
+        // Nothing below ends after lo
+        if (x == nullptr || !cmp(lo, x->value().maxHigh)) return;
+        visit(x->left, lo, hi, closed, fn);
+        // Right of x every low is at least x's
+        if (closed ? cmp(hi, x->key()) : !cmp(x->key(), hi)) return;
+        if (cmp(lo, x->value().high)) fn(x->key(), x->value().high, x->value().value);
+        visit(x->right, lo, hi, closed, fn);
+    }
+
+}  // namespace MySTL
+
+#endif  // MYSTL_INTERVALMAP_H
@@ -0,0 +1,268 @@
+#ifndef MYSTL_LFUCACHE_H
+#define MYSTL_LFUCACHE_H
+
+#include <functional>
+#include <limits>
+#include <utility>
+
+#include "HashMap.h"
+#include "List.h"
+
+namespace MySTL {
+    // Least frequently used cache with O(1) get, put and eviction. Entries
+    // are grouped in frequency buckets kept in ascending order; a hit relinks
+    // the entry into the bucket for the next frequency, creating that bucket
+    // when it is missing and dropping the old one when it empties. Within a
+    // bucket entries are ordered by recency, so ties evict the least recently
+    // used. Each map entry carries the links of its bucket's intrusive
+    // list, pointing at the map's own slots so the key is stored once; they
+    // stay valid as the map relinks rather than moves its nodes, so
+    // inserting a new key allocates only its map node.
+    //
+    // Limits and the eviction callback behave as in LruCache.
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    class LfuCache {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+        using hasher = Hash;
+        // Called with each entry evicted to make room, not for erase or clear.
+        // It must not call back into the cache.
+        using EvictionCallback = std::function<void(const K &, V &)>;
+
+        explicit LfuCache(size_t maxEntries, size_t maxCost = std::numeric_limits<size_t>::max());
+
+        // The moved-from cache is left empty
+        LfuCache(LfuCache &&other) noexcept;
+
+        LfuCache &operator=(LfuCache &&other) noexcept;
+
+        // Counts a use of the entry, nullptr on a miss
+        V *get(const K &key);
+
+        // Looks the entry up without counting a use
+        const V *peek(const K &key) const;
+
+        // Frequency of the entry, 0 if absent
+        size_t frequency(const K &key) const;
+
+        // Inserts the entry with frequency 1, or replaces the value of an
+        // existing one and counts a use. Returns false, storing nothing, if
+        // cost alone exceeds maxCost.
+        bool put(const K &key, V value, size_t cost = 1);
+
+        bool erase(const K &key);
+
+        bool contains(const K &key) const;
+
+        [[nodiscard]] bool empty() const { return len == 0; }
+
+        [[nodiscard]] size_t size() const { return len; }
+
+        [[nodiscard]] size_t totalCost() const { return costSum; }
+
+        [[nodiscard]] size_t maxEntries() const { return entryLimit; }
+
+        [[nodiscard]] size_t maxCost() const { return costLimit; }
+
+        void clear();
+
+        void setEvictionCallback(EvictionCallback callback) { onEvict = std::move(callback); }
+
+    private:
+        struct Bucket;
+        struct Entry;
+
+        using BucketList = List<Bucket>;
+        // A map slot: the key and its entry
+        using Slot = Pair<K, Entry>;
+
+        struct Entry {
+            V value;
+            size_t cost;
+            typename BucketList::iterator bucket;
+            Slot *prev;
+            Slot *next;
+        };
+
+        struct Bucket {
+            size_t frequency;
+            // Least recently used first
+            Slot *head;
+            Slot *tail;
+        };
+
+        // Lowest frequency at the front
+        BucketList buckets;
+        HashMap<K, Entry, Hash, Equal> index;
+        size_t len;
+        size_t entryLimit;
+        size_t costLimit;
+        size_t costSum;
+        EvictionCallback onEvict;
+
+        void touch(Slot *slot);
+
+        // Least frequently used entry other than keep
+        Slot *leastUsed(const Slot *keep = nullptr) const;
+
+        void evict(Slot *victim);
+
+        // Removes the entry from its bucket, dropping the bucket when it empties
+        void unlink(Slot *slot);
+
+        // Links the entry at the back of bucket
+        static void append(typename BucketList::iterator bucket, Slot *slot);
+
+        // Unlinks the entry from its bucket's list only
+        static void detach(Slot *slot);
+    };
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    LfuCache<K, V, Hash, Equal>::LfuCache(size_t maxEntries, size_t maxCost)
+            : len(0), entryLimit(maxEntries), costLimit(maxCost), costSum(0) {}
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    LfuCache<K, V, Hash, Equal>::LfuCache(LfuCache &&other) noexcept
+            : buckets(std::move(other.buckets)), index(std::move(other.index)), len(std::exchange(other.len, 0)),
+              entryLimit(other.entryLimit), costLimit(other.costLimit), costSum(std::exchange(other.costSum, 0)),
+              onEvict(std::move(other.onEvict)) {
+        other.index = HashMap<K, Entry, Hash, Equal>();
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    LfuCache<K, V, Hash, Equal> &LfuCache<K, V, Hash, Equal>::operator=(LfuCache &&other) noexcept {
+        if (this == &other) return *this;
+        buckets = std::move(other.buckets);
+        index = std::exchange(other.index, HashMap<K, Entry, Hash, Equal>());
+        len = std::exchange(other.len, 0);
+        entryLimit = other.entryLimit;
+        costLimit = other.costLimit;
+        costSum = std::exchange(other.costSum, 0);
+        onEvict = std::move(other.onEvict);
+        return *this;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    V *LfuCache<K, V, Hash, Equal>::get(const K &key) {
+        auto slot = index.find_entry(key);
+        if (slot == nullptr) return nullptr;
+        touch(slot);
+        return &slot->second.value;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    const V *LfuCache<K, V, Hash, Equal>::peek(const K &key) const {
+        auto entry = index.find(key);
+        return entry ? &entry->value : nullptr;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    size_t LfuCache<K, V, Hash, Equal>::frequency(const K &key) const {
+        auto entry = index.find(key);
+        return entry ? entry->bucket->frequency : 0;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    bool LfuCache<K, V, Hash, Equal>::put(const K &key, V value, size_t cost) {
+        if (cost > costLimit || entryLimit == 0) return false;
+        if (auto slot = index.find_entry(key)) {
+            auto &entry = slot->second;
+            entry.value = std::move(value);
+            costSum = costSum - entry.cost + cost;
+            entry.cost = cost;
+            touch(slot);
+            // cost <= maxCost, so the limit holds before the updated entry is reached
+            while (costSum > costLimit) evict(leastUsed(slot));
+            return true;
+        }
+        while (len > 0 && (len >= entryLimit || costSum + cost > costLimit)) evict(leastUsed());
+        if (buckets.empty() || buckets.begin()->frequency != 1)
+            buckets.emplace(buckets.begin(), Bucket{1, nullptr, nullptr});
+        auto bucket = buckets.begin();
+        append(bucket, index.try_emplace_entry(key, Entry{std::move(value), cost, bucket, nullptr, nullptr}).first);
+        ++len;
+        costSum += cost;
+        return true;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    bool LfuCache<K, V, Hash, Equal>::erase(const K &key) {
+        auto slot = index.find_entry(key);
+        if (slot == nullptr) return false;
+        unlink(slot);
+        index.erase(key);
+        return true;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    bool LfuCache<K, V, Hash, Equal>::contains(const K &key) const {
+        return index.contains(key);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LfuCache<K, V, Hash, Equal>::clear() {
+        buckets.clear();
+        index.clear();
+        len = 0;
+        costSum = 0;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LfuCache<K, V, Hash, Equal>::touch(Slot *slot) {
+        auto bucket = slot->second.bucket;
+        auto next = bucket;
+        ++next;
+        if (next == buckets.end() || next->frequency != bucket->frequency + 1)
+            next = buckets.emplace(next, Bucket{bucket->frequency + 1, nullptr, nullptr});
+        detach(slot);
+        append(next, slot);
+        if (bucket->head == nullptr) buckets.erase(bucket);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    typename LfuCache<K, V, Hash, Equal>::Slot *LfuCache<K, V, Hash, Equal>::leastUsed(const Slot *keep) const {
+        auto bucket = buckets.begin();
+        Slot *victim = bucket->head;
+        if (victim != keep) return victim;
+        if (victim->second.next != nullptr) return victim->second.next;
+        return (++bucket)->head;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LfuCache<K, V, Hash, Equal>::evict(Slot *victim) {
+        if (onEvict) onEvict(victim->first, victim->second.value);
+        unlink(victim);
+        // Safe though the key dies with the entry: erase does not read it afterwards
+        index.erase(victim->first);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LfuCache<K, V, Hash, Equal>::unlink(Slot *slot) {
+        auto bucket = slot->second.bucket;
+        costSum -= slot->second.cost;
+        --len;
+        detach(slot);
+        if (bucket->head == nullptr) buckets.erase(bucket);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LfuCache<K, V, Hash, Equal>::append(typename BucketList::iterator bucket, Slot *slot) {
+        auto &entry = slot->second;
+        entry.bucket = bucket;
+        entry.prev = bucket->tail;
+        entry.next = nullptr;
+        (bucket->tail ? bucket->tail->second.next : bucket->head) = slot;
+        bucket->tail = slot;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LfuCache<K, V, Hash, Equal>::detach(Slot *slot) {
+        auto &entry = slot->second;
+        auto bucket = entry.bucket;
+        (entry.prev ? entry.prev->second.next : bucket->head) = entry.next;
+        (entry.next ? entry.next->second.prev : bucket->tail) = entry.prev;
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_LFUCACHE_H
@@ -2,6 +2,7 @@
 #define LIST_H
 
 #include <stdexcept>
+#include <utility>
 
 #include "ReverseIterator.h"
 
@@ -13,13 +14,22 @@ namespace MySTL {
             Node *prev;
             Node *next;
 
-            explicit Node(const T &data)
-                    : data(data), prev(nullptr), next(nullptr) {}
+            template<typename... Args>
+            explicit Node(Args &&...args)
+                    : data(std::forward<Args>(args)...), prev(nullptr), next(nullptr) {}
         };
 
     public:
         List();
 
+        List(const List &other);
+
+        List(List &&other) noexcept;
+
+        List &operator=(const List &other);
+
+        List &operator=(List &&other) noexcept;
+
         ~List();
 
         void push_back(const T &value);
@@ -30,6 +40,9 @@ namespace MySTL {
 
         void pop_front();
 
+        template<typename... Args>
+        T &emplace_back(Args &&...args);
+
         [[nodiscard]] bool empty() const;
 
         const T &back();
@@ -88,6 +101,8 @@ namespace MySTL {
             }
 
         private:
+            friend class List;
+
             Node *node;
         };
 
@@ -112,15 +127,65 @@ namespace MySTL {
 
         const_reverse_iterator crend() const;
 
+        const_iterator begin() const;
+
+        const_iterator end() const;
+
+        // Erase the element at it, returns the iterator following it
+        iterator erase(iterator it);
+
+        // Construct an element in place before pos, returns its iterator
+        template<typename... Args>
+        iterator emplace(iterator pos, Args &&...args);
+
+        // Relink the node at it from other into this list before pos,
+        // without copying or reallocating the element
+        void splice(iterator pos, List &other, iterator it);
+
     private:
         Node *head;
         Node *tail;
         size_t len{};
+
+        // Link a detached node before next, or at the back if next is null
+        void link(Node *node, Node *next);
     };
 
     template<typename T>
     List<T>::List() : head(nullptr), tail(nullptr), len(0) {}
 
+    template<typename T>
+    List<T>::List(const List &other) : head(nullptr), tail(nullptr), len(0) {
+        for (auto node = other.head; node; node = node->next) push_back(node->data);
+    }
+
+    template<typename T>
+    List<T>::List(List &&other) noexcept
+            : head(other.head), tail(other.tail), len(other.len) {
+        other.head = other.tail = nullptr;
+        other.len = 0;
+    }
+
+    template<typename T>
+    List<T> &List<T>::operator=(const List &other) {
+        if (this == &other) return *this;
+        clear();
+        for (auto node = other.head; node; node = node->next) push_back(node->data);
+        return *this;
+    }
+
+    template<typename T>
+    List<T> &List<T>::operator=(List &&other) noexcept {
+        if (this == &other) return *this;
+        clear();
+        head = other.head;
+        tail = other.tail;
+        len = other.len;
+        other.head = other.tail = nullptr;
+        other.len = 0;
+        return *this;
+    }
+
     template<typename T>
     List<T>::~List() {
         clear();
@@ -197,6 +262,20 @@ namespace MySTL {
         --len;
     }
 
+    template<typename T>
+    template<typename... Args>
+    T &List<T>::emplace_back(Args &&...args) {
+        auto node = new Node(std::forward<Args>(args)...);
+        if (tail) {
+            tail->next = node;
+            node->prev = tail;
+            tail = node;
+        } else
+            head = tail = node;
+        ++len;
+        return node->data;
+    }
+
     template<typename T>
     bool List<T>::find(const T &value) {
         Node *current = head;
@@ -256,6 +335,65 @@ namespace MySTL {
         }
     }
 
+    template<typename T>
+    typename List<T>::iterator List<T>::erase(iterator it) {
+        Node *current = it.node;
+        if (current == nullptr) throw std::out_of_range("Iterator out of range");
+        Node *next = current->next;
+        if (current->prev)
+            current->prev->next = next;
+        else
+            head = next;
+        if (next)
+            next->prev = current->prev;
+        else
+            tail = current->prev;
+        delete current;
+        --len;
+        return iterator(next);
+    }
+
+    template<typename T>
+    void List<T>::splice(iterator pos, List &other, iterator it) {
+        Node *node = it.node;
+        if (node == nullptr) throw std::out_of_range("Iterator out of range");
+
+        if (node->prev)
+            node->prev->next = node->next;
+        else
+            other.head = node->next;
+        if (node->next)
+            node->next->prev = node->prev;
+        else
+            other.tail = node->prev;
+        --other.len;
+
+        link(node, pos.node);
+    }
+
+    template<typename T>
+    template<typename... Args>
+    typename List<T>::iterator List<T>::emplace(iterator pos, Args &&...args) {
+        auto node = new Node(std::forward<Args>(args)...);
+        link(node, pos.node);
+        return iterator(node);
+    }
+
+    template<typename T>
+    void List<T>::link(Node *node, Node *next) {
+        node->next = next;
+        node->prev = next ? next->prev : tail;
+        if (node->prev)
+            node->prev->next = node;
+        else
+            head = node;
+        if (next)
+            next->prev = node;
+        else
+            tail = node;
+        ++len;
+    }
+
     template<typename T>
     void List<T>::insert(const T &value, const size_t pos) {
         if (pos > len) throw std::out_of_range("Index out of range");
@@ -321,6 +459,16 @@ namespace MySTL {
         return const_iterator(nullptr);
     }
 
+    template<typename T>
+    typename List<T>::const_iterator List<T>::begin() const {
+        return const_iterator(head);
+    }
+
+    template<typename T>
+    typename List<T>::const_iterator List<T>::end() const {
+        return const_iterator(nullptr);
+    }
+
     template<typename T>
     typename List<T>::const_reverse_iterator List<T>::crbegin() const {
         return const_reverse_iterator(tail);
@@ -0,0 +1,204 @@
+#ifndef MYSTL_LRUCACHE_H
+#define MYSTL_LRUCACHE_H
+
+#include <functional>
+#include <limits>
+#include <utility>
+
+#include "HashMap.h"
+
+namespace MySTL {
+    // Least recently used cache. Each map entry carries the links of an
+    // intrusive recency list, least recently used at the front, and the
+    // links point at the map's own slots, so the key is stored once; the map
+    // relinks its nodes rather than moving them when it grows, so the links
+    // stay valid. A hit relinks the entry to the back, so get and update
+    // never allocate, and inserting a new key allocates only its map node.
+    //
+    // Two limits apply: the number of entries and the sum of the costs passed
+    // to put (e.g. bytes). Eviction takes entries from the front until both
+    // hold, calling the eviction callback for each.
+    template<typename K, typename V, typename Hash = std::hash<K>, typename Equal = std::equal_to<K>>
+    class LruCache {
+    public:
+        using key_type = K;
+        using mapped_type = V;
+        using hasher = Hash;
+        // Called with each entry evicted to make room, not for erase or clear.
+        // It must not call back into the cache.
+        using EvictionCallback = std::function<void(const K &, V &)>;
+
+        explicit LruCache(size_t maxEntries, size_t maxCost = std::numeric_limits<size_t>::max());
+
+        // The moved-from cache is left empty
+        LruCache(LruCache &&other) noexcept;
+
+        LruCache &operator=(LruCache &&other) noexcept;
+
+        // Marks the entry most recently used, nullptr on a miss
+        V *get(const K &key);
+
+        // Looks the entry up without touching its recency
+        const V *peek(const K &key) const;
+
+        // Inserts or replaces the entry and marks it most recently used.
+        // Returns false, storing nothing, if cost alone exceeds maxCost.
+        bool put(const K &key, V value, size_t cost = 1);
+
+        bool erase(const K &key);
+
+        bool contains(const K &key) const;
+
+        [[nodiscard]] bool empty() const { return index.empty(); }
+
+        [[nodiscard]] size_t size() const { return index.size(); }
+
+        [[nodiscard]] size_t totalCost() const { return costSum; }
+
+        [[nodiscard]] size_t maxEntries() const { return entryLimit; }
+
+        [[nodiscard]] size_t maxCost() const { return costLimit; }
+
+        void clear();
+
+        void setEvictionCallback(EvictionCallback callback) { onEvict = std::move(callback); }
+
+    private:
+        struct Entry;
+
+        // A map slot: the key and its entry
+        using Slot = Pair<K, Entry>;
+
+        struct Entry {
+            V value;
+            size_t cost;
+            Slot *prev;
+            Slot *next;
+        };
+
+        HashMap<K, Entry, Hash, Equal> index;
+        // Least recently used first
+        Slot *head = nullptr;
+        Slot *tail = nullptr;
+        size_t entryLimit;
+        size_t costLimit;
+        size_t costSum;
+        EvictionCallback onEvict;
+
+        void linkBack(Slot *slot);
+
+        void unlink(Slot *slot);
+
+        void evictFront();
+    };
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    LruCache<K, V, Hash, Equal>::LruCache(size_t maxEntries, size_t maxCost)
+            : entryLimit(maxEntries), costLimit(maxCost), costSum(0) {}
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    LruCache<K, V, Hash, Equal>::LruCache(LruCache &&other) noexcept
+            : index(std::move(other.index)), head(std::exchange(other.head, nullptr)),
+              tail(std::exchange(other.tail, nullptr)), entryLimit(other.entryLimit), costLimit(other.costLimit),
+              costSum(std::exchange(other.costSum, 0)), onEvict(std::move(other.onEvict)) {
+        other.index = HashMap<K, Entry, Hash, Equal>();
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    LruCache<K, V, Hash, Equal> &LruCache<K, V, Hash, Equal>::operator=(LruCache &&other) noexcept {
+        if (this == &other) return *this;
+        index = std::exchange(other.index, HashMap<K, Entry, Hash, Equal>());
+        head = std::exchange(other.head, nullptr);
+        tail = std::exchange(other.tail, nullptr);
+        entryLimit = other.entryLimit;
+        costLimit = other.costLimit;
+        costSum = std::exchange(other.costSum, 0);
+        onEvict = std::move(other.onEvict);
+        return *this;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    V *LruCache<K, V, Hash, Equal>::get(const K &key) {
+        auto slot = index.find_entry(key);
+        if (slot == nullptr) return nullptr;
+        unlink(slot);
+        linkBack(slot);
+        return &slot->second.value;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    const V *LruCache<K, V, Hash, Equal>::peek(const K &key) const {
+        auto entry = index.find(key);
+        return entry ? &entry->value : nullptr;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    bool LruCache<K, V, Hash, Equal>::put(const K &key, V value, size_t cost) {
+        if (cost > costLimit || entryLimit == 0) return false;
+        if (auto slot = index.find_entry(key)) {
+            auto &entry = slot->second;
+            unlink(slot);
+            linkBack(slot);
+            entry.value = std::move(value);
+            costSum = costSum - entry.cost + cost;
+            entry.cost = cost;
+            // The updated entry sits at the back, so it is the last to go
+            while (costSum > costLimit) evictFront();
+            return true;
+        }
+        while (head != nullptr && (index.size() >= entryLimit || costSum + cost > costLimit))
+            evictFront();
+        linkBack(index.try_emplace_entry(key, Entry{std::move(value), cost, nullptr, nullptr}).first);
+        costSum += cost;
+        return true;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    bool LruCache<K, V, Hash, Equal>::erase(const K &key) {
+        auto slot = index.find_entry(key);
+        if (slot == nullptr) return false;
+        costSum -= slot->second.cost;
+        unlink(slot);
+        index.erase(key);
+        return true;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    bool LruCache<K, V, Hash, Equal>::contains(const K &key) const {
+        return index.contains(key);
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LruCache<K, V, Hash, Equal>::clear() {
+        index.clear();
+        head = tail = nullptr;
+        costSum = 0;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LruCache<K, V, Hash, Equal>::linkBack(Slot *slot) {
+        slot->second.prev = tail;
+        slot->second.next = nullptr;
+        (tail ? tail->second.next : head) = slot;
+        tail = slot;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LruCache<K, V, Hash, Equal>::unlink(Slot *slot) {
+        auto &entry = slot->second;
+        (entry.prev ? entry.prev->second.next : head) = entry.next;
+        (entry.next ? entry.next->second.prev : tail) = entry.prev;
+    }
+
+    template<typename K, typename V, typename Hash, typename Equal>
+    void LruCache<K, V, Hash, Equal>::evictFront() {
+        auto victim = head;
+        if (onEvict) onEvict(victim->first, victim->second.value);
+        costSum -= victim->second.cost;
+        unlink(victim);
+        // Safe though the key dies with the entry: erase does not read it afterwards
+        index.erase(victim->first);
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_LRUCACHE_H
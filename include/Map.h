@@ -1,22 +1,57 @@
 #ifndef MYSTL_MAP_H
 #define MYSTL_MAP_H
 
+#include <algorithm>
+#include <bit>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
-
+#include <future>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <type_traits>
+
+#include "utils/FrontFilter.h"
 #include "utils/RBTreeNode.h"
 
-#include "ReverseIterator.h"
+#include "Memory/PoolAllocator.h"
+
+#include "Functional.h"
 #include "Pair.h"
 
 namespace MySTL {
 
-    template<typename K, typename V, typename Compare = std::less<K> >
+    // Filter is an optional front filter (BloomFilter, CuckooFilter) fed with
+    // std::hash<K>, so lookups of absent keys mostly skip the tree walk.
+    // Heterogeneous lookups bypass it.
+    //
+    // Alloc is rebound to the node type. The default PoolAllocator gives
+    // each map its own node slabs, so clear and destruction free whole slabs.
+    //
+    // Ranked keeps subtree sizes in the nodes, one word each, for O(log n)
+    // rank, select and count_range.
+    template<typename K, typename V, typename Compare = std::less<K>, typename Filter = NoFilter,
+            typename Alloc = PoolAllocator<Pair<K, V>>, bool Ranked = false>
     class Map {
     public:
-        Map();
+        explicit Map(const Compare &comp = Compare());
+
+        Map(Map &&other) noexcept;
+
+        Map &operator=(Map &&other) noexcept;
+
+        ~Map() { clear(); }
 
-        ~Map() = default;
+        // Builds a map from entries (anything with first and second) whose
+        // keys are strictly ascending in O(n): the tree is shaped and coloured
+        // directly, with one comparison per entry to check the order. Throws
+        // std::invalid_argument when the keys are not ascending.
+        template<typename ForwardIt>
+        static Map from_sorted(ForwardIt first, ForwardIt last, const Compare &comp = Compare());
+
+        void swap(Map &other) noexcept;
 
         [[nodiscard]] bool empty() const;
 
@@ -32,24 +67,47 @@ namespace MySTL {
 
         bool contains(const K &key) const;
 
+        V &at(const K &key);
+
+        // Heterogeneous lookup, enabled when Compare is transparent
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        V *find(const KeyLike &key);
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        void erase(const KeyLike &key);
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        bool contains(const KeyLike &key) const;
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        V &at(const KeyLike &key);
+
         class Iterator {
         public:
             using iterator_category = std::bidirectional_iterator_tag;
-            using value_type = Pair<K, V>;
+            using value_type = Pair<const K, V>;
             using difference_type = std::ptrdiff_t;
-            using pointer = Pair<K, V> *;
-            using reference = Pair<K, V> &;
+            using pointer = Pair<const K, V> *;
+            using reference = Pair<const K, V> &;
 
-            using Node = RBTreeNode<K, V>;
+            using Node = RBTreeNode<K, V, Ranked>;
 
             explicit Iterator(Node *node) : node(node) {}
 
             reference operator*() const {
-                return Pair<K, V>::make_pair(node->key, node->value);
+                return node->entry;
             }
 
+            const K &key() const { return node->key(); }
+
+            V &value() const { return node->value(); }
+
             pointer operator->() const {
-                return &Pair<K, V>::make_pair(node->key, node->value);
+                return &node->entry;
             }
 
             Iterator &operator++() {
@@ -57,10 +115,10 @@ namespace MySTL {
                     node = node->right;
                     while (node->left != nullptr) node = node->left;
                 } else {
-                    auto parent = node->parent;
+                    auto parent = node->parent();
                     while (parent != nullptr && node == parent->right) {
                         node = parent;
-                        parent = parent->parent;
+                        parent = parent->parent();
                     }
                     node = parent;
                 }
@@ -72,10 +130,10 @@ namespace MySTL {
                     node = node->left;
                     while (node->right != nullptr) node = node->right;
                 } else {
-                    auto parent = node->parent;
+                    auto parent = node->parent();
                     while (parent != nullptr && node == parent->left) {
                         node = parent;
-                        parent = parent->parent;
+                        parent = parent->parent();
                     }
                     node = parent;
                 }
@@ -91,16 +149,79 @@ namespace MySTL {
             }
 
         private:
+            friend class Map;
+
             Node *node;
         };
 
+        // Walks the nodes from the largest down. Iterator cannot step back
+        // from end(), so this starts at the largest node itself rather than
+        // wrapping end() like MySTL::ReverseIterator.
+        class ReverseIterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = Pair<const K, V>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Pair<const K, V> *;
+            using reference = Pair<const K, V> &;
+
+            using Node = RBTreeNode<K, V, Ranked>;
+
+            explicit ReverseIterator(Node *node) : it(node) {}
+
+            reference operator*() const {
+                return *it;
+            }
+
+            const K &key() const { return it.key(); }
+
+            V &value() const { return it.value(); }
+
+            pointer operator->() const {
+                return it.operator->();
+            }
+
+            ReverseIterator &operator++() {
+                --it;
+                return *this;
+            }
+
+            ReverseIterator operator++(int) {
+                auto temp = *this;
+                --it;
+                return temp;
+            }
+
+            ReverseIterator &operator--() {
+                ++it;
+                return *this;
+            }
+
+            ReverseIterator operator--(int) {
+                auto temp = *this;
+                ++it;
+                return temp;
+            }
+
+            bool operator==(const ReverseIterator &other) const {
+                return it == other.it;
+            }
+
+            bool operator!=(const ReverseIterator &other) const {
+                return it != other.it;
+            }
+
+        private:
+            Iterator it;
+        };
+
         using iterator = Iterator;
         using const_iterator = const Iterator;
-        using reverse_iterator = ReverseIterator<iterator>;
-        using reverse_const_iterator = ReverseIterator<const_iterator>;
+        using reverse_iterator = ReverseIterator;
+        using reverse_const_iterator = const ReverseIterator;
 
         iterator begin() {
-            return iterator(minimum(root));
+            return iterator(leftmost);
         }
 
         iterator end() {
@@ -108,7 +229,7 @@ namespace MySTL {
         }
 
         const_iterator cbegin() const {
-            return const_iterator(minimum(root));
+            return const_iterator(leftmost);
         }
 
         const_iterator cend() const {
@@ -116,7 +237,7 @@ namespace MySTL {
         }
 
         reverse_iterator rbegin() {
-            return reverse_iterator(maximum(root));
+            return reverse_iterator(rightmost);
         }
 
         reverse_iterator rend() {
@@ -124,252 +245,1143 @@ namespace MySTL {
         }
 
         reverse_const_iterator crbegin() const {
-            return reverse_const_iterator(maximum(root));
+            return reverse_const_iterator(rightmost);
         }
 
         reverse_const_iterator crend() const {
             return reverse_const_iterator(nullptr);
         }
 
+        // Inserts or assigns like insert, but links the node next to hint
+        // instead of descending from the root when key belongs right before
+        // hint (end() for a new largest key). That costs amortized O(1); any
+        // other hint falls back to insert. Returns the entry's position.
+        iterator insert(iterator hint, const K &key, const V &value);
+
+        // First entry whose key is not less than key
+        iterator lower_bound(const K &key) const;
+
+        // First entry whose key is greater than key
+        iterator upper_bound(const K &key) const;
+
+        Pair<iterator, iterator> equal_range(const K &key) const;
+
+        // Erases [first, last) and returns last. The range is cut out with two
+        // splits and the rest joined back, so k entries cost O(k + log n) with
+        // a single rebalance instead of a fixup each.
+        iterator erase(iterator first, iterator last);
+
+        // Calls fn(key, value) on the entries with keys in [lo, hi), in order
+        template<typename Fn>
+        void for_each_in_range(const K &lo, const K &hi, Fn &&fn);
+
+        // Moves the entries with keys not less than key into a new map and
+        // returns it. The nodes are relinked by a tree split, but a pooled map
+        // cannot share its pool, so there the smaller half is copied into the
+        // new map's pool instead. O(log n) for a ranked map with a plain
+        // allocator, otherwise O(log n + min(k, n - k)) to count or copy the
+        // smaller half.
+        Map split(const K &key);
+
+        // Concatenates two maps with every key of left below every key of
+        // right in O(log n), taking over right's pool. Throws
+        // std::invalid_argument when the keys overlap.
+        static Map join(Map &&left, Map &&right);
+
+        // Set algebra on the keys, built on split and join in
+        // O(m log(n / m + 1)) for sizes m <= n. Disjoint subtrees run on
+        // separate threads once the maps hold PARALLEL_THRESHOLD entries
+        // together. Nodes and pool are taken over from other, which is left
+        // empty, and a front filter is rebuilt afterwards.
+        //
+        // Keys in both maps take the value from other
+        void union_with(Map &&other);
+
+        // Keeps the entries whose keys are in other
+        void intersect_with(Map &&other);
+
+        // Erases the entries whose keys are in other
+        void difference_with(Map &&other);
+
+        // Number of keys less than key
+        size_t rank(const K &key) const requires Ranked;
+
+        // Entry with the given rank, throws std::out_of_range past the end
+        iterator select(size_t index) const requires Ranked;
+
+        // Number of keys in [lo, hi)
+        size_t count_range(const K &lo, const K &hi) const requires Ranked;
+
     private:
-        RBTreeNode<K, V> *root;
+        static constexpr size_t MIN_FILTER_CAPACITY = 16;
+        static constexpr size_t PARALLEL_THRESHOLD = size_t(1) << 16;
+
+        using NodePair = Pair<RBTreeNode<K, V, Ranked> *, RBTreeNode<K, V, Ranked> *>;
+
+        // Subtrees dropped by the set operations, chained through parent and
+        // destroyed once the threads are done, as the pool is not thread-safe
+        struct Garbage {
+            RBTreeNode<K, V, Ranked> *head = nullptr;
+            RBTreeNode<K, V, Ranked> *tail = nullptr;
+
+            void add(RBTreeNode<K, V, Ranked> *x) {
+                if (x == nullptr) return;
+                x->setParent(nullptr);
+                if (tail != nullptr)
+                    tail->setParent(x);
+                else
+                    head = x;
+                tail = x;
+            }
+
+            void append(const Garbage &other) {
+                if (other.head == nullptr) return;
+                if (tail != nullptr)
+                    tail->setParent(other.head);
+                else
+                    head = other.head;
+                tail = other.tail;
+            }
+        };
+
+        using SetOperation = RBTreeNode<K, V, Ranked> *(Map::*)(RBTreeNode<K, V, Ranked> *, RBTreeNode<K, V, Ranked> *,
+                                                                size_t, Garbage &);
+
+        RBTreeNode<K, V, Ranked> *root;
+        // Smallest and largest nodes, so begin and rbegin are O(1) and
+        // appends hinted with end() skip the descent
+        RBTreeNode<K, V, Ranked> *leftmost;
+        RBTreeNode<K, V, Ranked> *rightmost;
         size_t len;
         Compare cmp;
 
-        void leftRotate(RBTreeNode<K, V> *x);
+        using NodeAllocator = typename Alloc::template rebind<RBTreeNode<K, V, Ranked>>::other;
+        // Allocators with release(), like PoolAllocator, free all nodes at once
+        static constexpr bool POOLED = requires(NodeAllocator &a) { a.release(); };
+
+        NodeAllocator nodes;
+
+        Filter filter;
+        // Keys the filter was sized for, it is rebuilt once len passes this
+        size_t filterCapacity;
+
+        [[nodiscard]] bool filteredOut(const K &key) const;
 
-        void rightRotate(RBTreeNode<K, V> *x);
+        void filterAdd(const K &key);
 
-        void insertFixup(RBTreeNode<K, V> *z);
+        void filterRemove(const K &key);
 
-        void transplant(RBTreeNode<K, V> *u, RBTreeNode<K, V> *v);
+        void rebuildFilter(size_t capacity);
 
-        void deleteFixup(RBTreeNode<K, V> *x);
+        void addToFilter(RBTreeNode<K, V, Ranked> *x);
 
-        RBTreeNode<K, V> *minimum(RBTreeNode<K, V> *x);
+        // top is the root of the tree worked on, which is not root while
+        // join builds pieces of a split, possibly on several threads
+        static void leftRotate(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *&top);
 
-        RBTreeNode<K, V> *maximum(RBTreeNode<K, V> *x);
+        static void rightRotate(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *&top);
 
-        RBTreeNode<K, V> *findNode(K key);
+        // Returns whether top had turned red, raising the black height
+        static bool insertFixup(RBTreeNode<K, V, Ranked> *z, RBTreeNode<K, V, Ranked> *&top);
 
-        void clearNode(RBTreeNode<K, V> *x);
+        void transplant(RBTreeNode<K, V, Ranked> *u, RBTreeNode<K, V, Ranked> *v);
 
-        void insertNode(RBTreeNode<K, V> *z);
+        void deleteFixup(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *xParent);
 
-        void deleteNode(RBTreeNode<K, V> *z);
+        RBTreeNode<K, V, Ranked> *minimum(RBTreeNode<K, V, Ranked> *x) const;
+
+        RBTreeNode<K, V, Ranked> *maximum(RBTreeNode<K, V, Ranked> *x) const;
+
+        RBTreeNode<K, V, Ranked> *predecessor(RBTreeNode<K, V, Ranked> *x) const;
+
+        // First node not less than key, or greater than it when inclusive
+        RBTreeNode<K, V, Ranked> *boundNode(const K &key, bool inclusive) const;
+
+        // Black nodes on the way from x down to a null link
+        static size_t blackHeight(const RBTreeNode<K, V, Ranked> *x);
+
+        // Links k between the trees l and r, whose keys are all smaller and
+        // all larger, rebalances and returns the root of the result
+        static RBTreeNode<K, V, Ranked> *joinTrees(RBTreeNode<K, V, Ranked> *l, RBTreeNode<K, V, Ranked> *k,
+                                                   RBTreeNode<K, V, Ranked> *r);
+
+        // As above with the black heights of l and r given, a red root
+        // counted as black, so it costs O(|leftHeight - rightHeight| + 1).
+        // height receives the result's.
+        static RBTreeNode<K, V, Ranked> *joinTrees(RBTreeNode<K, V, Ranked> *l, size_t leftHeight,
+                                                   RBTreeNode<K, V, Ranked> *k, RBTreeNode<K, V, Ranked> *r,
+                                                   size_t rightHeight, size_t &height);
+
+        // Joins l and r without a key in between
+        static RBTreeNode<K, V, Ranked> *joinTrees(RBTreeNode<K, V, Ranked> *l, RBTreeNode<K, V, Ranked> *r);
+
+        // Cuts the largest node off the tree at x into last, returns the rest
+        static RBTreeNode<K, V, Ranked> *splitLast(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *&last);
+
+        // Splits the tree at x into the keys less than key and those greater;
+        // a node with an equal key is detached into match
+        NodePair splitTree(RBTreeNode<K, V, Ranked> *x, const K &key, RBTreeNode<K, V, Ranked> *&match);
+
+        // As above with x's black height given as for joinTrees. The heights
+        // of the parts are passed down the path and returned, so the joins
+        // along it telescope to O(log n) in total.
+        NodePair splitTree(RBTreeNode<K, V, Ranked> *x, size_t height, const K &key,
+                           RBTreeNode<K, V, Ranked> *&match, size_t &lowHeight, size_t &highHeight);
+
+        RBTreeNode<K, V, Ranked> *unionTrees(RBTreeNode<K, V, Ranked> *a, RBTreeNode<K, V, Ranked> *b,
+                                             size_t depth, Garbage &garbage);
+
+        RBTreeNode<K, V, Ranked> *intersectTrees(RBTreeNode<K, V, Ranked> *a, RBTreeNode<K, V, Ranked> *b,
+                                                 size_t depth, Garbage &garbage);
+
+        RBTreeNode<K, V, Ranked> *differenceTrees(RBTreeNode<K, V, Ranked> *a, RBTreeNode<K, V, Ranked> *b,
+                                                  size_t depth, Garbage &garbage);
+
+        // Applies a set operation to both trees and takes over other's nodes
+        void combine(Map &&other, SetOperation operation);
+
+        // Runs f and g, f on a thread of its own while depth is non-zero
+        template<typename F, typename G>
+        static void forkJoin(size_t depth, F &&f, G &&g);
+
+        // Destroys the subtree at x and returns its entry count
+        size_t eraseSubtree(RBTreeNode<K, V, Ranked> *x);
+
+        size_t eraseGarbage(const Garbage &garbage);
+
+        static size_t subtreeSize(const RBTreeNode<K, V, Ranked> *x);
+
+        // Adds delta to the subtree sizes from x up to the root
+        static void resizePath(RBTreeNode<K, V, Ranked> *x, ptrdiff_t delta);
+
+        // Builds a balanced subtree from the next n entries, colouring the
+        // nodes at redDepth red; prev is the last node built, for the order check
+        template<typename ForwardIt>
+        RBTreeNode<K, V, Ranked> *buildSorted(ForwardIt &first, size_t n, size_t depth, size_t redDepth,
+                                      RBTreeNode<K, V, Ranked> *&prev);
+
+        template<typename KeyLike>
+        RBTreeNode<K, V, Ranked> *findNode(const KeyLike &key) const;
+
+        void clearNode(RBTreeNode<K, V, Ranked> *x);
+
+        RBTreeNode<K, V, Ranked> *createNode(const K &key, const V &value);
+
+        void destroyNode(RBTreeNode<K, V, Ranked> *x);
+
+        void insertNode(RBTreeNode<K, V, Ranked> *z);
+
+        void deleteNode(RBTreeNode<K, V, Ranked> *z);
     };
 
-    template<typename K, typename V, typename Compare>
-    Map<K, V, Compare>::Map() : root(nullptr), len(0), cmp(Compare()) {}
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    Map<K, V, Compare, Filter, Alloc, Ranked>::Map(const Compare &comp)
+            : root(nullptr), leftmost(nullptr), rightmost(nullptr), len(0), cmp(comp), filterCapacity(MIN_FILTER_CAPACITY) {
+        filter.reset(filterCapacity);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    Map<K, V, Compare, Filter, Alloc, Ranked>::Map(Map &&other) noexcept : Map(other.cmp) {
+        swap(other);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    Map<K, V, Compare, Filter, Alloc, Ranked> &Map<K, V, Compare, Filter, Alloc, Ranked>::operator=(Map &&other) noexcept {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename ForwardIt>
+    Map<K, V, Compare, Filter, Alloc, Ranked> Map<K, V, Compare, Filter, Alloc, Ranked>::from_sorted(ForwardIt first, ForwardIt last, const Compare &comp) {
+        Map map(comp);
+        auto n = static_cast<size_t>(std::distance(first, last));
+        if (n == 0) return map;
+        // Splitting evenly leaves every null link on the last two levels, so
+        // with the deepest level red all paths have the same black count
+        size_t deepest = std::bit_width(n) - 1;
+        RBTreeNode<K, V, Ranked> *prev = nullptr;
+        map.root = map.buildSorted(first, n, 0, deepest == 0 ? SIZE_MAX : deepest, prev);
+        map.leftmost = map.minimum(map.root);
+        map.rightmost = prev;
+        map.len = n;
+        map.rebuildFilter(std::max(MIN_FILTER_CAPACITY, 2 * n));
+        return map;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::swap(Map &other) noexcept {
+        using std::swap;
+        swap(root, other.root);
+        swap(leftmost, other.leftmost);
+        swap(rightmost, other.rightmost);
+        swap(len, other.len);
+        swap(cmp, other.cmp);
+        swap(nodes, other.nodes);
+        swap(filter, other.filter);
+        swap(filterCapacity, other.filterCapacity);
+    }
 
-    template<typename K, typename V, typename Compare>
-    bool Map<K, V, Compare>::empty() const {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    bool Map<K, V, Compare, Filter, Alloc, Ranked>::empty() const {
         return len == 0;
     }
 
-    template<typename K, typename V, typename Compare>
-    size_t Map<K, V, Compare>::size() const {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::size() const {
         return len;
     }
 
-    template<typename K, typename V, typename Compare>
-    V *Map<K, V, Compare>::find(const K &key) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    V *Map<K, V, Compare, Filter, Alloc, Ranked>::find(const K &key) {
+        if (filteredOut(key)) return nullptr;
         auto x = findNode(key);
-        if (x != nullptr) return &x->value;
+        if (x != nullptr) return &x->value();
         return nullptr;
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::insert(const K &key, const V &value) {
-        auto newNode = new RBTreeNode<K, V>(key, value);
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::insert(const K &key, const V &value) {
+        if (auto x = filteredOut(key) ? nullptr : findNode(key)) {
+            x->value() = value;
+            return;
+        }
+        auto newNode = createNode(key, value);
         insertNode(newNode);
         ++len;
+        filterAdd(key);
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::erase(const K &key) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::erase(const K &key) {
+        if (filteredOut(key)) return;
         auto node = findNode(key);
         if (node == nullptr) return;
+        filterRemove(key);
         deleteNode(node);
         --len;
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::clear() {
-        clearNode(root);
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::clear() {
+        // With a pool the walk only runs destructors, whole slabs are freed after
+        if constexpr (!POOLED || !std::is_trivially_destructible_v<RBTreeNode<K, V, Ranked>>) clearNode(root);
+        if constexpr (POOLED) nodes.release();
         root = nullptr;
+        leftmost = nullptr;
+        rightmost = nullptr;
         len = 0;
+        rebuildFilter(MIN_FILTER_CAPACITY);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    bool Map<K, V, Compare, Filter, Alloc, Ranked>::contains(const K &key) const {
+        return !filteredOut(key) && findNode(key) != nullptr;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    V &Map<K, V, Compare, Filter, Alloc, Ranked>::at(const K &key) {
+        if (auto x = filteredOut(key) ? nullptr : findNode(key)) return x->value();
+        auto newNode = createNode(key, V());
+        insertNode(newNode);
+        ++len;
+        filterAdd(key);
+        return newNode->value();
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename KeyLike>
+    requires Transparent<Compare>
+    V *Map<K, V, Compare, Filter, Alloc, Ranked>::find(const KeyLike &key) {
+        auto x = findNode(key);
+        if (x != nullptr) return &x->value();
+        return nullptr;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename KeyLike>
+    requires Transparent<Compare>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::erase(const KeyLike &key) {
+        auto node = findNode(key);
+        if (node == nullptr) return;
+        filterRemove(node->key());
+        deleteNode(node);
+        --len;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename KeyLike>
+    requires Transparent<Compare>
+    bool Map<K, V, Compare, Filter, Alloc, Ranked>::contains(const KeyLike &key) const {
+        return findNode(key) != nullptr;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename KeyLike>
+    requires Transparent<Compare>
+    V &Map<K, V, Compare, Filter, Alloc, Ranked>::at(const KeyLike &key) {
+        if (auto x = findNode(key)) return x->value();
+        // Only a miss pays for building the owning key
+        return at(K(key));
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator
+    Map<K, V, Compare, Filter, Alloc, Ranked>::insert(iterator hint, const K &key, const V &value) {
+        auto next = hint.node;
+        auto prev = next != nullptr ? predecessor(next) : rightmost;
+        if ((next != nullptr && !cmp(key, next->key())) || (prev != nullptr && !cmp(prev->key(), key))) {
+            insert(key, value);
+            return iterator(findNode(key));
+        }
+        auto z = createNode(key, value);
+        // Of two neighbours, one always has a free child facing the other
+        if (prev == nullptr && next == nullptr) {
+            root = z;
+        } else if (next != nullptr && next->left == nullptr) {
+            next->left = z;
+            z->setParent(next);
+        } else {
+            prev->right = z;
+            z->setParent(prev);
+        }
+        if (next == leftmost) leftmost = z;
+        if (prev == rightmost) rightmost = z;
+        // Sizes cost a walk to the root, so ranked maps insert in O(log n) here
+        if constexpr (Ranked) resizePath(z->parent(), 1);
+        insertFixup(z, root);
+        ++len;
+        filterAdd(key);
+        return iterator(z);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator Map<K, V, Compare, Filter, Alloc, Ranked>::lower_bound(const K &key) const {
+        return iterator(boundNode(key, false));
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator Map<K, V, Compare, Filter, Alloc, Ranked>::upper_bound(const K &key) const {
+        return iterator(boundNode(key, true));
     }
 
-    template<typename K, typename V, typename Compare>
-    bool Map<K, V, Compare>::contains(const K &key) const {
-        return find(key) != nullptr;
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    Pair<typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator, typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator>
+    Map<K, V, Compare, Filter, Alloc, Ranked>::equal_range(const K &key) const {
+        return Pair<iterator, iterator>(lower_bound(key), upper_bound(key));
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::leftRotate(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator Map<K, V, Compare, Filter, Alloc, Ranked>::erase(iterator first, iterator last) {
+        if (first == last) return last;
+        auto second = first;
+        if (++second == last) {
+            filterRemove(first.node->key());
+            deleteNode(first.node);
+            --len;
+            return last;
+        }
+        // Split off first on its own, then the rest of the range before last,
+        // and join what is left around last
+        RBTreeNode<K, V, Ranked> *match;
+        auto lower = splitTree(root, first.node->key(), match);
+        size_t count = 1;
+        if (last.node == nullptr) {
+            count += eraseSubtree(lower.second);
+            root = joinTrees(lower.first, nullptr);
+        } else {
+            auto upper = splitTree(lower.second, last.node->key(), match);
+            count += eraseSubtree(upper.first);
+            root = joinTrees(lower.first, match, upper.second);
+        }
+        filterRemove(first.node->key());
+        destroyNode(first.node);
+        len -= count;
+        leftmost = minimum(root);
+        rightmost = maximum(root);
+        return last;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    Map<K, V, Compare, Filter, Alloc, Ranked> Map<K, V, Compare, Filter, Alloc, Ranked>::split(const K &key) {
+        Map upper(cmp);
+        auto boundary = boundNode(key, false);
+        size_t lowerCount;
+        if constexpr (Ranked) {
+            lowerCount = rank(key);
+        } else {
+            // Walk both halves in step, so only the smaller one is counted
+            auto lo = begin();
+            auto hi = iterator(boundary);
+            size_t steps = 0;
+            for (; lo.node != boundary && hi.node != nullptr; ++lo, ++hi) ++steps;
+            lowerCount = lo.node == boundary ? steps : len - steps;
+        }
+        if constexpr (POOLED) {
+            if (lowerCount < len - lowerCount) {
+                swap(upper);
+                for (auto it = upper.begin(); it.node != boundary; ++it) insert(end(), it.key(), it.value());
+                upper.erase(upper.begin(), iterator(boundary));
+            } else {
+                for (auto it = iterator(boundary); it != end(); ++it) upper.insert(upper.end(), it.key(), it.value());
+                erase(iterator(boundary), end());
+            }
+        } else {
+            RBTreeNode<K, V, Ranked> *match;
+            auto parts = splitTree(root, key, match);
+            root = joinTrees(parts.first, nullptr);
+            upper.root = match != nullptr ? joinTrees(nullptr, match, parts.second) : joinTrees(parts.second, nullptr);
+            upper.len = len - lowerCount;
+            len = lowerCount;
+            leftmost = minimum(root);
+            rightmost = maximum(root);
+            upper.leftmost = minimum(upper.root);
+            upper.rightmost = maximum(upper.root);
+            rebuildFilter(std::max(MIN_FILTER_CAPACITY, 2 * len));
+            upper.rebuildFilter(std::max(MIN_FILTER_CAPACITY, 2 * upper.len));
+        }
+        return upper;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    Map<K, V, Compare, Filter, Alloc, Ranked> Map<K, V, Compare, Filter, Alloc, Ranked>::join(Map &&left, Map &&right) {
+        if (!left.empty() && !right.empty() && !left.cmp(left.rightmost->key(), right.leftmost->key()))
+            throw std::invalid_argument("join needs the keys of left below those of right");
+        Map result(std::move(left));
+        if constexpr (POOLED) result.nodes.adopt(right.nodes);
+        result.root = joinTrees(result.root, right.root);
+        result.len += right.len;
+        if (result.leftmost == nullptr) result.leftmost = right.leftmost;
+        if (right.rightmost != nullptr) result.rightmost = right.rightmost;
+        right.root = nullptr;
+        right.leftmost = nullptr;
+        right.rightmost = nullptr;
+        right.len = 0;
+        right.rebuildFilter(MIN_FILTER_CAPACITY);
+        result.rebuildFilter(std::max(MIN_FILTER_CAPACITY, 2 * result.len));
+        return result;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::union_with(Map &&other) {
+        if (this != &other) combine(std::move(other), &Map::unionTrees);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::intersect_with(Map &&other) {
+        if (this != &other) combine(std::move(other), &Map::intersectTrees);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::difference_with(Map &&other) {
+        if (this == &other)
+            clear();
+        else
+            combine(std::move(other), &Map::differenceTrees);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename Fn>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::for_each_in_range(const K &lo, const K &hi, Fn &&fn) {
+        for (auto it = lower_bound(lo); it != end() && cmp(it.key(), hi); ++it) fn(it.key(), it.value());
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::rank(const K &key) const requires Ranked {
+        size_t rank = 0;
+        for (auto x = root; x != nullptr;) {
+            if (cmp(x->key(), key)) {
+                rank += subtreeSize(x->left) + 1;
+                x = x->right;
+            } else {
+                x = x->left;
+            }
+        }
+        return rank;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::iterator Map<K, V, Compare, Filter, Alloc, Ranked>::select(size_t index) const requires Ranked {
+        if (index >= len) throw std::out_of_range("Rank out of range");
+        auto x = root;
+        while (true) {
+            size_t left = subtreeSize(x->left);
+            if (index == left) return iterator(x);
+            if (index < left) {
+                x = x->left;
+            } else {
+                index -= left + 1;
+                x = x->right;
+            }
+        }
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::count_range(const K &lo, const K &hi) const requires Ranked {
+        if (!cmp(lo, hi)) return 0;
+        return rank(hi) - rank(lo);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    bool Map<K, V, Compare, Filter, Alloc, Ranked>::filteredOut(const K &key) const {
+        if constexpr (Filter::enabled)
+            return !filter.mayContain(std::hash<K>()(key));
+        else
+            return false;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::filterAdd(const K &key) {
+        if constexpr (Filter::enabled) {
+            if (len > filterCapacity)
+                rebuildFilter(2 * len);
+            else
+                filter.add(std::hash<K>()(key));
+        }
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::filterRemove(const K &key) {
+        if constexpr (Filter::enabled) filter.remove(std::hash<K>()(key));
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::rebuildFilter(size_t capacity) {
+        if constexpr (Filter::enabled) {
+            filterCapacity = capacity;
+            filter.reset(capacity);
+            addToFilter(root);
+        }
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::addToFilter(RBTreeNode<K, V, Ranked> *x) {
+        if (x == nullptr) return;
+        filter.add(std::hash<K>()(x->key()));
+        addToFilter(x->left);
+        addToFilter(x->right);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::leftRotate(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *&top) {
         auto y = x->right;
         x->right = y->left;
 
-        if (y->left != nullptr) y->left->parent = x;
-        y->parent = x->parent;
+        if (y->left != nullptr) y->left->setParent(x);
+        y->setParent(x->parent());
 
-        if (x->parent == nullptr)
-            root = y;
-        else if (x == x->parent->left)
-            x->parent->left = y;
+        if (x->parent() == nullptr)
+            top = y;
+        else if (x == x->parent()->left)
+            x->parent()->left = y;
         else
-            x->parent->right = y;
+            x->parent()->right = y;
+
+        y->left = x;
+        x->setParent(y);
+        if constexpr (Ranked) {
+            y->size = x->size;
+            x->size = subtreeSize(x->left) + subtreeSize(x->right) + 1;
+        }
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::rightRotate(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::rightRotate(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *&top) {
         auto y = x->left;
         x->left = y->right;
 
-        if (y->right != nullptr) y->right->parent = x;
-        y->parent = x->parent;
+        if (y->right != nullptr) y->right->setParent(x);
+        y->setParent(x->parent());
 
-        if (x->parent == nullptr)
-            root = y;
-        else if (x == x->parent->right)
-            x->parent->right = y;
+        if (x->parent() == nullptr)
+            top = y;
+        else if (x == x->parent()->right)
+            x->parent()->right = y;
         else
-            x->parent->left = y;
+            x->parent()->left = y;
 
         y->right = x;
-        x->parent = y;
-    }
-
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::insertFixup(RBTreeNode<K, V> *z) {
-        while (z->parent != nullptr && z->parent->color == RED) {
-            if (z->parent == z->parent->parent->left) {
-                auto y = z->parent->parent->right;
-                if (y != nullptr && y->color == RED) {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
+        x->setParent(y);
+        if constexpr (Ranked) {
+            y->size = x->size;
+            x->size = subtreeSize(x->left) + subtreeSize(x->right) + 1;
+        }
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    bool Map<K, V, Compare, Filter, Alloc, Ranked>::insertFixup(RBTreeNode<K, V, Ranked> *z, RBTreeNode<K, V, Ranked> *&top) {
+        while (z->parent() != nullptr && z->parent()->color() == RED) {
+            if (z->parent() == z->parent()->parent()->left) {
+                auto y = z->parent()->parent()->right;
+                if (y != nullptr && y->color() == RED) {
+                    z->parent()->setColor(BLACK);
+                    y->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    z = z->parent()->parent();
                 } else {
-                    if (z == z->parent->right) {
-                        z = z->parent;
-                        leftRotate(z);
+                    if (z == z->parent()->right) {
+                        z = z->parent();
+                        leftRotate(z, top);
                     }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    rightRotate(z->parent->parent);
+                    z->parent()->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    rightRotate(z->parent()->parent(), top);
                 }
             } else {
-                auto y = z->parent->parent->left;
-                if (y != nullptr && y->color == RED) {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
+                auto y = z->parent()->parent()->left;
+                if (y != nullptr && y->color() == RED) {
+                    z->parent()->setColor(BLACK);
+                    y->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    z = z->parent()->parent();
                 } else {
-                    if (z == z->parent->left) {
-                        z = z->parent;
-                        rightRotate(z);
+                    if (z == z->parent()->left) {
+                        z = z->parent();
+                        rightRotate(z, top);
                     }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    leftRotate(z->parent->parent);
+                    z->parent()->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    leftRotate(z->parent()->parent(), top);
                 }
             }
         }
-        root->color = BLACK;
+        bool grew = top->color() == RED;
+        top->setColor(BLACK);
+        return grew;
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::transplant(RBTreeNode<K, V> *u, RBTreeNode<K, V> *v) {
-        if (u->parent == nullptr)
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::transplant(RBTreeNode<K, V, Ranked> *u, RBTreeNode<K, V, Ranked> *v) {
+        if (u->parent() == nullptr)
             root = v;
-        else if (u == u->parent->left)
-            u->parent->left = v;
+        else if (u == u->parent()->left)
+            u->parent()->left = v;
         else
-            u->parent->right = v;
+            u->parent()->right = v;
 
-        if (v != nullptr) v->parent = u->parent;
+        if (v != nullptr) v->setParent(u->parent());
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::deleteFixup(RBTreeNode<K, V> *x) {
-        while (x != root && (x == nullptr || x->color == BLACK)) {
-            if (x == x->parent->left) {
-                auto w = x->parent->right;
-                if (w->color == RED) {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    leftRotate(x->parent);
-                    w = x->parent->right;
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::deleteFixup(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *xParent) {
+        // x may be nullptr, so its parent is tracked separately
+        while (x != root && (x == nullptr || x->color() == BLACK)) {
+            if (x == xParent->left) {
+                auto w = xParent->right;
+                if (w->color() == RED) {
+                    w->setColor(BLACK);
+                    xParent->setColor(RED);
+                    leftRotate(xParent, root);
+                    w = xParent->right;
                 }
-                if ((w->left == nullptr || w->left->color == BLACK) &&
-                    (w->right == nullptr || w->right->color == BLACK)) {
-                    w->color = RED;
-                    x = x->parent;
+                if ((w->left == nullptr || w->left->color() == BLACK) &&
+                    (w->right == nullptr || w->right->color() == BLACK)) {
+                    w->setColor(RED);
+                    x = xParent;
+                    xParent = x->parent();
                 } else {
-                    if (w->right == nullptr || w->right->color == BLACK) {
-                        if (w->left != nullptr) w->left->color = BLACK;
-                        w->color = RED;
-                        rightRotate(w);
-                        w = x->parent->right;
+                    if (w->right == nullptr || w->right->color() == BLACK) {
+                        if (w->left != nullptr) w->left->setColor(BLACK);
+                        w->setColor(RED);
+                        rightRotate(w, root);
+                        w = xParent->right;
                     }
-                    if (w != nullptr) w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    if (w->right != nullptr) w->right->color = BLACK;
-                    leftRotate(x->parent);
+                    w->setColor(xParent->color());
+                    xParent->setColor(BLACK);
+                    if (w->right != nullptr) w->right->setColor(BLACK);
+                    leftRotate(xParent, root);
                     x = root;
                 }
             } else {
-                auto w = x->right->left;
-                if (w->color == RED) {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    rightRotate(x->parent);
-                    w = x->parent->left;
+                auto w = xParent->left;
+                if (w->color() == RED) {
+                    w->setColor(BLACK);
+                    xParent->setColor(RED);
+                    rightRotate(xParent, root);
+                    w = xParent->left;
                 }
-                if ((w->right == nullptr || w->right->color == BLACK) &&
-                    (w->left == nullptr || w->left->color == BLACK)) {
-                    w->color = RED;
-                    x = x->parent;
+                if ((w->right == nullptr || w->right->color() == BLACK) &&
+                    (w->left == nullptr || w->left->color() == BLACK)) {
+                    w->setColor(RED);
+                    x = xParent;
+                    xParent = x->parent();
                 } else {
-                    if (w->left == nullptr || w->left->color == BLACK) {
-                        if (w->right != nullptr) w->right->color = BLACK;
-                        w->color = RED;
-                        leftRotate(w);
-                        w = x->parent->left;
+                    if (w->left == nullptr || w->left->color() == BLACK) {
+                        if (w->right != nullptr) w->right->setColor(BLACK);
+                        w->setColor(RED);
+                        leftRotate(w, root);
+                        w = xParent->left;
                     }
-                    if (w != nullptr) w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    if (w->left != nullptr) w->left->color = BLACK;
-                    rightRotate(x->parent);
+                    w->setColor(xParent->color());
+                    xParent->setColor(BLACK);
+                    if (w->left != nullptr) w->left->setColor(BLACK);
+                    rightRotate(xParent, root);
                     x = root;
                 }
             }
         }
-        if (x != nullptr) x->color = BLACK;
+        if (x != nullptr) x->setColor(BLACK);
     }
 
-    template<typename K, typename V, typename Compare>
-    RBTreeNode<K, V> *Map<K, V, Compare>::minimum(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::minimum(RBTreeNode<K, V, Ranked> *x) const {
+        if (x == nullptr) return nullptr;
         while (x->left != nullptr) x = x->left;
         return x;
     }
 
-    template<typename K, typename V, typename Compare>
-    RBTreeNode<K, V> *Map<K, V, Compare>::maximum(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::maximum(RBTreeNode<K, V, Ranked> *x) const {
+        if (x == nullptr) return nullptr;
         while (x->right != nullptr) x = x->right;
         return x;
     }
 
-    template<typename K, typename V, typename Compare>
-    RBTreeNode<K, V> *Map<K, V, Compare>::findNode(K key) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::predecessor(RBTreeNode<K, V, Ranked> *x) const {
+        if (x->left != nullptr) return maximum(x->left);
+        auto parent = x->parent();
+        while (parent != nullptr && x == parent->left) {
+            x = parent;
+            parent = parent->parent();
+        }
+        return parent;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::boundNode(const K &key, bool inclusive) const {
         auto x = root;
+        decltype(root) res = nullptr;
         while (x != nullptr) {
-            if (cmp(key, x->key))
+            if (inclusive ? cmp(key, x->key()) : !cmp(x->key(), key)) {
+                res = x;
                 x = x->left;
-            else if (cmp(x->key, key))
+            } else {
+                x = x->right;
+            }
+        }
+        return res;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::blackHeight(const RBTreeNode<K, V, Ranked> *x) {
+        size_t height = 0;
+        for (; x != nullptr; x = x->left)
+            if (x->color() == BLACK) ++height;
+        return height;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::joinTrees(RBTreeNode<K, V, Ranked> *l, RBTreeNode<K, V, Ranked> *k, RBTreeNode<K, V, Ranked> *r) {
+        size_t height;
+        return joinTrees(l, blackHeight(l) + (l != nullptr && l->color() == RED), k,
+                         r, blackHeight(r) + (r != nullptr && r->color() == RED), height);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::joinTrees(RBTreeNode<K, V, Ranked> *l, size_t leftHeight, RBTreeNode<K, V, Ranked> *k, RBTreeNode<K, V, Ranked> *r, size_t rightHeight, size_t &height) {
+        // Both sides become standalone trees with black roots
+        for (auto t : {l, r}) {
+            if (t != nullptr) {
+                t->setParent(nullptr);
+                t->setColor(BLACK);
+            }
+        }
+        k->setParent(nullptr);
+        if (leftHeight == rightHeight) {
+            k->left = l;
+            k->right = r;
+            if (l != nullptr) l->setParent(k);
+            if (r != nullptr) r->setParent(k);
+            k->setColor(BLACK);
+            if constexpr (Ranked) k->size = subtreeSize(l) + subtreeSize(r) + 1;
+            height = leftHeight + 1;
+            return k;
+        }
+        // Walk down the taller tree's inner spine to a black node as high as
+        // the other tree, put k there as a red node and fix up like an insert
+        RBTreeNode<K, V, Ranked> *parent = nullptr;
+        RBTreeNode<K, V, Ranked> *top;
+        if (leftHeight > rightHeight) {
+            auto c = l;
+            for (auto height = leftHeight; height > rightHeight || (c != nullptr && c->color() == RED); c = c->right) {
+                if (c->color() == BLACK) --height;
+                parent = c;
+            }
+            k->left = c;
+            k->right = r;
+            parent->right = k;
+            top = l;
+        } else {
+            auto c = r;
+            for (auto height = rightHeight; height > leftHeight || (c != nullptr && c->color() == RED); c = c->left) {
+                if (c->color() == BLACK) --height;
+                parent = c;
+            }
+            k->left = l;
+            k->right = c;
+            parent->left = k;
+            top = r;
+        }
+        k->setParent(parent);
+        if (k->left != nullptr) k->left->setParent(k);
+        if (k->right != nullptr) k->right->setParent(k);
+        k->setColor(RED);
+        if constexpr (Ranked) {
+            k->size = subtreeSize(k->left) + subtreeSize(k->right) + 1;
+            resizePath(parent, k->size - subtreeSize(leftHeight > rightHeight ? k->left : k->right));
+        }
+        height = std::max(leftHeight, rightHeight) + insertFixup(k, top);
+        return top;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::joinTrees(RBTreeNode<K, V, Ranked> *l, RBTreeNode<K, V, Ranked> *r) {
+        if (l == nullptr || r == nullptr) {
+            auto t = l != nullptr ? l : r;
+            if (t != nullptr) {
+                t->setParent(nullptr);
+                t->setColor(BLACK);
+            }
+            return t;
+        }
+        RBTreeNode<K, V, Ranked> *last;
+        auto rest = splitLast(l, last);
+        return joinTrees(rest, last, r);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::splitLast(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *&last) {
+        if (x->right == nullptr) {
+            last = x;
+            return x->left;
+        }
+        auto rest = splitLast(x->right, last);
+        return joinTrees(x->left, x, rest);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::NodePair Map<K, V, Compare, Filter, Alloc, Ranked>::splitTree(RBTreeNode<K, V, Ranked> *x, const K &key, RBTreeNode<K, V, Ranked> *&match) {
+        size_t lowHeight, highHeight;
+        return splitTree(x, blackHeight(x) + (x != nullptr && x->color() == RED), key, match, lowHeight, highHeight);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    typename Map<K, V, Compare, Filter, Alloc, Ranked>::NodePair Map<K, V, Compare, Filter, Alloc, Ranked>::splitTree(RBTreeNode<K, V, Ranked> *x, size_t height, const K &key, RBTreeNode<K, V, Ranked> *&match, size_t &lowHeight, size_t &highHeight) {
+        if (x == nullptr) {
+            match = nullptr;
+            lowHeight = highHeight = 0;
+            return NodePair(nullptr, nullptr);
+        }
+        auto left = x->left;
+        auto right = x->right;
+        // Every path below x has height - 1 black nodes, plus one for a red
+        // child once it is made a black root
+        size_t leftHeight = height - 1 + (left != nullptr && left->color() == RED);
+        size_t rightHeight = height - 1 + (right != nullptr && right->color() == RED);
+        if (cmp(x->key(), key)) {
+            size_t restHeight;
+            auto rest = splitTree(right, rightHeight, key, match, restHeight, highHeight);
+            return NodePair(joinTrees(left, leftHeight, x, rest.first, restHeight, lowHeight), rest.second);
+        }
+        if (cmp(key, x->key())) {
+            size_t restHeight;
+            auto rest = splitTree(left, leftHeight, key, match, lowHeight, restHeight);
+            return NodePair(rest.first, joinTrees(rest.second, restHeight, x, right, rightHeight, highHeight));
+        }
+        match = x;
+        x->left = nullptr;
+        x->right = nullptr;
+        if constexpr (Ranked) x->size = 1;
+        if (left != nullptr) left->setParent(nullptr);
+        if (right != nullptr) right->setParent(nullptr);
+        lowHeight = leftHeight;
+        highHeight = rightHeight;
+        return NodePair(left, right);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::unionTrees(RBTreeNode<K, V, Ranked> *a, RBTreeNode<K, V, Ranked> *b, size_t depth, Garbage &garbage) {
+        if (a == nullptr) return b;
+        if (b == nullptr) return a;
+        auto left = a->left;
+        auto right = a->right;
+        RBTreeNode<K, V, Ranked> *match;
+        auto parts = splitTree(b, a->key(), match);
+        if (match != nullptr) {
+            a->value() = std::move(match->value());
+            garbage.add(match);
+        }
+        RBTreeNode<K, V, Ranked> *l;
+        RBTreeNode<K, V, Ranked> *r;
+        Garbage forked;
+        size_t next = depth > 0 ? depth - 1 : 0;
+        forkJoin(depth,
+                 [&] { l = unionTrees(left, parts.first, next, forked); },
+                 [&] { r = unionTrees(right, parts.second, next, garbage); });
+        garbage.append(forked);
+        return joinTrees(l, a, r);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::intersectTrees(RBTreeNode<K, V, Ranked> *a, RBTreeNode<K, V, Ranked> *b, size_t depth, Garbage &garbage) {
+        if (a == nullptr || b == nullptr) {
+            garbage.add(a);
+            garbage.add(b);
+            return nullptr;
+        }
+        auto left = a->left;
+        auto right = a->right;
+        RBTreeNode<K, V, Ranked> *match;
+        auto parts = splitTree(b, a->key(), match);
+        RBTreeNode<K, V, Ranked> *l;
+        RBTreeNode<K, V, Ranked> *r;
+        Garbage forked;
+        size_t next = depth > 0 ? depth - 1 : 0;
+        forkJoin(depth,
+                 [&] { l = intersectTrees(left, parts.first, next, forked); },
+                 [&] { r = intersectTrees(right, parts.second, next, garbage); });
+        garbage.append(forked);
+        if (match != nullptr) {
+            garbage.add(match);
+            return joinTrees(l, a, r);
+        }
+        a->left = nullptr;
+        a->right = nullptr;
+        garbage.add(a);
+        return joinTrees(l, r);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::differenceTrees(RBTreeNode<K, V, Ranked> *a, RBTreeNode<K, V, Ranked> *b, size_t depth, Garbage &garbage) {
+        if (a == nullptr || b == nullptr) {
+            garbage.add(b);
+            return a;
+        }
+        auto left = b->left;
+        auto right = b->right;
+        b->left = nullptr;
+        b->right = nullptr;
+        garbage.add(b);
+        RBTreeNode<K, V, Ranked> *match;
+        auto parts = splitTree(a, b->key(), match);
+        garbage.add(match);
+        RBTreeNode<K, V, Ranked> *l;
+        RBTreeNode<K, V, Ranked> *r;
+        Garbage forked;
+        size_t next = depth > 0 ? depth - 1 : 0;
+        forkJoin(depth,
+                 [&] { l = differenceTrees(parts.first, left, next, forked); },
+                 [&] { r = differenceTrees(parts.second, right, next, garbage); });
+        garbage.append(forked);
+        return joinTrees(l, r);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::combine(Map &&other, SetOperation operation) {
+        if constexpr (POOLED) nodes.adopt(other.nodes);
+        size_t total = len + other.len;
+        size_t depth = total >= PARALLEL_THRESHOLD ? std::bit_width(std::thread::hardware_concurrency()) : 0;
+        Garbage garbage;
+        root = joinTrees((this->*operation)(root, other.root, depth, garbage), nullptr);
+        other.root = nullptr;
+        other.leftmost = nullptr;
+        other.rightmost = nullptr;
+        other.len = 0;
+        other.rebuildFilter(MIN_FILTER_CAPACITY);
+        len = total - eraseGarbage(garbage);
+        leftmost = minimum(root);
+        rightmost = maximum(root);
+        rebuildFilter(std::max(MIN_FILTER_CAPACITY, 2 * len));
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename F, typename G>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::forkJoin(size_t depth, F &&f, G &&g) {
+        if (depth == 0) {
+            f();
+            g();
+            return;
+        }
+        auto task = std::async(std::launch::async, std::forward<F>(f));
+        g();
+        task.get();
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::eraseSubtree(RBTreeNode<K, V, Ranked> *x) {
+        if (x == nullptr) return 0;
+        size_t count = eraseSubtree(x->left) + eraseSubtree(x->right) + 1;
+        filterRemove(x->key());
+        destroyNode(x);
+        return count;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::eraseGarbage(const Garbage &garbage) {
+        size_t count = 0;
+        for (auto x = garbage.head; x != nullptr;) {
+            // eraseSubtree frees x, and with it the link
+            auto next = x->parent();
+            count += eraseSubtree(x);
+            x = next;
+        }
+        return count;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    size_t Map<K, V, Compare, Filter, Alloc, Ranked>::subtreeSize(const RBTreeNode<K, V, Ranked> *x) {
+        if constexpr (Ranked)
+            return x != nullptr ? x->size : 0;
+        else
+            return 0;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::resizePath(RBTreeNode<K, V, Ranked> *x, ptrdiff_t delta) {
+        for (; x != nullptr; x = x->parent()) x->size += delta;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename ForwardIt>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::buildSorted(ForwardIt &first, size_t n, size_t depth, size_t redDepth,
+                                                        RBTreeNode<K, V, Ranked> *&prev) {
+        if (n == 0) return nullptr;
+        size_t leftCount = (n - 1) / 2;
+        auto left = buildSorted(first, leftCount, depth + 1, redDepth, prev);
+        RBTreeNode<K, V, Ranked> *x = nullptr;
+        try {
+            const auto &entry = *first;
+            if (prev != nullptr && !cmp(prev->key(), entry.first))
+                throw std::invalid_argument("from_sorted needs strictly ascending keys");
+            x = createNode(entry.first, entry.second);
+            ++first;
+            prev = x;
+            x->setColor(depth == redDepth ? RED : BLACK);
+            x->left = left;
+            if (left != nullptr) left->setParent(x);
+            x->right = buildSorted(first, n - 1 - leftCount, depth + 1, redDepth, prev);
+            if (x->right != nullptr) x->right->setParent(x);
+            if constexpr (Ranked) x->size = n;
+        } catch (...) {
+            // The failed right subtree cleaned up after itself
+            clearNode(x != nullptr ? x : left);
+            throw;
+        }
+        return x;
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    template<typename KeyLike>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::findNode(const KeyLike &key) const {
+        auto x = root;
+        while (x != nullptr) {
+            if (cmp(key, x->key()))
+                x = x->left;
+            else if (cmp(x->key(), key))
                 x = x->right;
             else
                 return x;
@@ -377,69 +1389,107 @@ namespace MySTL {
         return nullptr;
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::clearNode(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::clearNode(RBTreeNode<K, V, Ranked> *x) {
         if (x != nullptr) {
             clearNode(x->left);
             clearNode(x->right);
-            delete x;
+            std::destroy_at(x);
+            // A pool takes its slabs back in one go in clear
+            if constexpr (!POOLED) nodes.deallocate(x, 1);
+        }
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    RBTreeNode<K, V, Ranked> *Map<K, V, Compare, Filter, Alloc, Ranked>::createNode(const K &key, const V &value) {
+        auto x = nodes.allocate(1);
+        try {
+            return std::construct_at(x, key, value);
+        } catch (...) {
+            nodes.deallocate(x, 1);
+            throw;
         }
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::insertNode(RBTreeNode<K, V> *z) {
-        RBTreeNode<K, V> *y = nullptr;
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::destroyNode(RBTreeNode<K, V, Ranked> *x) {
+        std::destroy_at(x);
+        nodes.deallocate(x, 1);
+    }
+
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::insertNode(RBTreeNode<K, V, Ranked> *z) {
+        RBTreeNode<K, V, Ranked> *y = nullptr;
         auto x = root;
         while (x != nullptr) {
             y = x;
-            if (cmp(z->key, x->key))
+            // The key is known to be new, so every node passed gains one
+            if constexpr (Ranked) ++x->size;
+            if (cmp(z->key(), x->key()))
                 x = x->left;
             else
                 x = x->right;
         }
-        z->parent = y;
+        z->setParent(y);
         if (y == nullptr)
             root = z;
-        else if (cmp(z->key, y->key))
+        else if (cmp(z->key(), y->key()))
             y->left = z;
         else
             y->right = z;
         z->left = nullptr;
         z->right = nullptr;
-        z->color = RED;
-        insertFixup(z);
+        z->setColor(RED);
+        if (leftmost == nullptr || (y == leftmost && z == y->left)) leftmost = z;
+        if (rightmost == nullptr || (y == rightmost && z == y->right)) rightmost = z;
+        insertFixup(z, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    void Map<K, V, Compare>::deleteNode(RBTreeNode<K, V> *z) {
+    template<typename K, typename V, typename Compare, typename Filter, typename Alloc, bool Ranked>
+    void Map<K, V, Compare, Filter, Alloc, Ranked>::deleteNode(RBTreeNode<K, V, Ranked> *z) {
+        // The end nodes have no child on the outer side, so their neighbours are close by
+        if (z == leftmost) leftmost = z->right != nullptr ? minimum(z->right) : z->parent();
+        if (z == rightmost) rightmost = predecessor(z);
+        // The node unlinked is z, or its successor when z has two children
+        if constexpr (Ranked)
+            resizePath(z->left == nullptr || z->right == nullptr ? z->parent() : minimum(z->right)->parent(), -1);
         auto y = z;
-        auto yOriginalColor = y->color;
-        RBTreeNode<K, V> *x;
+        auto yOriginalColor = y->color();
+        RBTreeNode<K, V, Ranked> *x;
+        RBTreeNode<K, V, Ranked> *xParent;
         if (z->left == nullptr) {
             x = z->right;
+            xParent = z->parent();
             transplant(z, z->right);
         } else if (z->right == nullptr) {
             x = z->left;
+            xParent = z->parent();
             transplant(z, z->left);
         } else {
             y = minimum(z->right);
-            yOriginalColor = y->color;
+            yOriginalColor = y->color();
             x = y->right;
-            if (y->parent == z)
-                x->parent = y;
+            if (y->parent() == z)
+                xParent = y;
             else {
+                xParent = y->parent();
                 transplant(y, y->right);
                 y->right = z->right;
-                y->right->parent = y;
+                y->right->setParent(y);
             }
             transplant(z, y);
             y->left = z->left;
-            y->left->parent = y;
-            y->color = z->color;
+            y->left->setParent(y);
+            y->setColor(z->color());
+            if constexpr (Ranked) y->size = z->size;
         }
-        if (yOriginalColor == BLACK) deleteFixup(x);
-        delete z;
+        if (yOriginalColor == BLACK) deleteFixup(x, xParent);
+        destroyNode(z);
     }
+
+    // Map with order statistics
+    template<typename K, typename V, typename Compare = std::less<K>>
+    using RankedMap = Map<K, V, Compare, NoFilter, PoolAllocator<Pair<K, V>>, true>;
 }  // namespace MySTL
 
 #endif  // MYSTL_MAP_H
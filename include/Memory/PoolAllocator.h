@@ -0,0 +1,177 @@
+#ifndef MYSTL_POOLALLOCATOR_H
+#define MYSTL_POOLALLOCATOR_H
+
+#include <algorithm>
+#include <cstddef>
+#include <new>
+#include <utility>
+
+namespace MySTL {
+
+    // Slab allocator for node based containers, one pool per container.
+    // Single objects are carved from slabs that double in size up to
+    // MAX_SLAB_BYTES, and freed ones go on an intrusive free list, so an
+    // allocation is a pop or a pointer bump and nodes allocated together sit
+    // together in memory. release() hands every slab back at once, which
+    // turns tearing down a large tree into a few frees.
+    //
+    // A pool is movable but not copyable, and not thread-safe. Requests for
+    // more than one object bypass the pool.
+    template<class T>
+    class PoolAllocator {
+    public:
+        using value_type = T;
+        using pointer = T *;
+        using size_type = size_t;
+        using difference_type = ptrdiff_t;
+
+        template<class U>
+        struct rebind {
+            using other = PoolAllocator<U>;
+        };
+
+        PoolAllocator() noexcept = default;
+
+        PoolAllocator(const PoolAllocator &) = delete;
+
+        PoolAllocator(PoolAllocator &&other) noexcept;
+
+        PoolAllocator &operator=(const PoolAllocator &) = delete;
+
+        PoolAllocator &operator=(PoolAllocator &&other) noexcept;
+
+        ~PoolAllocator() { release(); }
+
+        pointer allocate(size_type n = 1);
+
+        void deallocate(pointer p, size_type n = 1) noexcept;
+
+        // Frees every slab. Objects still in them are not destroyed, so they
+        // must have been destroyed already or be trivially destructible.
+        void release() noexcept;
+
+        // Takes over other's slabs and free slots, leaving it empty, so
+        // objects from either pool can be freed through this one. The unused
+        // tail of other's newest slab stays reserved until release.
+        void adopt(PoolAllocator &other) noexcept;
+
+        // Bytes held in slabs, live or free
+        [[nodiscard]] size_t slabBytes() const { return reserved * sizeof(Slot); }
+
+    private:
+        static constexpr size_t MIN_SLAB_SLOTS = 32;
+        static constexpr size_t MAX_SLAB_BYTES = 256 * 1024;
+
+        // A free slot links to the next one; slot 0 of each slab links the
+        // slabs together
+        union Slot {
+            Slot *next;
+            alignas(T) unsigned char storage[sizeof(T)];
+        };
+
+        static constexpr std::align_val_t ALIGNMENT{alignof(Slot)};
+
+        Slot *slabs = nullptr;
+        Slot *freeList = nullptr;
+        // Unused tail of the newest slab
+        Slot *cursor = nullptr;
+        Slot *limit = nullptr;
+        size_t nextSlots = MIN_SLAB_SLOTS;
+        size_t reserved = 0;
+
+        void grow();
+    };
+
+    template<class T>
+    PoolAllocator<T>::PoolAllocator(PoolAllocator &&other) noexcept
+            : slabs(std::exchange(other.slabs, nullptr)),
+              freeList(std::exchange(other.freeList, nullptr)),
+              cursor(std::exchange(other.cursor, nullptr)),
+              limit(std::exchange(other.limit, nullptr)),
+              nextSlots(std::exchange(other.nextSlots, MIN_SLAB_SLOTS)),
+              reserved(std::exchange(other.reserved, 0)) {}
+
+    template<class T>
+    PoolAllocator<T> &PoolAllocator<T>::operator=(PoolAllocator &&other) noexcept {
+        if (this != &other) {
+            release();
+            slabs = std::exchange(other.slabs, nullptr);
+            freeList = std::exchange(other.freeList, nullptr);
+            cursor = std::exchange(other.cursor, nullptr);
+            limit = std::exchange(other.limit, nullptr);
+            nextSlots = std::exchange(other.nextSlots, MIN_SLAB_SLOTS);
+            reserved = std::exchange(other.reserved, 0);
+        }
+        return *this;
+    }
+
+    template<class T>
+    typename PoolAllocator<T>::pointer PoolAllocator<T>::allocate(size_type n) {
+        if (n != 1) return static_cast<pointer>(::operator new(n * sizeof(T), ALIGNMENT));
+        Slot *slot = freeList;
+        if (slot != nullptr) {
+            freeList = slot->next;
+        } else {
+            if (cursor == limit) grow();
+            slot = cursor++;
+        }
+        return reinterpret_cast<pointer>(slot->storage);
+    }
+
+    template<class T>
+    void PoolAllocator<T>::deallocate(pointer p, size_type n) noexcept {
+        if (n != 1) {
+            ::operator delete(p, ALIGNMENT);
+            return;
+        }
+        auto slot = reinterpret_cast<Slot *>(p);
+        slot->next = freeList;
+        freeList = slot;
+    }
+
+    template<class T>
+    void PoolAllocator<T>::release() noexcept {
+        while (slabs != nullptr) {
+            Slot *next = slabs->next;
+            ::operator delete(slabs, ALIGNMENT);
+            slabs = next;
+        }
+        freeList = cursor = limit = nullptr;
+        nextSlots = MIN_SLAB_SLOTS;
+        reserved = 0;
+    }
+
+    template<class T>
+    void PoolAllocator<T>::adopt(PoolAllocator &other) noexcept {
+        if (this == &other || other.slabs == nullptr) return;
+        Slot *last = other.slabs;
+        while (last->next != nullptr) last = last->next;
+        last->next = slabs;
+        slabs = std::exchange(other.slabs, nullptr);
+        if (Slot *slot = other.freeList) {
+            while (slot->next != nullptr) slot = slot->next;
+            slot->next = freeList;
+            freeList = other.freeList;
+        }
+        reserved += other.reserved;
+        nextSlots = std::max(nextSlots, other.nextSlots);
+        other.freeList = other.cursor = other.limit = nullptr;
+        other.nextSlots = MIN_SLAB_SLOTS;
+        other.reserved = 0;
+    }
+
+    template<class T>
+    void PoolAllocator<T>::grow() {
+        size_t count = nextSlots + 1;
+        auto slab = static_cast<Slot *>(::operator new(count * sizeof(Slot), ALIGNMENT));
+        slab->next = slabs;
+        slabs = slab;
+        cursor = slab + 1;
+        limit = slab + count;
+        reserved += count;
+        nextSlots = std::min(2 * nextSlots, std::max(MIN_SLAB_SLOTS, MAX_SLAB_BYTES / sizeof(Slot)));
+    }
+
+}  // namespace MySTL
+
+#endif  // MYSTL_POOLALLOCATOR_H
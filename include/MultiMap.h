@@ -1,24 +1,35 @@
 #ifndef MYSTL_MULTIMAP_H
 #define MYSTL_MULTIMAP_H
 
+#include <bit>
+#include <iterator>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+
 #include "Pair.h"
 #include "utils/RBTreeNode.h"
 #include "List.h"
 
+#include "Memory/PoolAllocator.h"
+
 namespace MySTL {
 
-    template<typename K, typename V, typename Compare = std::less<K>>
+    // Alloc is rebound to the node type and Ranked adds order statistics;
+    // see Map. Augment keeps a per-subtree summary, see NoAugment.
+    template<typename K, typename V, typename Compare = std::less<K>, typename Alloc = PoolAllocator<Pair<K, V>>,
+            bool Ranked = false, typename Augment = NoAugment>
     class MultiMap {
     public:
         class Iterator {
         public:
-            using value_type = Pair<K, V>;
-            using pointer = Pair<K, V> *;
-            using reference = Pair<K, V> &;
+            using value_type = Pair<const K, V>;
+            using pointer = Pair<const K, V> *;
+            using reference = Pair<const K, V> &;
             using difference_type = ptrdiff_t;
             using iterator_category = std::bidirectional_iterator_tag;
 
-            Iterator(RBTreeNode<K, V> *node, RBTreeNode<K, V> *root) : node(node), root(root) {}
+            Iterator(RBTreeNode<K, V, Ranked> *node, RBTreeNode<K, V, Ranked> *root) : node(node), root(root) {}
 
             Iterator(const Iterator &other) = default;
 
@@ -27,11 +38,11 @@ namespace MySTL {
             ~Iterator() = default;
 
             reference operator*() const {
-                return Pair<K, V>::make_pair(node->key, node->value);
+                return node->entry;
             }
 
             pointer operator->() const {
-                return &Pair<K, V>::make_pair(node->key, node->value);
+                return &node->entry;
             }
 
             Iterator &operator++() {
@@ -64,35 +75,35 @@ namespace MySTL {
                 return node != other.node;
             }
 
-            RBTreeNode<K, V> *node;
-            RBTreeNode<K, V> *root;
+            RBTreeNode<K, V, Ranked> *node;
+            RBTreeNode<K, V, Ranked> *root;
 
-            RBTreeNode<K, V> *increment(RBTreeNode<K, V> *x) {
+            RBTreeNode<K, V, Ranked> *increment(RBTreeNode<K, V, Ranked> *x) {
                 if (x->right != nullptr) {
                     x = x->right;
                     while (x->left)
                         x = x->left;
                 } else {
-                    auto parent = x->parent;
+                    auto parent = x->parent();
                     while (parent && x == parent->right) {
                         x = parent;
-                        parent = parent->parent;
+                        parent = parent->parent();
                     }
                     x = parent;
                 }
                 return x;
             }
 
-            RBTreeNode<K, V> *decrement(RBTreeNode<K, V> *x) {
+            RBTreeNode<K, V, Ranked> *decrement(RBTreeNode<K, V, Ranked> *x) {
                 if (x->left != nullptr) {
                     x = x->left;
                     while (x->right)
                         x = x->right;
                 } else {
-                    auto parent = x->parent;
+                    auto parent = x->parent();
                     while (parent && x == parent->left) {
                         x = parent;
-                        parent = parent->parent;
+                        parent = parent->parent();
                     }
                     x = parent;
                 }
@@ -102,13 +113,13 @@ namespace MySTL {
 
         class ReverseIterator {
         public:
-            using value_type = Pair<K, V>;
-            using pointer = Pair<K, V> *;
-            using reference = Pair<K, V> &;
+            using value_type = Pair<const K, V>;
+            using pointer = Pair<const K, V> *;
+            using reference = Pair<const K, V> &;
             using difference_type = ptrdiff_t;
             using iterator_category = std::bidirectional_iterator_tag;
 
-            ReverseIterator(RBTreeNode<K, V> *node, RBTreeNode<K, V> *root) : node(node), root(root) {}
+            ReverseIterator(RBTreeNode<K, V, Ranked> *node, RBTreeNode<K, V, Ranked> *root) : node(node), root(root) {}
 
             ReverseIterator(const ReverseIterator &other) = default;
 
@@ -117,11 +128,11 @@ namespace MySTL {
             ~ReverseIterator() = default;
 
             reference operator*() const {
-                return node->value;
+                return node->entry;
             }
 
             pointer operator->() const {
-                return &node->value;
+                return &node->entry;
             }
 
             ReverseIterator &operator++() {
@@ -155,35 +166,35 @@ namespace MySTL {
             }
 
         private:
-            RBTreeNode<K, V> *node;
-            RBTreeNode<K, V> *root;
+            RBTreeNode<K, V, Ranked> *node;
+            RBTreeNode<K, V, Ranked> *root;
 
-            RBTreeNode<K, V> *increment(RBTreeNode<K, V> *x) {
+            RBTreeNode<K, V, Ranked> *increment(RBTreeNode<K, V, Ranked> *x) {
                 if (x->left != nullptr) {
                     x = x->left;
                     while (x->right)
                         x = x->right;
                 } else {
-                    auto parent = x->parent;
+                    auto parent = x->parent();
                     while (parent && x == parent->left) {
                         x = parent;
-                        parent = parent->parent;
+                        parent = parent->parent();
                     }
                     x = parent;
                 }
                 return x;
             }
 
-            RBTreeNode<K, V> *decrement(RBTreeNode<K, V> *x) {
+            RBTreeNode<K, V, Ranked> *decrement(RBTreeNode<K, V, Ranked> *x) {
                 if (x->right != nullptr) {
                     x = x->right;
                     while (x->left)
                         x = x->left;
                 } else {
-                    auto parent = x->parent;
+                    auto parent = x->parent();
                     while (parent && x == parent->right) {
                         x = parent;
-                        parent = parent->parent;
+                        parent = parent->parent();
                     }
                     x = parent;
                 }
@@ -197,9 +208,21 @@ namespace MySTL {
         using reverse_iterator = ReverseIterator;
         using const_reverse_iterator = const ReverseIterator;
 
-        explicit MultiMap(size_t initCap = 16, double loadFactor = 0.75);
+        explicit MultiMap(const Compare &comp = Compare());
+
+        MultiMap(MultiMap &&other);
+
+        MultiMap &operator=(MultiMap &&other);
+
+        ~MultiMap() { clear(); }
+
+        // Builds a multimap from entries (anything with first and second)
+        // whose keys are ascending in O(n), see Map::from_sorted. Equal keys
+        // may repeat; throws std::invalid_argument when a key descends.
+        template<typename ForwardIt>
+        static MultiMap from_sorted(ForwardIt first, ForwardIt last, const Compare &comp = Compare());
 
-        ~MultiMap() = default;
+        void swap(MultiMap &other) noexcept;
 
         [[nodiscard]] bool empty() const;
 
@@ -213,12 +236,25 @@ namespace MySTL {
 
         void erase(const K &key, const V &value);
 
+        // Erases one entry, returning the one after it
+        iterator erase(iterator pos);
+
         bool contains(const K &key) const;
 
         iterator find(const K &key) const;
 
+        // O(log n) when Ranked, otherwise linear in the count
         size_t count(const K &key) const;
 
+        // Number of entries with a key less than key
+        size_t rank(const K &key) const requires Ranked;
+
+        // Entry with the given rank, throws std::out_of_range past the end
+        iterator select(size_t index) const requires Ranked;
+
+        // Number of entries with a key in [lo, hi)
+        size_t count_range(const K &lo, const K &hi) const requires Ranked;
+
         iterator lower_bound(const K &key);
 
         iterator upper_bound(const K &key);
@@ -242,199 +278,347 @@ namespace MySTL {
         const_reverse_iterator crend();
 
     private:
-        RBTreeNode<K, V> *root;
+        template<typename, typename, typename, typename>
+        friend class IntervalMap;
+
+        RBTreeNode<K, V, Ranked> *root;
+        // Smallest and largest nodes, so begin and rbegin are O(1)
+        RBTreeNode<K, V, Ranked> *leftmost;
+        RBTreeNode<K, V, Ranked> *rightmost;
         size_t len;
         Compare cmp;
 
-        void clearNode(RBTreeNode<K, V> *node);
+        using NodeAllocator = typename Alloc::template rebind<RBTreeNode<K, V, Ranked>>::other;
+        // Allocators with release(), like PoolAllocator, free all nodes at once
+        static constexpr bool POOLED = requires(NodeAllocator &a) { a.release(); };
+
+        NodeAllocator nodes;
+
+        void clearNode(RBTreeNode<K, V, Ranked> *x);
 
-        RBTreeNode<K, V> *findNode(const K &key) const;
+        // Builds a balanced subtree from the next n entries, see Map
+        template<typename ForwardIt>
+        RBTreeNode<K, V, Ranked> *buildSorted(ForwardIt &first, size_t n, size_t depth, size_t redDepth,
+                                              RBTreeNode<K, V, Ranked> *&prev);
 
-        void insertNode(RBTreeNode<K, V> *z);
+        RBTreeNode<K, V, Ranked> *createNode(const K &key, const V &value);
 
-        void eraseNode(RBTreeNode<K, V> *z);
+        void destroyNode(RBTreeNode<K, V, Ranked> *x);
 
-        void eraseNode(RBTreeNode<K, V> *node, const V &value);
+        RBTreeNode<K, V, Ranked> *findNode(const K &key) const;
 
-        void leftRotate(RBTreeNode<K, V> *x);
+        // First node not less than key, or greater than it when inclusive
+        RBTreeNode<K, V, Ranked> *boundNode(const K &key, bool inclusive) const;
 
-        void rightRotate(RBTreeNode<K, V> *x);
+        // Number of entries less than key, or not greater when inclusive
+        size_t countBelow(const K &key, bool inclusive) const;
 
-        void insertFixup(RBTreeNode<K, V> *z);
+        static size_t subtreeSize(const RBTreeNode<K, V, Ranked> *x);
 
-        void eraseFixup(RBTreeNode<K, V> *x);
+        // Adds delta to the subtree sizes from x up to the root
+        static void resizePath(RBTreeNode<K, V, Ranked> *x, ptrdiff_t delta);
 
-        RBTreeNode<K, V> *minimumNode(RBTreeNode<K, V> *x) const;
+        // Updates the augmentation from x up to the root
+        static void augmentPath(RBTreeNode<K, V, Ranked> *x);
 
-        RBTreeNode<K, V> *maximumNode(RBTreeNode<K, V> *x) const;
+        void transplant(RBTreeNode<K, V, Ranked> *u, RBTreeNode<K, V, Ranked> *v);
+
+        void insertNode(RBTreeNode<K, V, Ranked> *z);
+
+        void eraseNode(RBTreeNode<K, V, Ranked> *z);
+
+        void eraseNode(RBTreeNode<K, V, Ranked> *node, const V &value);
+
+        void leftRotate(RBTreeNode<K, V, Ranked> *x);
+
+        void rightRotate(RBTreeNode<K, V, Ranked> *x);
+
+        void insertFixup(RBTreeNode<K, V, Ranked> *z);
+
+        void eraseFixup(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *xParent);
+
+        RBTreeNode<K, V, Ranked> *minimumNode(RBTreeNode<K, V, Ranked> *x) const;
+
+        RBTreeNode<K, V, Ranked> *maximumNode(RBTreeNode<K, V, Ranked> *x) const;
     };
 
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::MultiMap(const size_t initCap, const double loadFactor) : root(nullptr), len(0) {}
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::MultiMap(const Compare &comp)
+            : root(nullptr), leftmost(nullptr), rightmost(nullptr), len(0), cmp(comp) {}
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::MultiMap(MultiMap &&other) : MultiMap(other.cmp) {
+        swap(other);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment> &MultiMap<K, V, Compare, Alloc, Ranked, Augment>::operator=(MultiMap &&other) {
+        if (this != &other) {
+            clear();
+            swap(other);
+        }
+        return *this;
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    template<typename ForwardIt>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment> MultiMap<K, V, Compare, Alloc, Ranked, Augment>::from_sorted(ForwardIt first, ForwardIt last, const Compare &comp) {
+        MultiMap map(comp);
+        auto n = static_cast<size_t>(std::distance(first, last));
+        if (n == 0) return map;
+        size_t deepest = std::bit_width(n) - 1;
+        RBTreeNode<K, V, Ranked> *prev = nullptr;
+        map.root = map.buildSorted(first, n, 0, deepest == 0 ? SIZE_MAX : deepest, prev);
+        map.leftmost = map.minimumNode(map.root);
+        map.rightmost = prev;
+        map.len = n;
+        return map;
+    }
 
-    template<typename K, typename V, typename Compare>
-    bool MultiMap<K, V, Compare>::empty() const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::swap(MultiMap &other) noexcept {
+        using std::swap;
+        swap(root, other.root);
+        swap(leftmost, other.leftmost);
+        swap(rightmost, other.rightmost);
+        swap(len, other.len);
+        swap(cmp, other.cmp);
+        swap(nodes, other.nodes);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    bool MultiMap<K, V, Compare, Alloc, Ranked, Augment>::empty() const {
         return len == 0;
     }
 
-    template<typename K, typename V, typename Compare>
-    size_t MultiMap<K, V, Compare>::size() const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::size() const {
         return len;
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::clear() {
-        clearNode(root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::clear() {
+        // With a pool the walk only runs destructors, whole slabs are freed after
+        if constexpr (!POOLED || !std::is_trivially_destructible_v<RBTreeNode<K, V, Ranked>>) clearNode(root);
+        if constexpr (POOLED) nodes.release();
         root = nullptr;
+        leftmost = nullptr;
+        rightmost = nullptr;
         len = 0;
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::insert(const K &key, const V &value) {
-        auto newNode = new RBTreeNode<K, V>(key, value);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::insert(const K &key, const V &value) {
+        auto newNode = createNode(key, value);
         insertNode(newNode);
         ++len;
     }
 
-    template<typename K, typename V, typename Compare>
-    size_t MultiMap<K, V, Compare>::erase(const K &key) {
-        auto range = equal_range(key);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::erase(const K &key) {
         size_t count = 0;
-
-        for (auto it = range.first; it != range.second; ++it) {
-            eraseNode(it.node);
+        auto x = boundNode(key, false);
+        while (x != nullptr && !cmp(key, x->key())) {
+            // Erasing relinks nodes without moving entries, so the successor stays valid
+            auto next = iterator(x, root).increment(x);
+            eraseNode(x);
+            x = next;
             ++count;
         }
         len -= count;
         return count;
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::erase(const K &key, const V &value) {
-        auto range = equal_range(key);
-        for (auto it = range.first; it != range.second; ++it) {
-            if (it->second == value) {
-                eraseNode(it.node);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::erase(const K &key, const V &value) {
+        for (auto x = boundNode(key, false); x != nullptr && !cmp(key, x->key()); x = iterator(x, root).increment(x)) {
+            if (x->value() == value) {
+                eraseNode(x);
                 --len;
                 return;
             }
         }
     }
 
-    template<typename K, typename V, typename Compare>
-    bool MultiMap<K, V, Compare>::contains(const K &key) const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    typename MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::erase(iterator pos) {
+        auto next = pos.increment(pos.node);
+        eraseNode(pos.node);
+        --len;
+        return iterator(next, root);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    bool MultiMap<K, V, Compare, Alloc, Ranked, Augment>::contains(const K &key) const {
         return findNode(key) != nullptr;
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::iterator MultiMap<K, V, Compare>::find(const K &key) const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::find(const K &key) const {
         return iterator(findNode(key), root);
     }
 
-    template<typename K, typename V, typename Compare>
-    size_t MultiMap<K, V, Compare>::count(const K &key) const {
-        auto range = equal_range(key);
-        size_t count = 0;
-        for (auto it = range.first; it != range.second; ++it) {
-            ++count;
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::count(const K &key) const {
+        if constexpr (Ranked) {
+            return countBelow(key, true) - countBelow(key, false);
+        } else {
+            size_t count = 0;
+            for (iterator it(boundNode(key, false), root), last(boundNode(key, true), root); it != last; ++it) ++count;
+            return count;
         }
-        return count;
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::iterator MultiMap<K, V, Compare>::lower_bound(const K &key) {
-        auto x = root;
-        decltype(root) res = nullptr;
-        while (x != nullptr) {
-            if (!cmp(x->key, key)) {
-                res = x;
-                x = x->left;
-            } else {
-                x = x->right;
-            }
-        }
-        return iterator(res, root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::rank(const K &key) const requires Ranked {
+        return countBelow(key, false);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::iterator MultiMap<K, V, Compare>::upper_bound(const K &key) {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    typename MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::select(size_t index) const requires Ranked {
+        if (index >= len) throw std::out_of_range("Rank out of range");
         auto x = root;
-        decltype(root) res = nullptr;
-        while (x != nullptr) {
-            if (cmp(key, x->key)) {
-                res = x;
+        while (true) {
+            size_t left = subtreeSize(x->left);
+            if (index == left) return iterator(x, root);
+            if (index < left) {
                 x = x->left;
             } else {
+                index -= left + 1;
                 x = x->right;
             }
         }
-        return iterator(res, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    Pair<typename MultiMap<K, V, Compare>::iterator, typename MultiMap<K, V, Compare>::iterator>
-    MultiMap<K, V, Compare>::equal_range(const K &key) {
-        return Pair<typename MultiMap<K, V, Compare>::iterator, typename MultiMap<K, V, Compare>::iterator>(
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::count_range(const K &lo, const K &hi) const requires Ranked {
+        if (!cmp(lo, hi)) return 0;
+        return countBelow(hi, false) - countBelow(lo, false);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::lower_bound(const K &key) {
+        return iterator(boundNode(key, false), root);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::upper_bound(const K &key) {
+        return iterator(boundNode(key, true), root);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    Pair<typename MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator, typename MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::equal_range(const K &key) {
+        return Pair<typename MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator, typename MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator>(
                 lower_bound(key), upper_bound(key));
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::iterator MultiMap<K, V, Compare>::begin() {
-        return MultiMap<K, V, Compare>::iterator(minimumNode(root), root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::begin() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator(leftmost, root);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::end() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::iterator(nullptr, root);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::cbegin() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_iterator(leftmost, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::iterator MultiMap<K, V, Compare>::end() {
-        return MultiMap<K, V, Compare>::iterator(nullptr, root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::cend() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_iterator(nullptr, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::const_iterator MultiMap<K, V, Compare>::cbegin() {
-        return MultiMap<K, V, Compare>::const_iterator(minimumNode(root), root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::reverse_iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::rbegin() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::reverse_iterator(rightmost, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::const_iterator MultiMap<K, V, Compare>::cend() {
-        return MultiMap<K, V, Compare>::const_iterator(nullptr, root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::reverse_iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::rend() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::reverse_iterator(nullptr, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::reverse_iterator MultiMap<K, V, Compare>::rbegin() {
-        return MultiMap<K, V, Compare>::reverse_iterator(maximumNode(root), root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_reverse_iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::crbegin() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_reverse_iterator(rightmost, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::reverse_iterator MultiMap<K, V, Compare>::rend() {
-        return MultiMap<K, V, Compare>::reverse_iterator(nullptr, root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_reverse_iterator MultiMap<K, V, Compare, Alloc, Ranked, Augment>::crend() {
+        return MultiMap<K, V, Compare, Alloc, Ranked, Augment>::const_reverse_iterator(nullptr, root);
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::const_reverse_iterator MultiMap<K, V, Compare>::crbegin() {
-        return MultiMap<K, V, Compare>::const_reverse_iterator(maximumNode(root), root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::clearNode(RBTreeNode<K, V, Ranked> *x) {
+        if (x != nullptr) {
+            clearNode(x->left);
+            clearNode(x->right);
+            std::destroy_at(x);
+            // A pool takes its slabs back in one go in clear
+            if constexpr (!POOLED) nodes.deallocate(x, 1);
+        }
     }
 
-    template<typename K, typename V, typename Compare>
-    MultiMap<K, V, Compare>::const_reverse_iterator MultiMap<K, V, Compare>::crend() {
-        return MultiMap<K, V, Compare>::const_reverse_iterator(nullptr, root);
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    template<typename ForwardIt>
+    RBTreeNode<K, V, Ranked> *MultiMap<K, V, Compare, Alloc, Ranked, Augment>::buildSorted(ForwardIt &first, size_t n, size_t depth, size_t redDepth,
+                                                 RBTreeNode<K, V, Ranked> *&prev) {
+        if (n == 0) return nullptr;
+        size_t leftCount = (n - 1) / 2;
+        auto left = buildSorted(first, leftCount, depth + 1, redDepth, prev);
+        RBTreeNode<K, V, Ranked> *x = nullptr;
+        try {
+            const auto &entry = *first;
+            if (prev != nullptr && cmp(entry.first, prev->key()))
+                throw std::invalid_argument("from_sorted needs ascending keys");
+            x = createNode(entry.first, entry.second);
+            ++first;
+            prev = x;
+            x->setColor(depth == redDepth ? RED : BLACK);
+            x->left = left;
+            if (left != nullptr) left->setParent(x);
+            x->right = buildSorted(first, n - 1 - leftCount, depth + 1, redDepth, prev);
+            if (x->right != nullptr) x->right->setParent(x);
+            if constexpr (Ranked) x->size = n;
+            if constexpr (Augment::enabled) Augment::update(x);
+        } catch (...) {
+            // The failed right subtree cleaned up after itself
+            clearNode(x != nullptr ? x : left);
+            throw;
+        }
+        return x;
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::clearNode(RBTreeNode<K, V> *node) {
-        if (node != nullptr) {
-            clearNode(node->left);
-            clearNode(node->right);
-            delete node;
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    RBTreeNode<K, V, Ranked> *MultiMap<K, V, Compare, Alloc, Ranked, Augment>::createNode(const K &key, const V &value) {
+        auto x = nodes.allocate(1);
+        try {
+            return std::construct_at(x, key, value);
+        } catch (...) {
+            nodes.deallocate(x, 1);
+            throw;
         }
     }
 
-    template<typename K, typename V, typename Compare>
-    RBTreeNode<K, V> *MultiMap<K, V, Compare>::findNode(const K &key) const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::destroyNode(RBTreeNode<K, V, Ranked> *x) {
+        std::destroy_at(x);
+        nodes.deallocate(x, 1);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    RBTreeNode<K, V, Ranked> *MultiMap<K, V, Compare, Alloc, Ranked, Augment>::findNode(const K &key) const {
         auto x = root;
         while (x != nullptr) {
-            if (cmp(key, x->key)) {
+            if (cmp(key, x->key())) {
                 x = x->left;
-            } else if (cmp(x->key, key)) {
+            } else if (cmp(x->key(), key)) {
                 x = x->right;
             } else {
                 return x;
@@ -443,210 +627,315 @@ namespace MySTL {
         return nullptr;
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::insertNode(RBTreeNode<K, V> *z) {
-        RBTreeNode<K, V> *y = nullptr;
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    RBTreeNode<K, V, Ranked> *MultiMap<K, V, Compare, Alloc, Ranked, Augment>::boundNode(const K &key, bool inclusive) const {
+        auto x = root;
+        decltype(root) res = nullptr;
+        while (x != nullptr) {
+            if (inclusive ? cmp(key, x->key()) : !cmp(x->key(), key)) {
+                res = x;
+                x = x->left;
+            } else {
+                x = x->right;
+            }
+        }
+        return res;
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::countBelow(const K &key, bool inclusive) const {
+        size_t count = 0;
+        for (auto x = root; x != nullptr;) {
+            if (inclusive ? !cmp(key, x->key()) : cmp(x->key(), key)) {
+                count += subtreeSize(x->left) + 1;
+                x = x->right;
+            } else {
+                x = x->left;
+            }
+        }
+        return count;
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    size_t MultiMap<K, V, Compare, Alloc, Ranked, Augment>::subtreeSize(const RBTreeNode<K, V, Ranked> *x) {
+        if constexpr (Ranked)
+            return x != nullptr ? x->size : 0;
+        else
+            return 0;
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::resizePath(RBTreeNode<K, V, Ranked> *x, ptrdiff_t delta) {
+        for (; x != nullptr; x = x->parent()) x->size += delta;
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::augmentPath(RBTreeNode<K, V, Ranked> *x) {
+        for (; x != nullptr; x = x->parent()) Augment::update(x);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::transplant(RBTreeNode<K, V, Ranked> *u, RBTreeNode<K, V, Ranked> *v) {
+        if (u->parent() == nullptr)
+            root = v;
+        else if (u == u->parent()->left)
+            u->parent()->left = v;
+        else
+            u->parent()->right = v;
+
+        if (v != nullptr) v->setParent(u->parent());
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::insertNode(RBTreeNode<K, V, Ranked> *z) {
+        RBTreeNode<K, V, Ranked> *y = nullptr;
         auto x = root;
         while (x != nullptr) {
             y = x;
-            if (cmp(z->key, x->key))
+            if constexpr (Ranked) ++x->size;
+            if (cmp(z->key(), x->key()))
                 x = x->left;
             else
                 x = x->right;
         }
-        z->parent = y;
+        z->setParent(y);
         if (y == nullptr)
             root = z;
-        else if (cmp(z->key, y->key))
+        else if (cmp(z->key(), y->key()))
             y->left = z;
         else
             y->right = z;
         z->left = nullptr;
         z->right = nullptr;
-        z->color = RED;
+        z->setColor(RED);
+        // Equal keys go right, so a new smallest key lands left of leftmost
+        if (leftmost == nullptr || (y == leftmost && z == y->left)) leftmost = z;
+        if (rightmost == nullptr || (y == rightmost && z == y->right)) rightmost = z;
+        if constexpr (Augment::enabled) augmentPath(z);
         insertFixup(z);
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::eraseNode(RBTreeNode<K, V> *z) {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::eraseNode(RBTreeNode<K, V, Ranked> *z) {
+        // The end nodes have no child on the outer side, so their neighbours are close by
+        if (z == leftmost) leftmost = z->right != nullptr ? minimumNode(z->right) : z->parent();
+        if (z == rightmost) rightmost = z->left != nullptr ? maximumNode(z->left) : z->parent();
+        // The node unlinked is z, or its successor when z has two children
+        if constexpr (Ranked)
+            resizePath(z->left == nullptr || z->right == nullptr ? z->parent() : minimumNode(z->right)->parent(), -1);
         auto y = z;
-        auto yOriginalColor = y->color;
-        RBTreeNode<K, V> *x;
+        auto yOriginalColor = y->color();
+        RBTreeNode<K, V, Ranked> *x;
+        RBTreeNode<K, V, Ranked> *xParent;
         if (z->left == nullptr) {
             x = z->right;
+            xParent = z->parent();
             transplant(z, z->right);
         } else if (z->right == nullptr) {
             x = z->left;
+            xParent = z->parent();
             transplant(z, z->left);
         } else {
-            y = minimum(z->right);
-            yOriginalColor = y->color;
+            y = minimumNode(z->right);
+            yOriginalColor = y->color();
             x = y->right;
-            if (y->parent == z)
-                x->parent = y;
+            if (y->parent() == z)
+                xParent = y;
             else {
+                xParent = y->parent();
                 transplant(y, y->right);
                 y->right = z->right;
-                y->right->parent = y;
+                y->right->setParent(y);
             }
             transplant(z, y);
             y->left = z->left;
-            y->left->parent = y;
-            y->color = z->color;
+            y->left->setParent(y);
+            y->setColor(z->color());
+            if constexpr (Ranked) y->size = z->size;
         }
-        if (yOriginalColor == BLACK) deleteFixup(x);
-        delete z;
+        // Rotations in the fixup keep the augmentation of the nodes they move
+        if constexpr (Augment::enabled) augmentPath(xParent);
+        if (yOriginalColor == BLACK) eraseFixup(x, xParent);
+        destroyNode(z);
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::eraseNode(RBTreeNode<K, V> *node, const V &value) {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::eraseNode(RBTreeNode<K, V, Ranked> *node, const V &value) {
 
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::leftRotate(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::leftRotate(RBTreeNode<K, V, Ranked> *x) {
         auto y = x->right;
         x->right = y->left;
 
-        if (y->left != nullptr) y->left->parent = x;
-        y->parent = x->parent;
+        if (y->left != nullptr) y->left->setParent(x);
+        y->setParent(x->parent());
 
-        if (x->parent == nullptr)
+        if (x->parent() == nullptr)
             root = y;
-        else if (x == x->parent->left)
-            x->parent->left = y;
+        else if (x == x->parent()->left)
+            x->parent()->left = y;
         else
-            x->parent->right = y;
+            x->parent()->right = y;
+
+        y->left = x;
+        x->setParent(y);
+        if constexpr (Ranked) {
+            y->size = x->size;
+            x->size = subtreeSize(x->left) + subtreeSize(x->right) + 1;
+        }
+        if constexpr (Augment::enabled) {
+            Augment::update(x);
+            Augment::update(y);
+        }
     }
 
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::rightRotate(RBTreeNode<K, V> *x) {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::rightRotate(RBTreeNode<K, V, Ranked> *x) {
         auto y = x->left;
         x->left = y->right;
 
-        if (y->right != nullptr) y->right->parent = x;
-        y->parent = x->parent;
+        if (y->right != nullptr) y->right->setParent(x);
+        y->setParent(x->parent());
 
-        if (x->parent == nullptr)
+        if (x->parent() == nullptr)
             root = y;
-        else if (x == x->parent->right)
-            x->parent->right = y;
+        else if (x == x->parent()->right)
+            x->parent()->right = y;
         else
-            x->parent->left = y;
+            x->parent()->left = y;
 
         y->right = x;
-        x->parent = y;
-    }
-
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::insertFixup(RBTreeNode<K, V> *z) {
-        while (z->parent != nullptr && z->parent->color == RED) {
-            if (z->parent == z->parent->parent->left) {
-                auto y = z->parent->parent->right;
-                if (y != nullptr && y->color == RED) {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
+        x->setParent(y);
+        if constexpr (Ranked) {
+            y->size = x->size;
+            x->size = subtreeSize(x->left) + subtreeSize(x->right) + 1;
+        }
+        if constexpr (Augment::enabled) {
+            Augment::update(x);
+            Augment::update(y);
+        }
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::insertFixup(RBTreeNode<K, V, Ranked> *z) {
+        while (z->parent() != nullptr && z->parent()->color() == RED) {
+            if (z->parent() == z->parent()->parent()->left) {
+                auto y = z->parent()->parent()->right;
+                if (y != nullptr && y->color() == RED) {
+                    z->parent()->setColor(BLACK);
+                    y->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    z = z->parent()->parent();
                 } else {
-                    if (z == z->parent->right) {
-                        z = z->parent;
+                    if (z == z->parent()->right) {
+                        z = z->parent();
                         leftRotate(z);
                     }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    rightRotate(z->parent->parent);
+                    z->parent()->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    rightRotate(z->parent()->parent());
                 }
             } else {
-                auto y = z->parent->parent->left;
-                if (y != nullptr && y->color == RED) {
-                    z->parent->color = BLACK;
-                    y->color = BLACK;
-                    z->parent->parent->color = RED;
-                    z = z->parent->parent;
+                auto y = z->parent()->parent()->left;
+                if (y != nullptr && y->color() == RED) {
+                    z->parent()->setColor(BLACK);
+                    y->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    z = z->parent()->parent();
                 } else {
-                    if (z == z->parent->left) {
-                        z = z->parent;
+                    if (z == z->parent()->left) {
+                        z = z->parent();
                         rightRotate(z);
                     }
-                    z->parent->color = BLACK;
-                    z->parent->parent->color = RED;
-                    leftRotate(z->parent->parent);
+                    z->parent()->setColor(BLACK);
+                    z->parent()->parent()->setColor(RED);
+                    leftRotate(z->parent()->parent());
                 }
             }
         }
-        root->color = BLACK;
-    }
-
-    template<typename K, typename V, typename Compare>
-    void MultiMap<K, V, Compare>::eraseFixup(RBTreeNode<K, V> *x) {
-        while (x != root && (x == nullptr || x->color == BLACK)) {
-            if (x == x->parent->left) {
-                auto w = x->parent->right;
-                if (w->color == RED) {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    leftRotate(x->parent);
-                    w = x->parent->right;
+        root->setColor(BLACK);
+    }
+
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    void MultiMap<K, V, Compare, Alloc, Ranked, Augment>::eraseFixup(RBTreeNode<K, V, Ranked> *x, RBTreeNode<K, V, Ranked> *xParent) {
+        // x may be nullptr, so its parent is tracked separately
+        while (x != root && (x == nullptr || x->color() == BLACK)) {
+            if (x == xParent->left) {
+                auto w = xParent->right;
+                if (w->color() == RED) {
+                    w->setColor(BLACK);
+                    xParent->setColor(RED);
+                    leftRotate(xParent);
+                    w = xParent->right;
                 }
-                if ((w->left == nullptr || w->left->color == BLACK) &&
-                    (w->right == nullptr || w->right->color == BLACK)) {
-                    w->color = RED;
-                    x = x->parent;
+                if ((w->left == nullptr || w->left->color() == BLACK) &&
+                    (w->right == nullptr || w->right->color() == BLACK)) {
+                    w->setColor(RED);
+                    x = xParent;
+                    xParent = x->parent();
                 } else {
-                    if (w->right == nullptr || w->right->color == BLACK) {
-                        if (w->left != nullptr) w->left->color = BLACK;
-                        w->color = RED;
+                    if (w->right == nullptr || w->right->color() == BLACK) {
+                        if (w->left != nullptr) w->left->setColor(BLACK);
+                        w->setColor(RED);
                         rightRotate(w);
-                        w = x->parent->right;
+                        w = xParent->right;
                     }
-                    if (w != nullptr) w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    if (w->right != nullptr) w->right->color = BLACK;
-                    leftRotate(x->parent);
+                    w->setColor(xParent->color());
+                    xParent->setColor(BLACK);
+                    if (w->right != nullptr) w->right->setColor(BLACK);
+                    leftRotate(xParent);
                     x = root;
                 }
             } else {
-                auto w = x->right->left;
-                if (w->color == RED) {
-                    w->color = BLACK;
-                    x->parent->color = RED;
-                    rightRotate(x->parent);
-                    w = x->parent->left;
+                auto w = xParent->left;
+                if (w->color() == RED) {
+                    w->setColor(BLACK);
+                    xParent->setColor(RED);
+                    rightRotate(xParent);
+                    w = xParent->left;
                 }
-                if ((w->right == nullptr || w->right->color == BLACK) &&
-                    (w->left == nullptr || w->left->color == BLACK)) {
-                    w->color = RED;
-                    x = x->parent;
+                if ((w->right == nullptr || w->right->color() == BLACK) &&
+                    (w->left == nullptr || w->left->color() == BLACK)) {
+                    w->setColor(RED);
+                    x = xParent;
+                    xParent = x->parent();
                 } else {
-                    if (w->left == nullptr || w->left->color == BLACK) {
-                        if (w->right != nullptr) w->right->color = BLACK;
-                        w->color = RED;
+                    if (w->left == nullptr || w->left->color() == BLACK) {
+                        if (w->right != nullptr) w->right->setColor(BLACK);
+                        w->setColor(RED);
                         leftRotate(w);
-                        w = x->parent->left;
+                        w = xParent->left;
                     }
-                    if (w != nullptr) w->color = x->parent->color;
-                    x->parent->color = BLACK;
-                    if (w->left != nullptr) w->left->color = BLACK;
-                    rightRotate(x->parent);
+                    w->setColor(xParent->color());
+                    xParent->setColor(BLACK);
+                    if (w->left != nullptr) w->left->setColor(BLACK);
+                    rightRotate(xParent);
                     x = root;
                 }
             }
         }
-        if (x != nullptr) x->color = BLACK;
+        if (x != nullptr) x->setColor(BLACK);
     }
 
-    template<typename K, typename V, typename Compare>
-    RBTreeNode<K, V> *MultiMap<K, V, Compare>::minimumNode(RBTreeNode<K, V> *x) const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    RBTreeNode<K, V, Ranked> *MultiMap<K, V, Compare, Alloc, Ranked, Augment>::minimumNode(RBTreeNode<K, V, Ranked> *x) const {
+        if (x == nullptr) return nullptr;
         while (x->left != nullptr) x = x->left;
         return x;
     }
 
-    template<typename K, typename V, typename Compare>
-    RBTreeNode<K, V> *MultiMap<K, V, Compare>::maximumNode(RBTreeNode<K, V> *x) const {
+    template<typename K, typename V, typename Compare, typename Alloc, bool Ranked, typename Augment>
+    RBTreeNode<K, V, Ranked> *MultiMap<K, V, Compare, Alloc, Ranked, Augment>::maximumNode(RBTreeNode<K, V, Ranked> *x) const {
+        if (x == nullptr) return nullptr;
         while (x->right != nullptr) x = x->right;
         return x;
     }
+
+    // MultiMap with order statistics
+    template<typename K, typename V, typename Compare = std::less<K>>
+    using RankedMultiMap = MultiMap<K, V, Compare, PoolAllocator<Pair<K, V>>, true>;
 }
 
 
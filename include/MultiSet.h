@@ -6,13 +6,13 @@
 
 namespace MySTL {
 
-    template<typename T, typename Compare = std::less<T> >
+    template<typename T, typename Compare = std::less<T>, typename Alloc = PoolAllocator<T>, bool Ranked = false>
     class MultiSet {
     public:
-        using iterator = typename MultiMap<T, bool, Compare>::iterator;
-        using const_iterator = typename MultiMap<T, bool, Compare>::const_iterator;
-        using reverse_iterator = typename MultiMap<T, bool, Compare>::reverse_iterator;
-        using const_reverse_iterator = typename MultiMap<T, bool, Compare>::const_reverse_iterator;
+        using iterator = typename MultiMap<T, bool, Compare, Alloc, Ranked>::iterator;
+        using const_iterator = typename MultiMap<T, bool, Compare, Alloc, Ranked>::const_iterator;
+        using reverse_iterator = typename MultiMap<T, bool, Compare, Alloc, Ranked>::reverse_iterator;
+        using const_reverse_iterator = typename MultiMap<T, bool, Compare, Alloc, Ranked>::const_reverse_iterator;
 
 
         explicit MultiSet(const Compare &comp = Compare()) : map(comp), len(0) {}
@@ -32,10 +32,19 @@ namespace MySTL {
             return count;
         }
 
-        size_t count(const T &t) {
+        size_t count(const T &t) const {
             return map.count(t);
         }
 
+        // Number of elements less than t
+        size_t rank(const T &t) const requires Ranked { return map.rank(t); }
+
+        // Element with the given rank, throws std::out_of_range past the end
+        iterator select(size_t index) const requires Ranked { return map.select(index); }
+
+        // Number of elements in [lo, hi)
+        size_t count_range(const T &lo, const T &hi) const requires Ranked { return map.count_range(lo, hi); }
+
         bool contains(const T &t) const { return map.contains(t); }
 
         void clear() {
@@ -70,11 +79,15 @@ namespace MySTL {
 
 
     private:
-        using MapType = MultiMap<T, bool, Compare>;
+        using MapType = MultiMap<T, bool, Compare, Alloc, Ranked>;
         MapType map;
         size_t len;
     };
 
+    // MultiSet with order statistics
+    template<typename T, typename Compare = std::less<T>>
+    using RankedMultiSet = MultiSet<T, Compare, PoolAllocator<T>, true>;
+
 }
 
 
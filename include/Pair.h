@@ -2,6 +2,8 @@
 #define MYSTL_PAIR_H
 
 #include <algorithm>
+#include <tuple>
+#include <utility>
 
 namespace MySTL {
     template<typename T1, typename T2>
@@ -9,7 +11,15 @@ namespace MySTL {
     public:
         Pair() = default;
 
-        Pair(const T1 &first, const T2 &second);
+        constexpr Pair(const T1 &first, const T2 &second);
+
+        template<typename U1, typename U2>
+        constexpr Pair(U1 &&first, U2 &&second);
+
+        // Constructs each member in place from its own argument tuple
+        template<typename... Args1, typename... Args2>
+        Pair(std::piecewise_construct_t, std::tuple<Args1...> firstArgs,
+             std::tuple<Args2...> secondArgs);
 
         Pair(const Pair<T1, T2> &other) = default;
 
@@ -44,9 +54,21 @@ namespace MySTL {
     };
 
     template<typename T1, typename T2>
-    Pair<T1, T2>::Pair(const T1 &first, const T2 &second)
+    constexpr Pair<T1, T2>::Pair(const T1 &first, const T2 &second)
             : first(first), second(second) {}
 
+    template<typename T1, typename T2>
+    template<typename U1, typename U2>
+    constexpr Pair<T1, T2>::Pair(U1 &&first, U2 &&second)
+            : first(std::forward<U1>(first)), second(std::forward<U2>(second)) {}
+
+    template<typename T1, typename T2>
+    template<typename... Args1, typename... Args2>
+    Pair<T1, T2>::Pair(std::piecewise_construct_t, std::tuple<Args1...> firstArgs,
+                       std::tuple<Args2...> secondArgs)
+            : first(std::make_from_tuple<T1>(std::move(firstArgs))),
+              second(std::make_from_tuple<T2>(std::move(secondArgs))) {}
+
     template<typename T1, typename T2>
     bool Pair<T1, T2>::operator==(const Pair<T1, T2> &other) const {
         return first == other.first && second == other.second;
@@ -0,0 +1,390 @@
+#ifndef MYSTL_PERSISTENTMAP_H
+#define MYSTL_PERSISTENTMAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#include "Pair.h"
+
+namespace MySTL {
+
+    // Immutable ordered map. insert and erase leave the map they are called
+    // on untouched and return a new version that shares every subtree off
+    // the changed path, so an update allocates O(log n) nodes. Nodes are
+    // reference counted atomically: a version is copied in O(1) and can be
+    // read from any number of threads without locks, since nothing reachable
+    // from it ever changes. Writers publish a new version by swapping, for
+    // example, a std::atomic<std::shared_ptr<const PersistentMap>>.
+    //
+    // The tree is an AVL tree rather than red-black: with no parent links
+    // to fix up, its erase rebalances along the copied path alone.
+    template<typename K, typename V, typename Compare = std::less<K>>
+    class PersistentMap {
+        struct Node;
+
+        // Owning pointer to a shared node
+        class NodePtr {
+        public:
+            NodePtr(std::nullptr_t = nullptr) : node(nullptr) {}
+
+            // Takes over a new node's initial reference
+            explicit NodePtr(const Node *node) : node(node) {}
+
+            NodePtr(const NodePtr &other) : node(other.node) {
+                if (node != nullptr) node->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            NodePtr(NodePtr &&other) noexcept : node(std::exchange(other.node, nullptr)) {}
+
+            NodePtr &operator=(NodePtr other) noexcept {
+                std::swap(node, other.node);
+                return *this;
+            }
+
+            ~NodePtr() {
+                if (node != nullptr && node->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) delete node;
+            }
+
+            const Node *get() const { return node; }
+
+            const Node *operator->() const { return node; }
+
+            explicit operator bool() const { return node != nullptr; }
+
+        private:
+            const Node *node;
+        };
+
+        struct Node {
+            Pair<K, V> entry;
+            NodePtr left;
+            NodePtr right;
+            int height;
+            mutable std::atomic<size_t> refs{1};
+
+            Node(const K &key, const V &value, NodePtr left, NodePtr right)
+                    : entry(key, value), left(std::move(left)), right(std::move(right)),
+                      height(1 + std::max(heightOf(this->left), heightOf(this->right))) {}
+        };
+
+    public:
+        class Iterator {
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Pair<K, V>;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Pair<K, V> *;
+            using reference = const Pair<K, V> &;
+
+            Iterator() : map(nullptr), node(nullptr) {}
+
+            Iterator(const PersistentMap *map, const Node *node) : map(map), node(node) {}
+
+            reference operator*() const { return node->entry; }
+
+            pointer operator->() const { return &node->entry; }
+
+            const K &key() const { return node->entry.first; }
+
+            const V &value() const { return node->entry.second; }
+
+            // Nodes are shared between versions and have no parent links, so
+            // the successor is found from the root in O(log n)
+            Iterator &operator++() {
+                node = map->upperNode(node->entry.first);
+                return *this;
+            }
+
+            Iterator operator++(int) {
+                auto temp = *this;
+                ++*this;
+                return temp;
+            }
+
+            bool operator==(const Iterator &other) const { return node == other.node; }
+
+            bool operator!=(const Iterator &other) const { return node != other.node; }
+
+        private:
+            const PersistentMap *map;
+            const Node *node;
+        };
+
+        using iterator = Iterator;
+        using const_iterator = Iterator;
+
+        explicit PersistentMap(const Compare &comp = Compare()) : root(nullptr), len(0), cmp(comp) {}
+
+        PersistentMap(const PersistentMap &other) = default;
+
+        PersistentMap(PersistentMap &&other) noexcept;
+
+        PersistentMap &operator=(const PersistentMap &other) = default;
+
+        PersistentMap &operator=(PersistentMap &&other) noexcept;
+
+        ~PersistentMap() = default;
+
+        [[nodiscard]] bool empty() const { return len == 0; }
+
+        [[nodiscard]] size_t size() const { return len; }
+
+        // New version with key mapped to value, inserted or assigned
+        [[nodiscard]] PersistentMap insert(const K &key, const V &value) const;
+
+        // New version without key; shares the whole tree when key is absent
+        [[nodiscard]] PersistentMap erase(const K &key) const;
+
+        const V *find(const K &key) const;
+
+        bool contains(const K &key) const;
+
+        // Throws std::out_of_range when key is absent
+        const V &at(const K &key) const;
+
+        // Calls fn(key, value) on every entry, in order
+        template<typename Fn>
+        void for_each(Fn &&fn) const;
+
+        // Calls fn(key, value) on the entries with keys in [lo, hi), in order
+        template<typename Fn>
+        void for_each_in_range(const K &lo, const K &hi, Fn &&fn) const;
+
+        iterator begin() const;
+
+        iterator end() const { return iterator(this, nullptr); }
+
+        // First entry whose key is not less than key
+        iterator lower_bound(const K &key) const;
+
+        // First entry whose key is greater than key
+        iterator upper_bound(const K &key) const { return iterator(this, upperNode(key)); }
+
+    private:
+        NodePtr root;
+        size_t len;
+        Compare cmp;
+
+        PersistentMap(NodePtr root, size_t len, const Compare &comp) : root(std::move(root)), len(len), cmp(comp) {}
+
+        static int heightOf(const NodePtr &x) { return x ? x->height : 0; }
+
+        static NodePtr makeNode(const K &key, const V &value, NodePtr left, NodePtr right);
+
+        // Makes a node over two subtrees whose heights differ by at most two,
+        // rotating when they differ by two
+        static NodePtr balance(const K &key, const V &value, NodePtr left, NodePtr right);
+
+        NodePtr insertAt(const NodePtr &x, const K &key, const V &value, bool &inserted) const;
+
+        NodePtr eraseAt(const NodePtr &x, const K &key, bool &erased) const;
+
+        static NodePtr eraseMin(const NodePtr &x);
+
+        const Node *findNode(const K &key) const;
+
+        const Node *upperNode(const K &key) const;
+
+        template<typename Fn>
+        static void forEach(const Node *x, Fn &fn);
+    };
+
+    template<typename K, typename V, typename Compare>
+    PersistentMap<K, V, Compare>::PersistentMap(PersistentMap &&other) noexcept
+            : root(std::move(other.root)), len(std::exchange(other.len, 0)), cmp(other.cmp) {}
+
+    template<typename K, typename V, typename Compare>
+    PersistentMap<K, V, Compare> &PersistentMap<K, V, Compare>::operator=(PersistentMap &&other) noexcept {
+        if (this != &other) {
+            root = std::move(other.root);
+            len = std::exchange(other.len, 0);
+            cmp = other.cmp;
+        }
+        return *this;
+    }
+
+    template<typename K, typename V, typename Compare>
+    PersistentMap<K, V, Compare> PersistentMap<K, V, Compare>::insert(const K &key, const V &value) const {
+        bool inserted = false;
+        auto newRoot = insertAt(root, key, value, inserted);
+        return PersistentMap(std::move(newRoot), len + inserted, cmp);
+    }
+
+    template<typename K, typename V, typename Compare>
+    PersistentMap<K, V, Compare> PersistentMap<K, V, Compare>::erase(const K &key) const {
+        bool erased = false;
+        auto newRoot = eraseAt(root, key, erased);
+        return PersistentMap(std::move(newRoot), len - erased, cmp);
+    }
+
+    template<typename K, typename V, typename Compare>
+    const V *PersistentMap<K, V, Compare>::find(const K &key) const {
+        auto x = findNode(key);
+        return x != nullptr ? &x->entry.second : nullptr;
+    }
+
+    template<typename K, typename V, typename Compare>
+    bool PersistentMap<K, V, Compare>::contains(const K &key) const {
+        return findNode(key) != nullptr;
+    }
+
+    template<typename K, typename V, typename Compare>
+    const V &PersistentMap<K, V, Compare>::at(const K &key) const {
+        auto x = findNode(key);
+        if (x == nullptr) throw std::out_of_range("Key not found");
+        return x->entry.second;
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename Fn>
+    void PersistentMap<K, V, Compare>::for_each(Fn &&fn) const {
+        forEach(root.get(), fn);
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename Fn>
+    void PersistentMap<K, V, Compare>::for_each_in_range(const K &lo, const K &hi, Fn &&fn) const {
+        for (auto it = lower_bound(lo); it != end() && cmp(it.key(), hi); ++it) fn(it.key(), it.value());
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::iterator PersistentMap<K, V, Compare>::begin() const {
+        auto x = root.get();
+        if (x != nullptr)
+            while (x->left) x = x->left.get();
+        return iterator(this, x);
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::iterator PersistentMap<K, V, Compare>::lower_bound(const K &key) const {
+        const Node *res = nullptr;
+        for (auto x = root.get(); x != nullptr;) {
+            if (!cmp(x->entry.first, key)) {
+                res = x;
+                x = x->left.get();
+            } else {
+                x = x->right.get();
+            }
+        }
+        return iterator(this, res);
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::NodePtr
+    PersistentMap<K, V, Compare>::makeNode(const K &key, const V &value, NodePtr left, NodePtr right) {
+        return NodePtr(new Node(key, value, std::move(left), std::move(right)));
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::NodePtr
+    PersistentMap<K, V, Compare>::balance(const K &key, const V &value, NodePtr left, NodePtr right) {
+        int leftHeight = heightOf(left);
+        int rightHeight = heightOf(right);
+        // Rotations copy the nodes they move, since those may be shared
+        if (leftHeight > rightHeight + 1) {
+            if (heightOf(left->left) >= heightOf(left->right))
+                return makeNode(left->entry.first, left->entry.second, left->left,
+                                makeNode(key, value, left->right, std::move(right)));
+            auto &mid = left->right;
+            return makeNode(mid->entry.first, mid->entry.second,
+                            makeNode(left->entry.first, left->entry.second, left->left, mid->left),
+                            makeNode(key, value, mid->right, std::move(right)));
+        }
+        if (rightHeight > leftHeight + 1) {
+            if (heightOf(right->right) >= heightOf(right->left))
+                return makeNode(right->entry.first, right->entry.second,
+                                makeNode(key, value, std::move(left), right->left), right->right);
+            auto &mid = right->left;
+            return makeNode(mid->entry.first, mid->entry.second,
+                            makeNode(key, value, std::move(left), mid->left),
+                            makeNode(right->entry.first, right->entry.second, mid->right, right->right));
+        }
+        return makeNode(key, value, std::move(left), std::move(right));
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::NodePtr
+    PersistentMap<K, V, Compare>::insertAt(const NodePtr &x, const K &key, const V &value, bool &inserted) const {
+        if (!x) {
+            inserted = true;
+            return makeNode(key, value, nullptr, nullptr);
+        }
+        const auto &entry = x->entry;
+        if (cmp(key, entry.first)) return balance(entry.first, entry.second, insertAt(x->left, key, value, inserted), x->right);
+        if (cmp(entry.first, key)) return balance(entry.first, entry.second, x->left, insertAt(x->right, key, value, inserted));
+        return makeNode(entry.first, value, x->left, x->right);
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::NodePtr
+    PersistentMap<K, V, Compare>::eraseAt(const NodePtr &x, const K &key, bool &erased) const {
+        if (!x) return nullptr;
+        const auto &entry = x->entry;
+        if (cmp(key, entry.first)) {
+            auto left = eraseAt(x->left, key, erased);
+            return erased ? balance(entry.first, entry.second, std::move(left), x->right) : x;
+        }
+        if (cmp(entry.first, key)) {
+            auto right = eraseAt(x->right, key, erased);
+            return erased ? balance(entry.first, entry.second, x->left, std::move(right)) : x;
+        }
+        erased = true;
+        if (!x->left) return x->right;
+        if (!x->right) return x->left;
+        // The successor takes x's place
+        auto successor = x->right.get();
+        while (successor->left) successor = successor->left.get();
+        return balance(successor->entry.first, successor->entry.second, x->left, eraseMin(x->right));
+    }
+
+    template<typename K, typename V, typename Compare>
+    typename PersistentMap<K, V, Compare>::NodePtr PersistentMap<K, V, Compare>::eraseMin(const NodePtr &x) {
+        if (!x->left) return x->right;
+        return balance(x->entry.first, x->entry.second, eraseMin(x->left), x->right);
+    }
+
+    template<typename K, typename V, typename Compare>
+    const typename PersistentMap<K, V, Compare>::Node *PersistentMap<K, V, Compare>::findNode(const K &key) const {
+        auto x = root.get();
+        while (x != nullptr) {
+            if (cmp(key, x->entry.first))
+                x = x->left.get();
+            else if (cmp(x->entry.first, key))
+                x = x->right.get();
+            else
+                return x;
+        }
+        return nullptr;
+    }
+
+    template<typename K, typename V, typename Compare>
+    const typename PersistentMap<K, V, Compare>::Node *PersistentMap<K, V, Compare>::upperNode(const K &key) const {
+        const Node *res = nullptr;
+        for (auto x = root.get(); x != nullptr;) {
+            if (cmp(key, x->entry.first)) {
+                res = x;
+                x = x->left.get();
+            } else {
+                x = x->right.get();
+            }
+        }
+        return res;
+    }
+
+    template<typename K, typename V, typename Compare>
+    template<typename Fn>
+    void PersistentMap<K, V, Compare>::forEach(const Node *x, Fn &fn) {
+        if (x == nullptr) return;
+        forEach(x->left.get(), fn);
+        fn(x->entry.first, x->entry.second);
+        forEach(x->right.get(), fn);
+    }
+
+}  // namespace MySTL
+
+#endif  // MYSTL_PERSISTENTMAP_H
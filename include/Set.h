@@ -1,41 +1,136 @@
 #ifndef MYSTL_SET_H
 #define MYSTL_SET_H
 
+#include <ranges>
+
 #include "Map.h"
 
 namespace MySTL {
-    template<typename T, typename Compare = std::less<T> >
+    template<typename T, typename Compare = std::less<T>, typename Alloc = PoolAllocator<T>, bool Ranked = false>
     class Set {
+        using MapType = Map<T, bool, Compare, NoFilter, Alloc, Ranked>;
+
     public:
-        explicit Set(const Compare &comp = Compare()) : map(comp), len(0) {}
+        class Iterator {
+        public:
+            using iterator_category = std::bidirectional_iterator_tag;
+            using value_type = T;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const T *;
+            using reference = const T &;
 
-        [[nodiscard]] bool empty() const { return len == 0; }
+            explicit Iterator(typename MapType::iterator it) : it(it) {}
 
-        [[nodiscard]] size_t size() const { return len; }
+            reference operator*() const { return it.key(); }
 
-        void insert(const T &t) {
-            map.insert(t, true);
-            ++len;
-        }
+            pointer operator->() const { return &it.key(); }
+
+            Iterator &operator++() {
+                ++it;
+                return *this;
+            }
+
+            Iterator &operator--() {
+                --it;
+                return *this;
+            }
+
+            bool operator==(const Iterator &other) const { return it == other.it; }
+
+            bool operator!=(const Iterator &other) const { return it != other.it; }
+
+        private:
+            friend class Set;
+
+            typename MapType::iterator it;
+        };
 
-        void erase(const T &t) {
-            map.erase(t);
-            --len;
+        using iterator = Iterator;
+        using const_iterator = const Iterator;
+
+        explicit Set(const Compare &comp = Compare()) : map(comp) {}
+
+        // Builds a set from strictly ascending elements in O(n), see Map::from_sorted
+        template<typename ForwardIt>
+        static Set from_sorted(ForwardIt first, ForwardIt last, const Compare &comp = Compare()) {
+            auto entries = std::ranges::subrange(first, last) |
+                           std::views::transform([](const T &t) { return Pair<T, bool>(t, true); });
+            return Set(MapType::from_sorted(entries.begin(), entries.end(), comp));
         }
 
+        [[nodiscard]] bool empty() const { return map.empty(); }
+
+        [[nodiscard]] size_t size() const { return map.size(); }
+
+        void insert(const T &t) { map.insert(t, true); }
+
+        void erase(const T &t) { map.erase(t); }
+
         bool contains(const T &t) const { return map.contains(t); }
 
-        void clear() {
-            map.clear();
-            len = 0;
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        void erase(const KeyLike &key) { map.erase(key); }
+
+        template<typename KeyLike>
+        requires Transparent<Compare>
+        bool contains(const KeyLike &key) const { return map.contains(key); }
+
+        void clear() { map.clear(); }
+
+        iterator begin() const { return iterator(map.cbegin()); }
+
+        iterator end() const { return iterator(map.cend()); }
+
+        // First element not less than t
+        iterator lower_bound(const T &t) const { return iterator(map.lower_bound(t)); }
+
+        // First element greater than t
+        iterator upper_bound(const T &t) const { return iterator(map.upper_bound(t)); }
+
+        Pair<iterator, iterator> equal_range(const T &t) const {
+            return Pair<iterator, iterator>(lower_bound(t), upper_bound(t));
         }
 
+        // Erases [first, last) in O(k + log n), see Map
+        iterator erase(iterator first, iterator last) { return iterator(map.erase(first.it, last.it)); }
+
+        // Calls fn(t) on the elements in [lo, hi), in order
+        template<typename Fn>
+        void for_each_in_range(const T &lo, const T &hi, Fn &&fn) {
+            map.for_each_in_range(lo, hi, [&fn](const T &t, bool) { fn(t); });
+        }
+
+        // Moves the elements not less than t into a new set, see Map::split
+        Set split(const T &t) { return Set(map.split(t)); }
+
+        // Concatenates sets with every element of left below those of right
+        static Set join(Set &&left, Set &&right) { return Set(MapType::join(std::move(left.map), std::move(right.map))); }
+
+        // Set algebra that takes over other's elements, leaving it empty; see Map
+        void union_with(Set &&other) { map.union_with(std::move(other.map)); }
+
+        void intersect_with(Set &&other) { map.intersect_with(std::move(other.map)); }
+
+        void difference_with(Set &&other) { map.difference_with(std::move(other.map)); }
+
+        // Order statistics, see Map
+        size_t rank(const T &t) const requires Ranked { return map.rank(t); }
+
+        const T &select(size_t index) const requires Ranked { return map.select(index).key(); }
+
+        size_t count_range(const T &lo, const T &hi) const requires Ranked { return map.count_range(lo, hi); }
+
     private:
-        using MapType = Map<T, bool, Compare>;
         MapType map;
-        size_t len;
+
+        explicit Set(MapType &&map) : map(std::move(map)) {}
     };
 
+    // Set with order statistics
+    template<typename T, typename Compare = std::less<T>>
+    using RankedSet = Set<T, Compare, PoolAllocator<T>, true>;
+
 }  // namespace MySTL
 
 #endif  // MYSTL_SET_H
@@ -0,0 +1,250 @@
+#ifndef MYSTL_SMALLVECTOR_H
+#define MYSTL_SMALLVECTOR_H
+
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace MySTL {
+    // Contiguous vector that keeps its first N elements inline and only
+    // allocates once it grows past them. Storage is uninitialized beyond
+    // size(), so T needs no default constructor.
+    template<typename T, size_t N = 4>
+    class SmallVector {
+        static_assert(N > 0, "SmallVector needs at least one inline element");
+
+    public:
+        SmallVector() : ptr(inlineData()), len(0), cap(N) {}
+
+        SmallVector(const SmallVector &other);
+
+        SmallVector(SmallVector &&other) noexcept;
+
+        SmallVector &operator=(const SmallVector &other);
+
+        SmallVector &operator=(SmallVector &&other) noexcept;
+
+        ~SmallVector();
+
+        [[nodiscard]] bool empty() const { return len == 0; }
+
+        [[nodiscard]] size_t size() const { return len; }
+
+        [[nodiscard]] size_t capacity() const { return cap; }
+
+        // Bytes held outside the object, 0 while the elements fit inline
+        [[nodiscard]] size_t heapBytes() const { return isInline() ? 0 : cap * sizeof(T); }
+
+        void reserve(size_t n);
+
+        void push_back(const T &value) { emplace_back(value); }
+
+        void push_back(T &&value) { emplace_back(std::move(value)); }
+
+        template<typename... Args>
+        T &emplace_back(Args &&...args);
+
+        void pop_back();
+
+        // Shifts the tail down, keeping element order
+        void erase(size_t index);
+
+        void clear();
+
+        T &operator[](size_t index) { return ptr[index]; }
+
+        const T &operator[](size_t index) const { return ptr[index]; }
+
+        T &at(size_t index);
+
+        const T &at(size_t index) const;
+
+        T &back() { return ptr[len - 1]; }
+
+        T *data() { return ptr; }
+
+        const T *data() const { return ptr; }
+
+        T *begin() { return ptr; }
+
+        T *end() { return ptr + len; }
+
+        const T *begin() const { return ptr; }
+
+        const T *end() const { return ptr + len; }
+
+    private:
+        T *ptr;
+        size_t len;
+        size_t cap;
+        alignas(T) unsigned char buffer[N * sizeof(T)];
+
+        T *inlineData() { return reinterpret_cast<T *>(buffer); }
+
+        [[nodiscard]] bool isInline() const { return ptr == reinterpret_cast<const T *>(buffer); }
+
+        void release();
+
+        void grow(size_t minCap);
+
+        // Moves the elements into fresh, which holds newCap, and frees the old
+        // storage. As in std::vector they are copied instead when a move could
+        // throw and T is copyable, so on a throw the elements already built in
+        // fresh are destroyed, the old ones are untouched and fresh is the
+        // caller's to free.
+        void relocate(T *fresh, size_t newCap);
+    };
+
+    template<typename T, size_t N>
+    SmallVector<T, N>::SmallVector(const SmallVector &other) : SmallVector() {
+        reserve(other.len);
+        std::uninitialized_copy(other.begin(), other.end(), ptr);
+        len = other.len;
+    }
+
+    template<typename T, size_t N>
+    SmallVector<T, N>::SmallVector(SmallVector &&other) noexcept : SmallVector() {
+        *this = std::move(other);
+    }
+
+    template<typename T, size_t N>
+    SmallVector<T, N> &SmallVector<T, N>::operator=(const SmallVector &other) {
+        if (this == &other) return *this;
+        clear();
+        reserve(other.len);
+        std::uninitialized_copy(other.begin(), other.end(), ptr);
+        len = other.len;
+        return *this;
+    }
+
+    template<typename T, size_t N>
+    SmallVector<T, N> &SmallVector<T, N>::operator=(SmallVector &&other) noexcept {
+        if (this == &other) return *this;
+        release();
+        if (other.isInline()) {
+            // Inline elements cannot be stolen, move them one by one
+            ptr = inlineData();
+            cap = N;
+            std::uninitialized_move(other.begin(), other.end(), ptr);
+            len = other.len;
+            other.clear();
+        } else {
+            ptr = other.ptr;
+            len = other.len;
+            cap = other.cap;
+            other.ptr = other.inlineData();
+            other.len = 0;
+            other.cap = N;
+        }
+        return *this;
+    }
+
+    template<typename T, size_t N>
+    SmallVector<T, N>::~SmallVector() {
+        release();
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::release() {
+        clear();
+        if (!isInline()) std::allocator<T>().deallocate(ptr, cap);
+        ptr = inlineData();
+        cap = N;
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::grow(size_t minCap) {
+        size_t newCap = std::max(cap * 2, minCap);
+        T *fresh = std::allocator<T>().allocate(newCap);
+        try {
+            relocate(fresh, newCap);
+        } catch (...) {
+            std::allocator<T>().deallocate(fresh, newCap);
+            throw;
+        }
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::relocate(T *fresh, size_t newCap) {
+        // Both roll back what they built if an element throws
+        if constexpr (std::is_nothrow_move_constructible_v<T> || !std::is_copy_constructible_v<T>)
+            std::uninitialized_move(ptr, ptr + len, fresh);
+        else
+            std::uninitialized_copy(ptr, ptr + len, fresh);
+        std::destroy(ptr, ptr + len);
+        if (!isInline()) std::allocator<T>().deallocate(ptr, cap);
+        ptr = fresh;
+        cap = newCap;
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::reserve(size_t n) {
+        if (n > cap) grow(n);
+    }
+
+    template<typename T, size_t N>
+    template<typename... Args>
+    T &SmallVector<T, N>::emplace_back(Args &&...args) {
+        if (len < cap) {
+            T *slot = std::construct_at(ptr + len, std::forward<Args>(args)...);
+            ++len;
+            return *slot;
+        }
+        // The arguments may refer to elements, so the new one is built before
+        // the old ones move
+        size_t newCap = cap * 2;
+        T *fresh = std::allocator<T>().allocate(newCap);
+        T *slot;
+        try {
+            slot = std::construct_at(fresh + len, std::forward<Args>(args)...);
+        } catch (...) {
+            std::allocator<T>().deallocate(fresh, newCap);
+            throw;
+        }
+        try {
+            relocate(fresh, newCap);
+        } catch (...) {
+            std::destroy_at(slot);
+            std::allocator<T>().deallocate(fresh, newCap);
+            throw;
+        }
+        ++len;
+        return *slot;
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::pop_back() {
+        if (len == 0) return;
+        --len;
+        std::destroy_at(ptr + len);
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::erase(size_t index) {
+        if (index >= len) return;
+        std::move(ptr + index + 1, ptr + len, ptr + index);
+        pop_back();
+    }
+
+    template<typename T, size_t N>
+    void SmallVector<T, N>::clear() {
+        std::destroy(ptr, ptr + len);
+        len = 0;
+    }
+
+    template<typename T, size_t N>
+    T &SmallVector<T, N>::at(size_t index) {
+        if (index >= len) throw std::out_of_range("Index out of range");
+        return ptr[index];
+    }
+
+    template<typename T, size_t N>
+    const T &SmallVector<T, N>::at(size_t index) const {
+        if (index >= len) throw std::out_of_range("Index out of range");
+        return ptr[index];
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_SMALLVECTOR_H
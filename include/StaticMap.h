@@ -0,0 +1,203 @@
+#ifndef MYSTL_STATICMAP_H
+#define MYSTL_STATICMAP_H
+
+#include <cstdint>
+#include <functional>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+
+#include "Pair.h"
+
+namespace MySTL {
+    // Seeded constexpr hash for StaticMap keys: integers, enums and anything
+    // convertible to std::string_view
+    struct StaticHash {
+        using is_transparent = void;
+
+        template<typename T>
+        requires std::is_integral_v<T> || std::is_enum_v<T>
+        constexpr uint64_t operator()(T key, uint64_t seed) const {
+            return mix(static_cast<uint64_t>(key) ^ (seed * 0x9E3779B97F4A7C15ull));
+        }
+
+        constexpr uint64_t operator()(std::string_view key, uint64_t seed) const {
+            // FNV-1a over the characters
+            uint64_t h = 0xCBF29CE484222325ull ^ (seed * 0x9E3779B97F4A7C15ull);
+            for (char c: key) {
+                h ^= static_cast<unsigned char>(c);
+                h *= 0x100000001B3ull;
+            }
+            return mix(h);
+        }
+
+    private:
+        static constexpr uint64_t mix(uint64_t h) {
+            // murmur3 finalizer
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return h;
+        }
+    };
+
+    // Immutable map over a key set fixed at compile time. The constructor
+    // builds a minimal perfect hash (hash and displace) during constant
+    // evaluation, so a constexpr StaticMap costs nothing at startup and every
+    // lookup hashes twice and compares one key.
+    //
+    // A key lands in bucket hash(key, 0) % N and then in slot
+    // hash(key, seeds[bucket]) % N; a bucket holding a single key stores its
+    // slot directly. Duplicate keys or an exhausted seed search throw, which
+    // is a compile error when the map is constexpr. Lookups with a type that
+    // has a toStringView overload, such as String, go through its view.
+    template<typename K, typename V, size_t N, typename Hash = StaticHash, typename Equal = std::equal_to<>>
+    class StaticMap {
+    public:
+        constexpr explicit StaticMap(const Pair<K, V> (&entries)[N]);
+
+        [[nodiscard]] constexpr bool empty() const { return N == 0; }
+
+        [[nodiscard]] constexpr size_t size() const { return N; }
+
+        template<typename Q>
+        constexpr const V *find(const Q &key) const;
+
+        template<typename Q>
+        constexpr bool contains(const Q &key) const { return find(key) != nullptr; }
+
+        template<typename Q>
+        constexpr const V &at(const Q &key) const;
+
+        // Entries in slot order, i = 0 .. size() - 1
+        constexpr const K &keyAt(size_t i) const { return keys[i]; }
+
+        constexpr const V &valueAt(size_t i) const { return values[i]; }
+
+    private:
+        static constexpr size_t SLOTS = N == 0 ? 1 : N;
+        static constexpr uint32_t MAX_SEED = 1u << 16;
+        static constexpr uint32_t DIRECT_SLOT = 1u << 31;
+
+        K keys[SLOTS]{};
+        V values[SLOTS]{};
+        uint32_t seeds[SLOTS]{};
+
+        template<typename Q>
+        constexpr size_t slotOf(const Q &key) const;
+    };
+
+    // Deduces N from a braced list: makeStaticMap<std::string_view, int>({{"a", 1}, {"b", 2}})
+    template<typename K, typename V, typename Hash = StaticHash, typename Equal = std::equal_to<>, size_t N>
+    constexpr StaticMap<K, V, N, Hash, Equal> makeStaticMap(const Pair<K, V> (&entries)[N]) {
+        return StaticMap<K, V, N, Hash, Equal>(entries);
+    }
+
+    template<typename K, typename V, size_t N, typename Hash, typename Equal>
+    constexpr StaticMap<K, V, N, Hash, Equal>::StaticMap(const Pair<K, V> (&entries)[N]) {
+        if constexpr (N > 0) {
+            Hash hasher;
+            Equal equal;
+            size_t bucketOf[N]{};
+            size_t bucketSize[N]{};
+            for (size_t i = 0; i < N; ++i) {
+                bucketOf[i] = hasher(entries[i].first, 0) % N;
+                ++bucketSize[bucketOf[i]];
+            }
+
+            // Bucket members grouped by bucket, buckets ordered by size descending
+            size_t bySize[N + 1]{};
+            for (size_t b = 0; b < N; ++b) ++bySize[bucketSize[b]];
+            size_t order[N]{};
+            size_t used = 0;
+            for (size_t s = N; s > 0; --s) {
+                for (size_t b = 0; b < N && bySize[s] > 0; ++b) {
+                    if (bucketSize[b] == s) order[used++] = b;
+                }
+            }
+            size_t bucketStart[N + 1]{};
+            for (size_t b = 0; b < N; ++b) bucketStart[b + 1] = bucketStart[b] + bucketSize[b];
+            size_t members[N]{};
+            size_t fill[N]{};
+            for (size_t i = 0; i < N; ++i) {
+                size_t b = bucketOf[i];
+                members[bucketStart[b] + fill[b]++] = i;
+            }
+
+            bool taken[N]{};
+            size_t slots[N]{};
+            size_t freeSlot = 0;
+            for (size_t o = 0; o < used; ++o) {
+                size_t b = order[o];
+                size_t first = bucketStart[b], last = bucketStart[b + 1];
+                for (size_t i = first; i < last; ++i) {
+                    for (size_t j = i + 1; j < last; ++j) {
+                        if (equal(entries[members[i]].first, entries[members[j]].first))
+                            throw std::invalid_argument("Duplicate key in StaticMap");
+                    }
+                }
+                if (last - first == 1) {
+                    while (taken[freeSlot]) ++freeSlot;
+                    seeds[b] = DIRECT_SLOT | static_cast<uint32_t>(freeSlot);
+                    taken[freeSlot] = true;
+                    keys[freeSlot] = entries[members[first]].first;
+                    values[freeSlot] = entries[members[first]].second;
+                    continue;
+                }
+                uint32_t seed = 1;
+                for (;; ++seed) {
+                    if (seed == MAX_SEED) throw std::runtime_error("No perfect hash found for StaticMap keys");
+                    size_t placed = 0;
+                    for (size_t i = first; i < last; ++i, ++placed) {
+                        size_t slot = hasher(entries[members[i]].first, seed) % N;
+                        if (taken[slot]) break;
+                        taken[slot] = true;
+                        slots[placed] = slot;
+                    }
+                    if (placed == last - first) break;
+                    while (placed > 0) taken[slots[--placed]] = false;
+                }
+                seeds[b] = seed;
+                for (size_t i = first; i < last; ++i) {
+                    size_t slot = slots[i - first];
+                    keys[slot] = entries[members[i]].first;
+                    values[slot] = entries[members[i]].second;
+                }
+            }
+        }
+    }
+
+    template<typename K, typename V, size_t N, typename Hash, typename Equal>
+    template<typename Q>
+    constexpr size_t StaticMap<K, V, N, Hash, Equal>::slotOf(const Q &key) const {
+        Hash hasher;
+        uint32_t seed = seeds[hasher(key, 0) % N];
+        return seed & DIRECT_SLOT ? seed & ~DIRECT_SLOT : hasher(key, seed) % N;
+    }
+
+    template<typename K, typename V, size_t N, typename Hash, typename Equal>
+    template<typename Q>
+    constexpr const V *StaticMap<K, V, N, Hash, Equal>::find(const Q &key) const {
+        if constexpr (N == 0) {
+            return nullptr;
+        } else if constexpr (!std::is_convertible_v<const Q &, std::string_view> &&
+                             requires { toStringView(key); }) {
+            return find(toStringView(key));
+        } else {
+            size_t slot = slotOf(key);
+            return Equal()(keys[slot], key) ? &values[slot] : nullptr;
+        }
+    }
+
+    template<typename K, typename V, size_t N, typename Hash, typename Equal>
+    template<typename Q>
+    constexpr const V &StaticMap<K, V, N, Hash, Equal>::at(const Q &key) const {
+        auto value = find(key);
+        if (value == nullptr) throw std::out_of_range("Key not found");
+        return *value;
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_STATICMAP_H
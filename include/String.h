@@ -1,7 +1,9 @@
 #ifndef STRING_H_
 #define STRING_H_
 
+#include <functional>
 #include <sstream>
+#include <string_view>
 
 namespace MySTL {
     // TODO: to be refactored
@@ -106,6 +108,41 @@ namespace MySTL {
         static void formatHelper(std::ostringstream &stream, const char *format,
                                  T value, Args... args);
     };
+
+    inline std::string_view toStringView(const String &str) { return str.c_str(); }
+
+    inline std::string_view toStringView(const char *str) { return str; }
+
+    inline std::string_view toStringView(std::string_view str) { return str; }
+
+    // Transparent functors for String keys: HashMap/Map lookups can take a
+    // const char * or std::string_view without building a temporary String
+    struct StringHash {
+        using is_transparent = void;
+
+        template<typename S>
+        size_t operator()(const S &str) const {
+            return std::hash<std::string_view>()(toStringView(str));
+        }
+    };
+
+    struct StringEqual {
+        using is_transparent = void;
+
+        template<typename L, typename R>
+        bool operator()(const L &lhs, const R &rhs) const {
+            return toStringView(lhs) == toStringView(rhs);
+        }
+    };
+
+    struct StringLess {
+        using is_transparent = void;
+
+        template<typename L, typename R>
+        bool operator()(const L &lhs, const R &rhs) const {
+            return toStringView(lhs) < toStringView(rhs);
+        }
+    };
 }  // namespace MySTL
 
 #endif  // STRING_H_
\ No newline at end of file
@@ -260,7 +260,6 @@ namespace MySTL {
         for (int i = 0; i < len; ++i) t[i] = data[i];
         deallocate_memory(data);
         data = t;
-        cap *= 2;
     }
 
     template<typename T>
@@ -0,0 +1,52 @@
+#ifndef MYSTL_BUCKETPOLICY_H
+#define MYSTL_BUCKETPOLICY_H
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace MySTL {
+
+    // A bucket policy decides the table capacities a hash table may use and
+    // how a hash is reduced to a bucket index within such a capacity.
+
+    // Any capacity, index by division. Needs a well distributed hasher.
+    struct ModuloPolicy {
+        static size_t capacity(size_t n) { return std::max<size_t>(n, 1); }
+
+        static size_t index(size_t hash, size_t cap) { return hash % cap; }
+    };
+
+    // Power-of-two capacities, index from the top bits of hash * 2^64/phi.
+    // The multiply spreads sequential keys, e.g. from the identity std::hash<int>.
+    struct FibonacciPolicy {
+        static size_t capacity(size_t n) { return std::bit_ceil(std::max<size_t>(n, 2)); }
+
+        static size_t index(size_t hash, size_t cap) {
+            constexpr auto golden = static_cast<size_t>(0x9E3779B97F4A7C15ull);
+            constexpr int bits = std::numeric_limits<size_t>::digits;
+            return (hash * golden) >> (bits - std::countr_zero(cap));
+        }
+    };
+
+    // Power-of-two capacities, index from the low bits of the murmur3
+    // finalizer. Costlier than FibonacciPolicy but mixes every input bit.
+    struct MixPolicy {
+        static size_t capacity(size_t n) { return std::bit_ceil(std::max<size_t>(n, 2)); }
+
+        static size_t index(size_t hash, size_t cap) {
+            uint64_t h = hash;
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return static_cast<size_t>(h) & (cap - 1);
+        }
+    };
+}
+
+
+#endif //MYSTL_BUCKETPOLICY_H
@@ -0,0 +1,46 @@
+#ifndef MYSTL_FRONTFILTER_H
+#define MYSTL_FRONTFILTER_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace MySTL {
+
+    // A front filter answers "definitely absent" for most missing keys before
+    // a container walks its buckets or tree. Containers feed it key hashes:
+    //   reset(n)       clear and size for about n keys
+    //   add(hash)      a key was inserted
+    //   remove(hash)   a key that was added is gone
+    //   mayContain(h)  false only if no added key has hash h
+    //   memoryBytes()  heap bytes held
+    // and rebuild it from their keys when they grow past the size it was
+    // reset for. A filter must never answer false for a key it holds.
+
+    // No filter, every probe goes to the container
+    struct NoFilter {
+        static constexpr bool enabled = false;
+
+        void reset(size_t) {}
+
+        void add(size_t) {}
+
+        void remove(size_t) {}
+
+        [[nodiscard]] bool mayContain(size_t) const { return true; }
+
+        [[nodiscard]] size_t memoryBytes() const { return 0; }
+    };
+
+    // murmur3 finalizer, filters take their bits from a mixed hash since
+    // std::hash is the identity for integers
+    inline uint64_t mixFilterHash(uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xFF51AFD7ED558CCDull;
+        h ^= h >> 33;
+        h *= 0xC4CEB9FE1A85EC53ull;
+        h ^= h >> 33;
+        return h;
+    }
+}  // namespace MySTL
+
+#endif  // MYSTL_FRONTFILTER_H
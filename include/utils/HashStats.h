@@ -0,0 +1,79 @@
+#ifndef MYSTL_HASHSTATS_H
+#define MYSTL_HASHSTATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <ostream>
+
+namespace MySTL {
+
+    // Health report of a chained hash table. A full stats() call walks every
+    // bucket; snapshot() only copies counters and is cheap enough to export
+    // periodically, leaving the chain fields zero.
+    struct HashTableStats {
+        static constexpr size_t HISTOGRAM_SLOTS = 8;
+
+        size_t size = 0;
+        size_t bucketCount = 0;
+        double loadFactor = 0;
+
+        size_t usedBuckets = 0;
+        size_t maxChainLength = 0;
+        // Mean length of non-empty chains, i.e. the expected scan of a hit
+        double averageChainLength = 0;
+        // Buckets by chain length, the last slot collects all longer chains
+        size_t chainHistogram[HISTOGRAM_SLOTS]{};
+
+        size_t rehashCount = 0;
+        std::chrono::nanoseconds rehashTime{0};
+
+        size_t memoryBytes = 0;
+
+        // Accounts buckets [first, last) of a bucket vector
+        template<typename Table>
+        void addChains(const Table &table, size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i) {
+                size_t length = table[i].size();
+                ++chainHistogram[length < HISTOGRAM_SLOTS ? length : HISTOGRAM_SLOTS - 1];
+                if (length == 0) continue;
+                ++usedBuckets;
+                if (length > maxChainLength) maxChainLength = length;
+            }
+            averageChainLength = usedBuckets ? static_cast<double>(size) / usedBuckets : 0;
+        }
+
+        // Folds in the report of another table, e.g. a shard of the same map
+        void merge(const HashTableStats &other) {
+            size += other.size;
+            bucketCount += other.bucketCount;
+            loadFactor = bucketCount ? static_cast<double>(size) / bucketCount : 0;
+            usedBuckets += other.usedBuckets;
+            maxChainLength = std::max(maxChainLength, other.maxChainLength);
+            averageChainLength = usedBuckets ? static_cast<double>(size) / usedBuckets : 0;
+            for (size_t i = 0; i < HISTOGRAM_SLOTS; ++i) chainHistogram[i] += other.chainHistogram[i];
+            rehashCount += other.rehashCount;
+            rehashTime += other.rehashTime;
+            memoryBytes += other.memoryBytes;
+        }
+    };
+
+    inline std::ostream &operator<<(std::ostream &os, const HashTableStats &stats) {
+        os << "size=" << stats.size
+           << " buckets=" << stats.bucketCount
+           << " load_factor=" << stats.loadFactor
+           << " used_buckets=" << stats.usedBuckets
+           << " max_chain=" << stats.maxChainLength
+           << " avg_chain=" << stats.averageChainLength
+           << " histogram=";
+        for (size_t i = 0; i < HashTableStats::HISTOGRAM_SLOTS; ++i)
+            os << (i ? "," : "") << stats.chainHistogram[i];
+        os << " rehashes=" << stats.rehashCount
+           << " rehash_ns=" << stats.rehashTime.count()
+           << " memory_bytes=" << stats.memoryBytes;
+        return os;
+    }
+}
+
+
+#endif //MYSTL_HASHSTATS_H
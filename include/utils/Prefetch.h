@@ -0,0 +1,16 @@
+#ifndef MYSTL_PREFETCH_H
+#define MYSTL_PREFETCH_H
+
+namespace MySTL {
+    // Hint the CPU to start loading addr into cache; a no-op where unsupported
+    inline void prefetch(const void *addr) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(addr);
+#else
+        (void) addr;
+#endif
+    }
+}
+
+
+#endif //MYSTL_PREFETCH_H
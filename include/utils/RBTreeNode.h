@@ -1,27 +1,69 @@
 #ifndef MYSTL_RBTREENODE_H
 #define MYSTL_RBTREENODE_H
 
+#include <cstddef>
+#include <cstdint>
+
+#include "../Pair.h"
+
 namespace MySTL {
     enum Color {
         RED, BLACK
     };
 
-    template<typename K, typename V>
-    struct RBTreeNode {
-        K key;
-        V value;
-        Color color;
+    // Trees with order statistics keep each node's subtree size; the empty
+    // base costs the others nothing
+    template<bool Sized>
+    struct RBTreeNodeSize {};
+
+    template<>
+    struct RBTreeNodeSize<true> {
+        size_t size = 1;
+    };
+
+    // An augmentation keeps a summary of each subtree in its root node:
+    // update(x) recomputes x's summary from x and its children, and the tree
+    // calls it bottom-up wherever its shape changes. No augmentation by default.
+    struct NoAugment {
+        static constexpr bool enabled = false;
+
+        template<typename Node>
+        static void update(Node *) {}
+    };
+
+    // The entry is stored as one pair, so iterators hand out references to it.
+    // Nodes are pointer aligned, so the colour lives in the low bit of the
+    // parent pointer instead of a padded field of its own.
+    template<typename K, typename V, bool Sized = false>
+    struct RBTreeNode : RBTreeNodeSize<Sized> {
+        Pair<const K, V> entry;
         RBTreeNode *left;
         RBTreeNode *right;
-        RBTreeNode *parent;
 
-        RBTreeNode(K key, V value)
-                : key(key),
-                  value(value),
-                  color(RED),
+        RBTreeNode(const K &key, const V &value)
+                : entry(key, value),
                   left(nullptr),
                   right(nullptr),
-                  parent(nullptr) {}
+                  parentColor(RED) {}
+
+        RBTreeNode *parent() const { return reinterpret_cast<RBTreeNode *>(parentColor & ~COLOR_MASK); }
+
+        void setParent(RBTreeNode *p) { parentColor = reinterpret_cast<uintptr_t>(p) | (parentColor & COLOR_MASK); }
+
+        Color color() const { return static_cast<Color>(parentColor & COLOR_MASK); }
+
+        void setColor(Color c) { parentColor = (parentColor & ~COLOR_MASK) | c; }
+
+        const K &key() const { return entry.first; }
+
+        V &value() { return entry.second; }
+
+        const V &value() const { return entry.second; }
+
+    private:
+        static constexpr uintptr_t COLOR_MASK = 1;
+
+        uintptr_t parentColor;
     };
 }
 
@@ -0,0 +1,135 @@
+#include <cassert>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <string_view>
+#include <utility>
+
+#include "../include/BTreeMap.h"
+#include "../include/BTreeSet.h"
+
+using namespace MySTL;
+
+template<typename Tree, typename Reference>
+void checkSame(Tree &tree, const Reference &reference) {
+    assert(tree.size() == reference.size() && tree.empty() == reference.empty());
+    auto it = reference.begin();
+    for (auto entry: tree) {
+        assert(entry.first == it->first && entry.second == it->second);
+        ++it;
+    }
+    assert(it == reference.end());
+    auto back = reference.rbegin();
+    for (auto rit = tree.rbegin(); rit != tree.rend(); ++rit, ++back)
+        assert((*rit).first == back->first && (*rit).second == back->second);
+    assert(back == reference.rend());
+}
+
+// Random inserts and erases split, borrow and merge nodes at every level;
+// the leaf chain and bounds must follow std::map throughout
+template<typename K, typename MakeKey>
+void checkAgainstMap(MakeKey makeKey, int range) {
+    std::mt19937 rng(39);
+    BTreeMap<K, int> tree;
+    std::map<K, int> reference;
+    for (int i = 0; i < 60000; ++i) {
+        K key = makeKey(static_cast<int>(rng() % range));
+        if (rng() % 3 == 0) {
+            tree.erase(key);
+            reference.erase(key);
+        } else {
+            tree.insert(key, i);
+            reference[key] = i;
+        }
+        if (i % 10000 == 0) checkSame(tree, reference);
+    }
+    checkSame(tree, reference);
+    for (int k = -5; k < range + 5; ++k) {
+        K key = makeKey(k);
+        auto found = reference.find(key);
+        assert(tree.contains(key) == (found != reference.end()));
+        if (found != reference.end()) assert(*tree.find(key) == found->second && tree.at(key) == found->second);
+
+        auto lower = reference.lower_bound(key);
+        auto treeLower = tree.lower_bound(key);
+        assert(lower == reference.end() ? treeLower == tree.end() : treeLower.key() == lower->first);
+        auto upper = reference.upper_bound(key);
+        auto treeUpper = tree.upper_bound(key);
+        assert(upper == reference.end() ? treeUpper == tree.end() : treeUpper.key() == upper->first);
+    }
+
+    BTreeMap<K, int> moved(std::move(tree));
+    assert(tree.empty() && tree.begin() == tree.end());
+    checkSame(moved, reference);
+    tree = std::move(moved);
+    checkSame(tree, reference);
+
+    // Draining to empty collapses the tree level by level and frees its nodes
+    size_t full = tree.memoryBytes();
+    while (!reference.empty()) {
+        auto victim = reference.begin();
+        std::advance(victim, rng() % reference.size());
+        tree.erase(victim->first);
+        reference.erase(victim);
+    }
+    checkSame(tree, reference);
+    assert(tree.memoryBytes() < full / 100);
+    tree.insert(makeKey(1), 1);
+    assert(tree.size() == 1 && tree.at(makeKey(1)) == 1);
+}
+
+// Ascending keys fill nodes at the right edge only
+void checkSequential() {
+    BTreeMap<int, int> tree;
+    std::map<int, int> reference;
+    for (int i = 0; i < 100000; ++i) {
+        tree.insert(i, -i);
+        reference[i] = -i;
+    }
+    checkSame(tree, reference);
+    for (int i = 99999; i >= 0; i -= 2) {
+        tree.erase(i);
+        reference.erase(i);
+    }
+    checkSame(tree, reference);
+}
+
+void checkSet() {
+    std::mt19937 rng(40);
+    BTreeSet<std::string, std::less<>> set;
+    std::set<std::string> reference;
+    for (int i = 0; i < 20000; ++i) {
+        auto key = std::to_string(rng() % 5000);
+        if (rng() % 4 == 0) {
+            set.erase(key);
+            reference.erase(key);
+        } else {
+            set.insert(key);
+            reference.insert(key);
+        }
+    }
+    assert(set.size() == reference.size());
+    auto it = reference.begin();
+    for (auto &key: set) assert(key == *it++);
+    assert(it == reference.end());
+    // std::less<> is transparent, so views look up without building strings
+    for (int i = 0; i < 5000; ++i) {
+        auto key = std::to_string(i);
+        assert(set.contains(std::string_view(key)) == reference.contains(key));
+    }
+    set.erase(std::string_view(*reference.begin()));
+    assert(!set.contains(*reference.begin()) && set.size() == reference.size() - 1);
+    set.clear();
+    assert(set.empty() && set.begin() == set.end());
+}
+
+int main() {
+    checkAgainstMap<int>([](int k) { return k * 3; }, 20000);
+    // A large key gives narrow nodes and a searched rather than counted key array
+    checkAgainstMap<std::string>([](int k) { return std::string(40, 'k') + std::to_string(k); }, 5000);
+    checkSequential();
+    checkSet();
+    return 0;
+}
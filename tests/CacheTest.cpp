@@ -0,0 +1,143 @@
+#include <cassert>
+#include <list>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+
+#include "../include/Concurrent/ConcurrentCache.h"
+
+using namespace MySTL;
+
+// Random gets, puts and erases must match a std::list recency model
+void checkLruAgainstModel() {
+    std::mt19937 rng(3);
+    LruCache<std::string, int> cache(32, 80);
+    std::list<std::string> order;
+    std::unordered_map<std::string, std::pair<int, size_t>> model;
+    size_t cost = 0;
+    auto evictFront = [&] {
+        cost -= model[order.front()].second;
+        model.erase(order.front());
+        order.pop_front();
+    };
+    for (int i = 0; i < 50000; ++i) {
+        std::string key = "key" + std::to_string(rng() % 100);
+        switch (rng() % 3) {
+            case 0: {
+                auto value = cache.get(key);
+                assert((value != nullptr) == model.contains(key));
+                if (value) {
+                    assert(*value == model[key].first);
+                    order.remove(key);
+                    order.push_back(key);
+                }
+                break;
+            }
+            case 1:
+                assert(cache.erase(key) == model.contains(key));
+                if (model.contains(key)) {
+                    cost -= model[key].second;
+                    model.erase(key);
+                    order.remove(key);
+                }
+                break;
+            default: {
+                size_t itemCost = 1 + rng() % 4;
+                assert(cache.put(key, i, itemCost));
+                if (model.contains(key)) {
+                    cost = cost - model[key].second + itemCost;
+                    order.remove(key);
+                    order.push_back(key);
+                    model[key] = {i, itemCost};
+                    while (cost > 80) evictFront();
+                } else {
+                    while (!order.empty() && (model.size() >= 32 || cost + itemCost > 80)) evictFront();
+                    model[key] = {i, itemCost};
+                    order.push_back(key);
+                    cost += itemCost;
+                }
+            }
+        }
+        assert(cache.size() == model.size() && cache.totalCost() == cost);
+    }
+}
+
+void checkLfuOrder() {
+    LfuCache<std::string, int> cache(3);
+    cache.put("a", 1);
+    cache.put("b", 2);
+    cache.put("c", 3);
+    cache.get("a");
+    cache.get("a");
+    cache.get("b");
+    // c is least frequently used
+    cache.put("d", 4);
+    assert(!cache.contains("c") && cache.frequency("a") == 3 && cache.frequency("d") == 1);
+    // d now has the lowest frequency
+    cache.put("e", 5);
+    assert(!cache.contains("d") && cache.contains("b"));
+}
+
+// A moved-from cache is empty and usable
+void checkMoves() {
+    LruCache<std::string, int> lru(4);
+    lru.put("x", 1);
+    LruCache<std::string, int> movedLru(std::move(lru));
+    assert(lru.empty() && *movedLru.get("x") == 1);
+    lru.put("y", 2);
+    movedLru = std::move(lru);
+    assert(lru.empty() && movedLru.size() == 1 && *movedLru.get("y") == 2);
+
+    LfuCache<std::string, int> lfu(4);
+    lfu.put("x", 1);
+    lfu.get("x");
+    LfuCache<std::string, int> movedLfu(std::move(lfu));
+    assert(lfu.empty() && movedLfu.frequency("x") == 2);
+    lfu.put("y", 2);
+    movedLfu = std::move(lfu);
+    assert(lfu.empty() && movedLfu.frequency("y") == 1);
+}
+
+// Limits below the shard count still accept every key and are never exceeded
+void checkSmallConcurrent() {
+    ConcurrentLruCache<int, int> cache(5);
+    assert(cache.shardCount() == 4);
+    for (int key = 0; key < 16; ++key) {
+        assert(cache.put(key, key));
+        assert(cache.contains(key));
+        assert(cache.size() <= 5);
+    }
+
+    ConcurrentLfuCache<int, int> single(1);
+    assert(single.shardCount() == 1 && single.put(1, 1) && single.put(2, 2) && single.size() == 1);
+
+    // Items up to maxItemCost always fit, however the keys are routed
+    ConcurrentLruCache<int, int> costly(100, 40, 10);
+    assert(costly.shardCount() == 4);
+    for (int key = 0; key < 50; ++key) {
+        assert(costly.put(key, key, 10));
+        assert(costly.totalCost() <= 40);
+    }
+
+    bool threw = false;
+    try {
+        ConcurrentLruCache<int, int> invalid(10, 5, 6);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+
+    ConcurrentLruCache<int, int> large(1000);
+    assert(large.shardCount() == 16);
+    for (int key = 0; key < 5000; ++key) large.put(key, key);
+    assert(large.size() <= 1000);
+}
+
+int main() {
+    checkLruAgainstModel();
+    checkLfuOrder();
+    checkMoves();
+    checkSmallConcurrent();
+    return 0;
+}
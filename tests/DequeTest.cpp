@@ -0,0 +1,163 @@
+#include <cassert>
+#include <deque>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#include "../include/Deque.h"
+
+using namespace MySTL;
+
+// Counts live elements, so slots left constructed in recycled blocks or
+// destroyed twice show up
+struct Tracked {
+    static inline int live = 0;
+
+    std::string text;
+
+    explicit Tracked(int n = 0) : text(std::to_string(n)) { ++live; }
+
+    Tracked(const Tracked &other) : text(other.text) { ++live; }
+
+    Tracked(Tracked &&other) noexcept : text(std::move(other.text)) { ++live; }
+
+    Tracked &operator=(const Tracked &other) = default;
+
+    Tracked &operator=(Tracked &&other) noexcept = default;
+
+    ~Tracked() { --live; }
+
+    bool operator==(const Tracked &other) const { return text == other.text; }
+};
+
+// Larger than a block's byte budget, so each block holds the minimum count
+struct Large {
+    int id = 0;
+    char padding[2000]{};
+
+    bool operator==(const Large &other) const { return id == other.id; }
+};
+
+template<typename T>
+void checkSame(Deque<T> &deque, const std::deque<T> &reference) {
+    assert(deque.size() == reference.size() && deque.empty() == reference.empty());
+    for (size_t i = 0; i < reference.size(); ++i) assert(deque[i] == reference[i]);
+    if (reference.empty()) return;
+    assert(deque.front() == reference.front() && deque.back() == reference.back());
+    assert(deque.end() - deque.begin() == static_cast<std::ptrdiff_t>(reference.size()));
+    auto it = reference.begin();
+    for (auto &element : deque) assert(element == *it++);
+    auto back = reference.rbegin();
+    for (auto rit = deque.rbegin(); rit != deque.rend(); ++rit) assert(*rit == *back++);
+    assert(back == reference.rend());
+}
+
+// Both ends grow and shrink across block and map boundaries, with inserts
+// and erases in the middle, and every step must agree with std::deque
+template<typename T, typename Make>
+void checkAgainstStd(Make make) {
+    std::mt19937 rng(50);
+    Deque<T> deque;
+    std::deque<T> reference;
+    for (int i = 0; i < 40000; ++i) {
+        // Drift between growing and shrinking phases so the deque empties at times
+        bool grow = (i / 4000) % 2 == 0 ? rng() % 3 != 0 : rng() % 3 == 0;
+        if (grow) {
+            switch (rng() % 5) {
+                case 0: deque.push_front(make(i)); reference.push_front(make(i)); break;
+                case 1: deque.emplace_front(make(i)); reference.emplace_front(make(i)); break;
+                case 2: deque.emplace_back(make(i)); reference.emplace_back(make(i)); break;
+                case 3: {
+                    size_t index = reference.empty() ? 0 : rng() % (reference.size() + 1);
+                    deque.insert(index, make(i));
+                    reference.insert(reference.begin() + static_cast<std::ptrdiff_t>(index), make(i));
+                    break;
+                }
+                default: deque.push_back(make(i)); reference.push_back(make(i));
+            }
+        } else if (!reference.empty()) {
+            switch (rng() % 3) {
+                case 0: deque.pop_front(); reference.pop_front(); break;
+                case 1: {
+                    size_t index = rng() % reference.size();
+                    deque.erase(index);
+                    reference.erase(reference.begin() + static_cast<std::ptrdiff_t>(index));
+                    break;
+                }
+                default: deque.pop_back(); reference.pop_back();
+            }
+        }
+        if (i % 2000 == 0) checkSame(deque, reference);
+    }
+    checkSame(deque, reference);
+
+    Deque<T> copy(deque);
+    checkSame(copy, reference);
+    Deque<T> moved(std::move(copy));
+    assert(copy.empty());
+    checkSame(moved, reference);
+    copy = moved;
+    moved = std::move(deque);
+    checkSame(copy, reference);
+    checkSame(moved, reference);
+
+    // Random access through iterators
+    if (!reference.empty()) {
+        auto begin = moved.begin();
+        for (size_t i = 0; i < reference.size(); i += 97) {
+            assert(begin[static_cast<std::ptrdiff_t>(i)] == reference[i]);
+            assert(*(begin + static_cast<std::ptrdiff_t>(i)) == reference[i]);
+            assert(*(moved.end() - static_cast<std::ptrdiff_t>(i + 1)) == reference[reference.size() - i - 1]);
+        }
+    }
+
+    moved.clear();
+    reference.clear();
+    checkSame(moved, reference);
+    moved.pop_back();
+    moved.pop_front();
+    assert(moved.empty());
+    for (int i = 0; i < 100; ++i) {
+        moved.push_front(make(i));
+        reference.push_front(make(i));
+    }
+    checkSame(moved, reference);
+}
+
+// A queue cycling through push_back and pop_front keeps its contents in order
+void checkQueue() {
+    Deque<int> queue;
+    int next = 0, expected = 0;
+    for (int i = 0; i < 1000; ++i) queue.push_back(next++);
+    for (int round = 0; round < 200000; ++round) {
+        queue.push_back(next++);
+        assert(queue.front() == expected++);
+        queue.pop_front();
+    }
+    assert(queue.size() == 1000 && queue.back() == next - 1);
+}
+
+int main() {
+    checkAgainstStd<int>([](int i) { return i; });
+    checkAgainstStd<Tracked>([](int i) { return Tracked(i); });
+    assert(Tracked::live == 0);
+    checkAgainstStd<Large>([](int i) {
+        Large large;
+        large.id = i;
+        return large;
+    });
+    checkQueue();
+
+    Deque<int> deque;
+    bool threw = false;
+    try {
+        deque.at(0);
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+    deque.push_back(1);
+    assert(deque.at(0) == 1);
+    return 0;
+}
@@ -0,0 +1,129 @@
+#include <cassert>
+#include <map>
+#include <random>
+#include <unordered_set>
+#include <vector>
+
+#include "../include/BloomFilter.h"
+#include "../include/CuckooFilter.h"
+#include "../include/HashSet.h"
+#include "../include/Map.h"
+
+using namespace MySTL;
+
+// No added hash is ever reported absent, and most others are
+template<typename Filter>
+void checkFilter(double maxFalsePositives) {
+    std::mt19937_64 rng(37);
+    Filter filter(10000);
+    std::vector<size_t> added;
+    for (int i = 0; i < 10000; ++i) {
+        added.push_back(rng());
+        filter.add(added.back());
+    }
+    for (size_t hash: added) assert(filter.mayContain(hash));
+    size_t falsePositives = 0;
+    for (int i = 0; i < 100000; ++i) falsePositives += filter.mayContain(rng());
+    assert(falsePositives < maxFalsePositives * 100000);
+
+    filter.reset(100);
+    size_t kept = 0;
+    for (size_t hash: added) kept += filter.mayContain(hash);
+    assert(kept < added.size() / 10);
+}
+
+// Removing half the hashes keeps the rest and frees their slots
+void checkCuckooRemove() {
+    std::mt19937_64 rng(38);
+    CuckooFilter filter(1000);
+    std::vector<size_t> added;
+    for (int i = 0; i < 1000; ++i) {
+        added.push_back(rng());
+        filter.add(added.back());
+    }
+    for (size_t i = 0; i < added.size(); i += 2) filter.remove(added[i]);
+    for (size_t i = 1; i < added.size(); i += 2) assert(filter.mayContain(added[i]));
+    size_t stale = 0;
+    for (size_t i = 0; i < added.size(); i += 2) stale += filter.mayContain(added[i]);
+    assert(stale < 50 && !filter.saturated());
+
+    // Far past its size the filter saturates rather than forgetting keys
+    for (int i = 0; i < 100000; ++i) {
+        added.push_back(rng());
+        filter.add(added.back());
+    }
+    assert(filter.saturated());
+    for (size_t i = 1; i < added.size(); i += 2) assert(filter.mayContain(added[i]));
+}
+
+// A filtered tree answers like std::map through inserts, erases and growth
+template<typename Filter>
+void checkMap() {
+    std::mt19937 rng(39);
+    Map<int, int, std::less<int>, Filter> map;
+    std::map<int, int> reference;
+    for (int i = 0; i < 50000; ++i) {
+        int key = static_cast<int>(rng() % 20000);
+        if (rng() % 3 == 0) {
+            map.erase(key);
+            reference.erase(key);
+        } else {
+            map.insert(key, i);
+            reference[key] = i;
+        }
+    }
+    assert(map.size() == reference.size());
+    for (int key = -100; key < 20100; ++key) {
+        auto found = reference.find(key);
+        assert(map.contains(key) == (found != reference.end()));
+        if (found != reference.end()) assert(*map.find(key) == found->second);
+    }
+    auto it = reference.begin();
+    for (auto [key, value]: map) {
+        assert(key == it->first && value == it->second);
+        ++it;
+    }
+
+    auto sorted = std::vector<Pair<int, int>>();
+    for (auto &[key, value]: reference) sorted.emplace_back(key, value);
+    auto built = Map<int, int, std::less<int>, Filter>::from_sorted(sorted.begin(), sorted.end());
+    for (auto &[key, value]: reference) assert(built.contains(key) && built.at(key) == value);
+    assert(!built.contains(-1) && !built.contains(20000));
+
+    map.clear();
+    for (auto &[key, value]: reference) assert(!map.contains(key));
+    map.insert(1, 1);
+    assert(map.contains(1));
+}
+
+template<typename Filter>
+void checkSet() {
+    std::mt19937 rng(40);
+    HashSet<int, std::hash<int>, std::equal_to<int>, Filter> set;
+    std::unordered_set<int> reference;
+    for (int i = 0; i < 50000; ++i) {
+        int key = static_cast<int>(rng() % 20000);
+        if (rng() % 3 == 0) {
+            set.erase(key);
+            reference.erase(key);
+        } else {
+            set.insert(key);
+            reference.insert(key);
+        }
+    }
+    assert(set.size() == reference.size());
+    for (int key = -100; key < 20100; ++key) assert(set.contains(key) == reference.contains(key));
+    set.clear();
+    assert(set.empty() && !set.contains(*reference.begin()));
+}
+
+int main() {
+    checkFilter<BloomFilter>(0.03);
+    checkFilter<CuckooFilter>(0.01);
+    checkCuckooRemove();
+    checkMap<BloomFilter>();
+    checkMap<CuckooFilter>();
+    checkSet<BloomFilter>();
+    checkSet<CuckooFilter>();
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <cassert>
+#include <string>
+
+#include "../include/FlatMap.h"
+#include "../include/FlatSet.h"
+
+using namespace MySTL;
+
+// Keys and values must survive the duplicate pass of a batch insert, which
+// once moved entries onto themselves and emptied strings
+template<bool Eytzinger>
+void checkStrings() {
+    FlatMap<int, std::string, std::less<int>, Eytzinger> byInt;
+    byInt.insert(1, "hello");
+    assert(byInt.at(1) == "hello");
+    byInt.insert(3, "three");
+    byInt.insert(2, "two");
+    assert(byInt.at(1) == "hello" && byInt.at(2) == "two" && byInt.at(3) == "three");
+
+    FlatMap<std::string, int, std::less<std::string>, Eytzinger> byString;
+    byString.insert("b", 1);
+    byString.insert("a", 2);
+    assert(byString.size() == 2);
+    assert(byString.begin().key() == "a" && byString.contains("b"));
+
+    // Duplicates in a batch: the last one wins, distinct keys are kept whole
+    Pair<std::string, std::string> batch[] = {
+            {"pear", "1"}, {"apple", "2"}, {"pear", "3"}, {"fig", "4"}, {"apple", "5"}, {"kiwi", "6"}};
+    FlatMap<std::string, std::string, std::less<std::string>, Eytzinger> fruit(batch, batch + 6);
+    assert(fruit.size() == 4);
+    assert(fruit.at("apple") == "5" && fruit.at("fig") == "4" && fruit.at("kiwi") == "6" && fruit.at("pear") == "3");
+    std::string previous;
+    for (auto it = fruit.begin(); it != fruit.end(); ++it) {
+        assert(previous < it.key());
+        previous = it.key();
+    }
+}
+
+int main() {
+    checkStrings<false>();
+    checkStrings<true>();
+
+    // Integral pairs pick the single-entry insert, not the range one
+    FlatMap<long, long> numbers;
+    numbers.insert(1, 2);
+    assert(numbers.at(1) == 2);
+
+    std::string words[] = {"delta", "alpha", "charlie", "alpha", "bravo"};
+    FlatSet<std::string> set(words, words + 5);
+    assert(set.size() == 4);
+    set.insert("echo");
+    assert(set.contains("alpha") && set.contains("delta") && set.contains("echo"));
+    std::string previous;
+    for (const auto &word : set) {
+        assert(!word.empty() && previous < word);
+        previous = word;
+    }
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <cassert>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../include/FrozenHashMap.h"
+#include "../include/HashMap.h"
+
+using namespace MySTL;
+
+struct Point {
+    int32_t x;
+    int32_t y;
+};
+
+// Copies an image into 8-byte aligned storage, as a mapping would be
+std::vector<uint64_t> imageOf(const std::string &bytes) {
+    std::vector<uint64_t> words((bytes.size() + 7) / 8);
+    std::memcpy(words.data(), bytes.data(), bytes.size());
+    return words;
+}
+
+template<typename K, typename V>
+std::string freeze(const HashMap<K, V> &map) {
+    std::ostringstream out;
+    map.freeze(out);
+    return out.str();
+}
+
+// Every key of the source map is found with its value, and absent keys miss
+void checkAgainstStd(size_t n, bool incremental) {
+    std::mt19937_64 rng(n);
+    HashMap<uint64_t, Point> map(16, 0.75, incremental);
+    std::unordered_map<uint64_t, Point> reference;
+    while (reference.size() < n) {
+        uint64_t key = rng();
+        Point point{static_cast<int32_t>(rng()), static_cast<int32_t>(rng())};
+        map.insert(key, point);
+        reference[key] = point;
+    }
+    auto bytes = freeze(map);
+    auto image = imageOf(bytes);
+    FrozenHashMap<uint64_t, Point> frozen(image.data(), bytes.size());
+    assert(frozen.size() == n && frozen.empty() == (n == 0));
+    for (auto &[key, point]: reference) {
+        auto found = frozen.find(key);
+        assert(found && found->x == point.x && found->y == point.y);
+    }
+    for (int i = 0; i < 1000; ++i) {
+        uint64_t key = rng();
+        assert(frozen.contains(key) == reference.contains(key));
+    }
+}
+
+void checkInvalidImages() {
+    HashMap<int, int> map;
+    for (int i = 0; i < 100; ++i) map.insert(i, i * i);
+    auto bytes = freeze(map);
+    auto image = imageOf(bytes);
+
+    bool threw = false;
+    try {
+        FrozenHashMap<int, int> truncated(image.data(), bytes.size() - 8);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        FrozenHashMap<int, int64_t> mismatched(image.data(), bytes.size());
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    std::vector<uint64_t> garbage(image.size(), 0);
+    try {
+        FrozenHashMap<int, int> notAnImage(garbage.data(), bytes.size());
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+void checkOpen() {
+    HashMap<int, int> map;
+    for (int i = 0; i < 5000; ++i) map.insert(i * 7, -i);
+    auto path = std::filesystem::temp_directory_path() / "mystl_frozen_test.bin";
+    {
+        std::ofstream out(path, std::ios::binary);
+        map.freeze(out);
+    }
+    auto frozen = FrozenHashMap<int, int>::open(path.c_str());
+    // The mapping moves with the map and is released once
+    FrozenHashMap<int, int> moved = std::move(frozen);
+    assert(frozen.empty() && moved.size() == 5000);
+    for (int i = 0; i < 5000; ++i) assert(*moved.find(i * 7) == -i && !moved.contains(i * 7 + 1));
+    std::filesystem::remove(path);
+}
+
+int main() {
+    for (size_t n: {0, 1, 2, 5, 100, 4097, 50000}) {
+        checkAgainstStd(n, false);
+        checkAgainstStd(n, true);
+    }
+    checkInvalidImages();
+    checkOpen();
+
+    FrozenHashMap<int, int> none;
+    assert(none.empty() && none.find(1) == nullptr);
+    return 0;
+}
@@ -0,0 +1,408 @@
+#include <bit>
+#include <cassert>
+#include <memory>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "../include/BloomFilter.h"
+#include "../include/CuckooFilter.h"
+#include "../include/HashMap.h"
+#include "../include/HashMultiMap.h"
+#include "../include/HashSet.h"
+#include "../include/Concurrent/ConcurrentHashMap.h"
+
+using namespace MySTL;
+
+// Counts hasher calls, so a step that walks every key shows up
+struct CountingHash {
+    static inline size_t calls = 0;
+
+    size_t operator()(int key) const {
+        ++calls;
+        return std::hash<int>()(key);
+    }
+};
+
+// Random inserts, erases and lookups must match std::unordered_map while the
+// table grows incrementally, and with a front filter no operation may hash
+// more than a bounded number of keys, doubling included
+template<typename Filter>
+void checkIncremental() {
+    std::mt19937 rng(7);
+    HashMap<int, int, CountingHash, std::equal_to<int>, FibonacciPolicy, Filter> map(16, 0.75, true);
+    std::unordered_map<int, int> reference;
+    size_t worst = 0;
+    for (int i = 0; i < 200000; ++i) {
+        int key = static_cast<int>(rng() % 50000);
+        size_t before = CountingHash::calls;
+        switch (rng() % 4) {
+            case 0:
+                map.erase(key);
+                reference.erase(key);
+                break;
+            case 1: {
+                auto value = map.find(key);
+                auto it = reference.find(key);
+                assert((value != nullptr) == (it != reference.end()));
+                if (value) assert(*value == it->second);
+                break;
+            }
+            default:
+                map.insert(key, i);
+                reference[key] = i;
+        }
+        worst = std::max(worst, CountingHash::calls - before);
+        assert(map.size() == reference.size());
+    }
+    // A migration step hashes the keys of a few old buckets
+    assert(worst < 64);
+    for (auto &[key, value] : reference) assert(map.contains(key) && map.at(key) == value);
+    assert(map.stats().rehashCount > 0);
+}
+
+// Switching modes, reserving and clearing in the middle of a migration keep
+// every entry reachable, and forEach sees each one once across both tables
+void checkRehashModes() {
+    HashMap<int, int> map(16, 0.75, true);
+    std::unordered_map<int, int> reference;
+    bool sawRehash = false;
+    for (int i = 0; i < 5000; ++i) {
+        map.insert(i, i * 2);
+        reference[i] = i * 2;
+        if (map.isRehashing()) {
+            sawRehash = true;
+            size_t seen = 0;
+            map.forEach([&](const int &key, const int &value) {
+                assert(reference.at(key) == value);
+                ++seen;
+            });
+            assert(seen == reference.size());
+        }
+        if (i == 3000 && map.isRehashing()) {
+            // Turning incremental mode off finishes the migration at once
+            map.setIncrementalRehash(false);
+            assert(!map.isRehashing());
+        }
+    }
+    assert(sawRehash);
+    for (auto &[key, value] : reference) assert(map.find(key) && *map.find(key) == value);
+
+    map.setIncrementalRehash(true);
+    while (!map.isRehashing()) map.insert(static_cast<int>(map.size()) + 100000, 0);
+    map.reserve(map.size() * 4);
+    assert(!map.isRehashing());
+    for (auto &[key, value] : reference) assert(map.find(key) && *map.find(key) == value);
+
+    while (!map.isRehashing()) map.insert(static_cast<int>(map.size()) + 200000, 0);
+    map.clear();
+    assert(map.empty() && !map.isRehashing() && !map.contains(0));
+    map.insert(1, 1);
+    assert(map.size() == 1 && map.at(1) == 1);
+}
+
+struct ViewHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view key) const { return std::hash<std::string_view>()(key); }
+};
+
+struct ViewEqual {
+    using is_transparent = void;
+
+    bool operator()(std::string_view lhs, std::string_view rhs) const { return lhs == rhs; }
+};
+
+// string_view and const char * probes find std::string keys, and a miss
+// through at inserts the owning key
+void checkHeterogeneous() {
+    HashMap<std::string, int, ViewHash, ViewEqual> map;
+    for (int i = 0; i < 100; ++i) map.insert("key" + std::to_string(i), i);
+    std::string_view view = "key42";
+    assert(map.contains(view) && *map.find(view) == 42 && map.at(view) == 42);
+    assert(!map.contains(std::string_view("key100")) && map.find(std::string_view("nope")) == nullptr);
+    map.erase(view);
+    assert(!map.contains(view) && map.size() == 99);
+    map.at(std::string_view("fresh")) = 7;
+    assert(map.contains(std::string("fresh")) && map.size() == 100);
+    assert(map.contains("key0"));
+
+    HashSet<std::string, ViewHash, ViewEqual> set;
+    set.insert("alpha");
+    set.insert("beta");
+    assert(set.contains(std::string_view("alpha")) && !set.contains(std::string_view("gamma")));
+    set.erase(std::string_view("alpha"));
+    assert(!set.contains("alpha") && set.contains("beta"));
+}
+
+// Single-pass view of a vector, so bulk insert cannot reserve up front
+struct OnePass {
+    using iterator_category = std::input_iterator_tag;
+    using value_type = std::pair<int, int>;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const value_type *;
+    using reference = const value_type &;
+
+    const value_type *at;
+
+    reference operator*() const { return *at; }
+
+    pointer operator->() const { return at; }
+
+    OnePass &operator++() {
+        ++at;
+        return *this;
+    }
+
+    void operator++(int) { ++at; }
+
+    bool operator==(const OnePass &other) const { return at == other.at; }
+};
+
+// Reserved capacity absorbs that many inserts, and bulk loads keep the last
+// value of a repeated key like a run of single inserts
+void checkBulk() {
+    HashMap<int, int> reserved;
+    reserved.reserve(10000);
+    size_t cap = reserved.getCap();
+    size_t rehashes = reserved.snapshot().rehashCount;
+    for (int i = 0; i < 10000; ++i) reserved.insert(i, i);
+    assert(reserved.getCap() == cap && reserved.snapshot().rehashCount == rehashes);
+
+    std::mt19937 rng(5);
+    std::vector<std::pair<int, int>> entries;
+    std::unordered_map<int, int> reference;
+    for (int i = 0; i < 20000; ++i) {
+        int key = static_cast<int>(rng() % 8000);
+        entries.emplace_back(key, i);
+        reference[key] = i;
+    }
+    auto built = HashMap<int, int>::build_from(entries.begin(), entries.end());
+    HashMap<int, int> streamed;
+    streamed.insert(OnePass{entries.data()}, OnePass{entries.data() + entries.size()});
+    HashMap<int, int> appended;
+    appended.insert(entries.begin(), entries.begin() + 10000);
+    appended.insert(entries.begin() + 10000, entries.end());
+    for (auto *map : {&built, &streamed, &appended}) {
+        assert(map->size() == reference.size());
+        for (auto &[key, value] : reference) assert(map->find(key) && *map->find(key) == value);
+    }
+}
+
+// Value that counts how often it is built
+struct Counted {
+    static inline int built = 0;
+
+    std::string text;
+
+    explicit Counted(std::string text) : text(std::move(text)) { ++built; }
+
+    Counted(const Counted &other) : text(other.text) { ++built; }
+
+    Counted(Counted &&other) noexcept = default;
+
+    Counted &operator=(const Counted &other) = default;
+
+    Counted &operator=(Counted &&other) noexcept = default;
+};
+
+// try_emplace builds nothing for a present key, insert_or_assign overwrites,
+// and node handles carry entries between maps without copying them
+void checkEmplaceAndNodes() {
+    HashMap<int, Counted> map;
+    auto first = map.try_emplace(1, "one");
+    assert(first.second && first.first->text == "one" && Counted::built == 1);
+    auto again = map.try_emplace(1, "uno");
+    assert(!again.second && again.first->text == "one" && Counted::built == 1);
+
+    auto emplaced = map.emplace(2, Counted("two"));
+    assert(emplaced.second && emplaced.first->text == "two");
+    auto duplicate = map.emplace(2, Counted("dos"));
+    assert(!duplicate.second && duplicate.first->text == "two");
+
+    auto assigned = map.insert_or_assign(1, Counted("ein"));
+    assert(!assigned.second && map.find(1)->text == "ein");
+    auto added = map.insert_or_assign(3, Counted("three"));
+    assert(added.second && map.size() == 3);
+
+    Counted *stored = map.find(2);
+    int builtBefore = Counted::built;
+    auto node = map.extract(2);
+    assert(node && node.key() == 2 && &node.mapped() == stored && !map.contains(2));
+    assert(!map.extract(42));
+
+    HashMap<int, Counted> other;
+    other.insert_or_assign(2, Counted("taken"));
+    assert(!other.insert(std::move(node)) && node && other.find(2)->text == "taken");
+    other.erase(2);
+    assert(other.insert(std::move(node)) && node.empty());
+    assert(other.find(2) == stored && stored->text == "two");
+    assert(Counted::built == builtBefore + 1);
+}
+
+// A full report accounts every bucket once and every key in some chain
+void checkReport(const HashTableStats &stats, size_t keys) {
+    size_t buckets = 0, chained = 0;
+    for (size_t i = 0; i < HashTableStats::HISTOGRAM_SLOTS; ++i) {
+        buckets += stats.chainHistogram[i];
+        chained += i * stats.chainHistogram[i];
+    }
+    assert(buckets == stats.bucketCount);
+    assert(stats.usedBuckets == stats.bucketCount - stats.chainHistogram[0]);
+    assert(stats.maxChainLength >= 1 && stats.maxChainLength < HashTableStats::HISTOGRAM_SLOTS);
+    assert(chained == keys);
+}
+
+// stats() walks the buckets, snapshot() copies the counters they share
+void checkStats() {
+    HashMap<int, int> map;
+    size_t lastRehashes = 0;
+    for (int i = 0; i < 3000; ++i) {
+        map.insert(i, i);
+        auto snapshot = map.snapshot();
+        assert(snapshot.size == map.size() && snapshot.rehashCount >= lastRehashes);
+        assert(snapshot.usedBuckets == 0 && snapshot.chainHistogram[0] == 0);
+        lastRehashes = snapshot.rehashCount;
+    }
+    assert(lastRehashes > 0);
+    for (int i = 0; i < 3000; i += 3) map.erase(i);
+    auto stats = map.stats(), snapshot = map.snapshot();
+    assert(stats.size == 2000 && stats.bucketCount == map.getCap());
+    assert(stats.size == snapshot.size && stats.bucketCount == snapshot.bucketCount);
+    assert(stats.rehashCount == snapshot.rehashCount && stats.memoryBytes == snapshot.memoryBytes);
+    assert(stats.averageChainLength == static_cast<double>(stats.size) / stats.usedBuckets);
+    checkReport(stats, map.size());
+
+    // Mid-migration both tables are reported
+    HashMap<int, int> incremental(16, 0.75, true);
+    while (!incremental.isRehashing()) incremental.insert(static_cast<int>(incremental.size()), 0);
+    checkReport(incremental.stats(), incremental.size());
+
+    // Chains hold one entry per key, so the report counts keys, not values
+    HashMultiMap<int, int> multi;
+    for (int i = 0; i < 1000; ++i) multi.insert(i % 250, i);
+    auto grouped = multi.stats();
+    assert(multi.size() == 1000 && grouped.size == multi.keyCount() && grouped.size == 250);
+    assert(grouped.bucketCount == multi.snapshot().bucketCount);
+    checkReport(grouped, multi.keyCount());
+
+    ConcurrentHashMap<int, int> shared;
+    for (int i = 0; i < 5000; ++i) shared.insert(i, -i);
+    auto merged = shared.stats();
+    assert(merged.size == 5000 && merged.size == shared.snapshot().size);
+    assert(merged.bucketCount == shared.snapshot().bucketCount && merged.rehashCount > 0);
+    assert(merged.loadFactor == static_cast<double>(merged.size) / merged.bucketCount);
+    checkReport(merged, shared.size());
+    shared.clear();
+    assert(shared.stats().size == 0 && shared.stats().usedBuckets == 0);
+}
+
+// Every policy keeps indices in range and the map agrees with the std one
+// whichever reduction places the keys
+template<typename Policy>
+void checkPolicy(bool powerOfTwo) {
+    for (size_t n = 0; n < 100; ++n) {
+        size_t cap = Policy::capacity(n);
+        assert(cap >= n && cap >= 1);
+        if (powerOfTwo) assert(std::has_single_bit(cap));
+        for (size_t hash: {size_t(0), n, n * size_t(0x9E3779B97F4A7C15ull), ~size_t(0)})
+            assert(Policy::index(hash, cap) < cap);
+    }
+
+    std::mt19937 rng(11);
+    for (bool incremental: {false, true}) {
+        HashMap<int, int, std::hash<int>, std::equal_to<int>, Policy> map(10, 0.75, incremental);
+        assert(!powerOfTwo || std::has_single_bit(map.getCap()));
+        std::unordered_map<int, int> reference;
+        for (int i = 0; i < 20000; ++i) {
+            // Strided keys collide under a plain modulus of a power of two
+            int key = static_cast<int>(rng() % 3000) * 64;
+            if (rng() % 3 == 0) {
+                map.erase(key);
+                reference.erase(key);
+            } else {
+                map.insert_or_assign(key, i);
+                reference[key] = i;
+            }
+        }
+        assert(map.size() == reference.size());
+        assert(!powerOfTwo || std::has_single_bit(map.getCap()));
+        for (auto &[key, value]: reference) assert(map.find(key) && *map.find(key) == value);
+        for (int key = 1; key < 3000 * 64; key += 64) assert(!map.contains(key));
+    }
+}
+
+// Batched lookups match one by one lookups for any batch remainder, on
+// filtered tables and in the middle of an incremental rehash
+template<typename Filter>
+void checkBatched() {
+    std::mt19937 rng(38);
+    HashMap<int, int, std::hash<int>, std::equal_to<int>, FibonacciPolicy, Filter> map(16, 0.75, true);
+    std::unordered_map<int, int> reference;
+    for (size_t n: {0, 1, 15, 16, 17, 100, 1000, 5000}) {
+        while (reference.size() < n) {
+            int key = static_cast<int>(rng() % 20000);
+            map.insert(key, key * 3);
+            reference[key] = key * 3;
+        }
+        std::vector<int> keys;
+        for (size_t i = 0; i < n; ++i) keys.push_back(static_cast<int>(rng() % 20000));
+        std::vector<int *> values(n, nullptr);
+        auto present = std::make_unique<bool[]>(n + 1);
+        map.find_many(keys, values);
+        size_t found = map.contains_many(keys, std::span<bool>(present.get(), n));
+        size_t expected = 0;
+        for (size_t i = 0; i < n; ++i) {
+            bool contained = reference.contains(keys[i]);
+            expected += contained;
+            assert(present[i] == contained && (values[i] != nullptr) == contained);
+            if (contained) assert(values[i] == map.find(keys[i]) && *values[i] == keys[i] * 3);
+        }
+        assert(found == expected);
+    }
+
+    HashSet<int, std::hash<int>, std::equal_to<int>, Filter> set;
+    for (int i = 0; i < 100; i += 2) set.insert(i);
+    std::vector<int> keys;
+    for (int i = 0; i < 100; ++i) keys.push_back(i);
+    bool present[100];
+    assert(set.contains_many(keys, present) == 50);
+    for (int i = 0; i < 100; ++i) assert(present[i] == (i % 2 == 0));
+
+    bool threw = false;
+    try {
+        std::vector<int *> shorter(keys.size() - 1);
+        map.find_many(keys, shorter);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    checkRehashModes();
+    checkHeterogeneous();
+    checkBulk();
+    checkEmplaceAndNodes();
+    checkStats();
+    checkPolicy<ModuloPolicy>(false);
+    checkPolicy<FibonacciPolicy>(true);
+    checkPolicy<MixPolicy>(true);
+    checkBatched<NoFilter>();
+    checkBatched<BloomFilter>();
+    checkBatched<CuckooFilter>();
+    checkIncremental<NoFilter>();
+    checkIncremental<BloomFilter>();
+    checkIncremental<CuckooFilter>();
+
+    // Integral pairs pick the single-entry insert, not the range one
+    HashMap<long, long> numbers;
+    numbers.insert(1, 2);
+    assert(numbers.at(1) == 2);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+#include "../include/HashMultiMap.h"
+
+using namespace MySTL;
+
+// Values of a key stay grouped in insertion order through inserts, single
+// value removals, whole key erases and the growth of the table
+int main() {
+    std::mt19937 rng(34);
+    HashMultiMap<int, int> map;
+    std::unordered_map<int, std::vector<int>> reference;
+    size_t values = 0;
+    for (int i = 0; i < 50000; ++i) {
+        int key = static_cast<int>(rng() % 2000);
+        switch (rng() % 8) {
+            case 0: {
+                size_t erased = map.erase(key);
+                auto found = reference.find(key);
+                size_t expected = found == reference.end() ? 0 : found->second.size();
+                assert(erased == expected);
+                values -= expected;
+                reference.erase(key);
+                break;
+            }
+            case 1: {
+                // Remove the first occurrence of a value that may repeat
+                int value = static_cast<int>(rng() % 4);
+                map.erase(key, value);
+                auto found = reference.find(key);
+                if (found == reference.end()) break;
+                auto &group = found->second;
+                auto at = std::find(group.begin(), group.end(), value);
+                if (at == group.end()) break;
+                group.erase(at);
+                --values;
+                if (group.empty()) reference.erase(found);
+                break;
+            }
+            default: {
+                int value = static_cast<int>(rng() % 4);
+                if (rng() % 2) map.insert(key, value);
+                else map.insert(Pair<int, int>(key, value));
+                reference[key].push_back(value);
+                ++values;
+            }
+        }
+    }
+
+    assert(map.size() == values && map.keyCount() == reference.size());
+    for (int key = 0; key < 2000; ++key) {
+        auto found = reference.find(key);
+        auto group = map.find(key);
+        if (found == reference.end()) {
+            assert(!map.contains(key) && group.empty() && map.count(key) == 0);
+            continue;
+        }
+        assert(map.contains(key) && map.count(key) == found->second.size());
+        assert(std::equal(group.begin(), group.end(), found->second.begin(), found->second.end()));
+    }
+
+    // A key with many values spills out of its inline group and stays contiguous
+    HashMultiMap<int, int> heavy;
+    for (int i = 0; i < 1000; ++i) heavy.insert(7, i);
+    auto group = heavy.find(7);
+    assert(group.size() == 1000 && heavy.keyCount() == 1);
+    for (int i = 0; i < 1000; ++i) assert(group[i] == i);
+
+    map.clear();
+    assert(map.empty() && map.size() == 0 && map.keyCount() == 0 && !map.contains(0));
+    map.insert(1, 2);
+    assert(map.count(1) == 1 && map.find(1)[0] == 2);
+    return 0;
+}
@@ -0,0 +1,62 @@
+#include <cassert>
+#include <map>
+#include <random>
+
+#include "../include/HashMultiSet.h"
+
+using namespace MySTL;
+
+// Heavy hitters on integer keys: the tracked top-k must agree with a full
+// count, through inserts, removals and merges of per-thread partials
+int main() {
+    std::mt19937 rng(42);
+    HashMultiSet<int> total(16, 0.75, 8);
+    std::map<int, size_t> reference;
+    for (int part = 0; part < 4; ++part) {
+        HashMultiSet<int> partial(16, 0.75, 8);
+        for (int i = 0; i < 20000; ++i) {
+            // Skewed so a few keys dominate
+            int key = static_cast<int>(rng() % 1000) % (1 + static_cast<int>(rng() % 64));
+            partial.insert(key);
+            ++reference[key];
+        }
+        for (int i = 0; i < 500; ++i) {
+            int key = static_cast<int>(rng() % 64);
+            if (partial.erase_one(key)) --reference[key];
+        }
+        total.merge(partial);
+    }
+
+    size_t occurrences = 0;
+    for (auto &[key, count] : reference) {
+        assert(total.count(key) == count);
+        occurrences += count;
+    }
+    assert(total.size() == occurrences);
+
+    auto top = total.top_k(8);
+    assert(top.size() == 8);
+    for (size_t i = 0; i < top.size(); ++i) {
+        assert(top[i].second == reference[top[i].first]);
+        if (i > 0) assert(top[i - 1].second >= top[i].second);
+        // Nothing untracked is more frequent than the last one kept
+        for (auto &[key, count] : reference) {
+            bool kept = false;
+            for (size_t j = 0; j < top.size(); ++j) kept |= top[j].first == key;
+            if (!kept) assert(count <= top[top.size() - 1].second);
+        }
+    }
+
+    // Past the tracked capacity the counts are scanned
+    auto wide = total.top_k(20);
+    assert(wide.size() == 20 && wide[0].second == top[0].second);
+
+    bool threw = false;
+    try {
+        total.merge(total);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+    return 0;
+}
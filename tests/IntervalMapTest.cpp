@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <tuple>
+#include <vector>
+
+#include "../include/IntervalMap.h"
+
+using namespace MySTL;
+
+using Interval = std::tuple<int, int, int>;
+
+// Reported intervals come by ascending low and match the brute force set
+void checkReport(std::vector<Interval> reported, std::vector<Interval> expected) {
+    for (size_t i = 1; i < reported.size(); ++i) assert(std::get<0>(reported[i - 1]) <= std::get<0>(reported[i]));
+    std::sort(reported.begin(), reported.end());
+    std::sort(expected.begin(), expected.end());
+    assert(reported == expected);
+}
+
+template<typename Fn>
+void checkQueries(IntervalMap<int, int> &map, const std::vector<Interval> &all, Fn &&random, int range) {
+    for (int round = 0; round < 300; ++round) {
+        int lo = random(range), hi = lo + 1 + random(range / 10);
+        std::vector<Interval> reported, expected;
+        map.overlapping(lo, hi, [&](const int &low, const int &high, int &value) {
+            reported.emplace_back(low, high, value);
+        });
+        for (auto &interval : all)
+            if (std::get<0>(interval) < hi && lo < std::get<1>(interval)) expected.push_back(interval);
+        checkReport(reported, expected);
+
+        int point = random(range);
+        reported.clear();
+        expected.clear();
+        map.stabbing(point, [&](const int &low, const int &high, int &value) {
+            reported.emplace_back(low, high, value);
+        });
+        for (auto &interval : all)
+            if (std::get<0>(interval) <= point && point < std::get<1>(interval)) expected.push_back(interval);
+        checkReport(reported, expected);
+    }
+}
+
+// Inserts and erases move the max-endpoint summaries through rotations;
+// every query must still see exactly what a scan of all intervals sees
+void checkAgainstBruteForce() {
+    std::mt19937 rng(48);
+    auto random = [&](int n) { return static_cast<int>(rng() % n); };
+    IntervalMap<int, int> map;
+    std::vector<Interval> all;
+    assert(map.empty());
+    for (int i = 0; i < 6000; ++i) {
+        int choice = random(10);
+        if (choice == 0 && !all.empty()) {
+            // Every copy of one interval goes at once
+            auto [low, high, value] = all[random(static_cast<int>(all.size()))];
+            size_t copies = std::erase_if(all, [&](const Interval &interval) {
+                return std::get<0>(interval) == low && std::get<1>(interval) == high;
+            });
+            assert(map.erase(low, high) == copies);
+        } else if (choice == 1 && !all.empty()) {
+            auto it = map.begin();
+            for (int steps = random(static_cast<int>(all.size())); steps > 0; --steps) ++it;
+            auto erased = std::find(all.begin(), all.end(), Interval(it.low(), it.high(), it.value()));
+            assert(erased != all.end());
+            all.erase(erased);
+            map.erase(it);
+        } else {
+            int low = random(10000);
+            // Mostly short intervals with a few long ones spanning many others
+            int high = low + 1 + (random(20) ? random(100) : random(5000));
+            map.insert(low, high, i);
+            all.emplace_back(low, high, i);
+        }
+    }
+    assert(map.size() == all.size() && !map.empty());
+    std::vector<Interval> iterated;
+    for (auto it = map.begin(); it != map.end(); ++it) iterated.emplace_back(it.low(), it.high(), it.value());
+    checkReport(iterated, all);
+    checkQueries(map, all, random, 10000);
+
+    map.clear();
+    assert(map.empty() && map.begin() == map.end());
+    bool visited = false;
+    map.stabbing(5, [&](const int &, const int &, int &) { visited = true; });
+    assert(!visited);
+}
+
+void checkFromSorted() {
+    std::mt19937 rng(49);
+    auto random = [&](int n) { return static_cast<int>(rng() % n); };
+    std::vector<Pair<Pair<int, int>, int>> entries;
+    std::vector<Interval> all;
+    for (int i = 0; i < 3000; ++i) {
+        int low = i * 3, high = low + 1 + random(300);
+        entries.emplace_back(Pair<int, int>(low, high), i);
+        all.emplace_back(low, high, i);
+    }
+    auto map = IntervalMap<int, int>::from_sorted(entries.begin(), entries.end());
+    assert(map.size() == all.size());
+    checkQueries(map, all, random, 9000);
+    map.insert(-10, 10000, -1);
+    all.emplace_back(-10, 10000, -1);
+    checkQueries(map, all, random, 9000);
+
+    for (auto bad : {std::vector<Pair<Pair<int, int>, int>>{{{5, 6}, 0}, {{4, 8}, 1}},
+                     std::vector<Pair<Pair<int, int>, int>>{{{5, 5}, 0}}}) {
+        bool threw = false;
+        try {
+            IntervalMap<int, int>::from_sorted(bad.begin(), bad.end());
+        } catch (const std::invalid_argument &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+    bool threw = false;
+    try {
+        map.insert(3, 2, 0);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+}
+
+int main() {
+    checkAgainstBruteForce();
+    checkFromSorted();
+    return 0;
+}
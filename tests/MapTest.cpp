@@ -0,0 +1,480 @@
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <map>
+#include <random>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "../include/Map.h"
+#include "../include/Memory/Allocator.h"
+#include "../include/MultiMap.h"
+#include "../include/MultiSet.h"
+#include "../include/Set.h"
+
+using namespace MySTL;
+
+// Containers of maps move rather than copy them when they grow
+static_assert(std::is_nothrow_move_constructible_v<Map<int, int>>);
+static_assert(std::is_nothrow_move_assignable_v<Map<int, int>>);
+
+// Splitting at random keys and joining the halves back must match std::map,
+// on the relinking path (ranked, plain allocator) and the pooled one
+template<typename MapType>
+void checkSplitJoin() {
+    std::mt19937 rng(11);
+    for (int round = 0; round < 200; ++round) {
+        MapType map;
+        std::map<int, int> reference;
+        int n = static_cast<int>(rng() % 1500);
+        for (int i = 0; i < n; ++i) {
+            int key = static_cast<int>(rng() % 4000);
+            map.insert(key, i);
+            reference[key] = i;
+        }
+        int key = static_cast<int>(rng() % 4200) - 100;
+        MapType upper = map.split(key);
+        size_t lower = 0;
+        for (auto &[k, v] : reference) {
+            if (k < key) {
+                assert(map.at(k) == v);
+                ++lower;
+            } else {
+                assert(upper.at(k) == v);
+            }
+        }
+        assert(map.size() == lower && upper.size() == reference.size() - lower);
+
+        MapType joined = MapType::join(std::move(map), std::move(upper));
+        assert(joined.size() == reference.size());
+        auto it = joined.begin();
+        for (auto &[k, v] : reference) {
+            assert(it != joined.end() && it.key() == k && it.value() == v);
+            ++it;
+        }
+        assert(it == joined.end());
+    }
+}
+
+// Reverse iteration starts at the largest key and visits every entry once,
+// for both the mutable and the const reverse iterators
+void checkReverse() {
+    Map<int, std::string> empty;
+    assert(empty.rbegin() == empty.rend());
+    assert(empty.crbegin() == empty.crend());
+
+    Map<int, std::string> map;
+    std::vector<int> keys = {50, 20, 80, 10, 30, 70, 90, 60, 40};
+    for (int key : keys) map.insert(key, std::to_string(key));
+
+    int expected = 90;
+    size_t visited = 0;
+    for (auto it = map.rbegin(); it != map.rend(); ++it, expected -= 10, ++visited) {
+        assert(it->first == expected && it.value() == std::to_string(expected));
+        it->second += "!";
+    }
+    assert(visited == keys.size());
+    assert(map.at(10) == "10!" && map.at(90) == "90!");
+
+    expected = 90;
+    for (auto it = map.crbegin(); it != map.crend(); ++it, expected -= 10) assert((*it).first == expected);
+    assert(expected == 0);
+
+    // Stepping back towards rbegin walks up the keys
+    auto it = map.rbegin();
+    ++it;
+    ++it;
+    assert(it.key() == 70);
+    --it;
+    assert(it.key() == 80);
+    auto previous = it++;
+    assert(previous.key() == 80 && it.key() == 70);
+
+    // The largest key is tracked through erase
+    map.erase(90);
+    assert(map.rbegin().key() == 80);
+}
+
+struct ViewLess {
+    using is_transparent = void;
+
+    bool operator()(std::string_view lhs, std::string_view rhs) const { return lhs < rhs; }
+};
+
+// string_view probes find std::string keys in Map and Set
+void checkHeterogeneous() {
+    Map<std::string, int, ViewLess> map;
+    for (int i = 0; i < 50; ++i) map.insert("key" + std::to_string(i), i);
+    std::string_view view = "key7";
+    assert(map.contains(view) && *map.find(view) == 7 && map.at(view) == 7);
+    assert(!map.contains(std::string_view("key50")));
+    map.erase(view);
+    assert(!map.contains(view) && map.size() == 49);
+    map.at(std::string_view("fresh")) = 3;
+    assert(map.contains(std::string("fresh")) && map.size() == 50);
+
+    Set<std::string, ViewLess> set;
+    set.insert("alpha");
+    set.insert("beta");
+    assert(set.contains(std::string_view("alpha")) && !set.contains(std::string_view("gamma")));
+    set.erase(std::string_view("alpha"));
+    assert(!set.contains(std::string_view("alpha")) && set.size() == 1);
+}
+
+// Walks map in order against a std::map
+template<typename MapType>
+void checkSame(MapType &map, const std::map<int, int> &reference) {
+    assert(map.size() == reference.size());
+    auto it = map.begin();
+    for (auto &[k, v] : reference) {
+        assert(it != map.end() && it.key() == k && it.value() == v);
+        ++it;
+    }
+    assert(it == map.end());
+}
+
+// Hints right before the key, at end() for ascending keys and anywhere else
+// all land the entry where insert would
+void checkHinted() {
+    std::mt19937 rng(41);
+    Map<int, int> map;
+    std::map<int, int> reference;
+    for (int i = 0; i < 20000; ++i) {
+        int key = static_cast<int>(rng() % 10000);
+        Map<int, int>::iterator hint = map.end();
+        switch (rng() % 3) {
+            case 0: hint = map.lower_bound(key); break;
+            case 1: hint = map.upper_bound(key); break;
+            default: hint = map.begin();
+        }
+        auto at = map.insert(hint, key, i);
+        reference[key] = i;
+        assert(at.key() == key && at.value() == i);
+    }
+    checkSame(map, reference);
+
+    Map<int, int> ascending;
+    std::map<int, int> sorted;
+    for (int i = 0; i < 10000; ++i) {
+        ascending.insert(ascending.end(), i * 2, i);
+        sorted[i * 2] = i;
+    }
+    // Filling the gaps with hints at the next key exercises the left links
+    for (int i = 0; i < 10000; ++i) {
+        ascending.insert(ascending.lower_bound(i * 2 + 1), i * 2 + 1, -i);
+        sorted[i * 2 + 1] = -i;
+    }
+    checkSame(ascending, sorted);
+}
+
+// Trees built in O(n) keep the red-black shape for every size, which the
+// inserts and erases that follow would trip over otherwise
+void checkFromSorted() {
+    std::mt19937 rng(42);
+    for (int n : {0, 1, 2, 3, 4, 7, 8, 9, 31, 32, 33, 1000, 4097}) {
+        std::vector<Pair<int, int>> entries;
+        std::map<int, int> reference;
+        for (int i = 0; i < n; ++i) {
+            entries.emplace_back(i * 3, i);
+            reference[i * 3] = i;
+        }
+        auto map = Map<int, int>::from_sorted(entries.begin(), entries.end());
+        checkSame(map, reference);
+        for (int i = 0; i < 2000; ++i) {
+            int key = static_cast<int>(rng() % (3 * n + 10));
+            if (rng() % 2) {
+                map.erase(key);
+                reference.erase(key);
+            } else {
+                map.insert(key, -i);
+                reference[key] = -i;
+            }
+        }
+        checkSame(map, reference);
+
+        std::vector<int> keys;
+        for (int i = 0; i < n; ++i) keys.push_back(i);
+        auto set = Set<int>::from_sorted(keys.begin(), keys.end());
+        assert(set.size() == keys.size());
+        int expected = 0;
+        for (int key : set) assert(key == expected++);
+    }
+
+    for (auto bad : {std::vector<Pair<int, int>>{{1, 1}, {3, 3}, {2, 2}},
+                     std::vector<Pair<int, int>>{{1, 1}, {1, 2}}}) {
+        bool threw = false;
+        try {
+            Map<int, int>::from_sorted(bad.begin(), bad.end());
+        } catch (const std::invalid_argument &) {
+            threw = true;
+        }
+        assert(threw);
+    }
+}
+
+// rank, select and count_range against positions in a sorted std::vector,
+// with duplicates for the multi containers, through inserts and erases
+void checkOrderStatistics() {
+    std::mt19937 rng(43);
+    RankedMap<int, int> map;
+    RankedSet<int> set;
+    RankedMultiMap<int, int> multiMap;
+    RankedMultiSet<int> multiSet;
+    std::set<int> keys;
+    std::multiset<int> multiKeys;
+    assert(multiMap.empty() && multiSet.empty());
+    for (int i = 0; i < 20000; ++i) {
+        int key = static_cast<int>(rng() % 3000);
+        if (rng() % 4 == 0) {
+            map.erase(key);
+            set.erase(key);
+            keys.erase(key);
+            assert(multiMap.erase(key) == multiKeys.count(key));
+            multiSet.erase(key);
+            multiKeys.erase(key);
+        } else {
+            map.insert(key, i);
+            set.insert(key);
+            keys.insert(key);
+            multiMap.insert(key, i);
+            multiSet.insert(key);
+            multiKeys.insert(key);
+        }
+    }
+    assert(!multiMap.empty() && multiMap.size() == multiKeys.size() && multiSet.size() == multiKeys.size());
+
+    std::vector<int> sorted(keys.begin(), keys.end());
+    std::vector<int> multiSorted(multiKeys.begin(), multiKeys.end());
+    auto below = [](const std::vector<int> &v, int key) {
+        return static_cast<size_t>(std::lower_bound(v.begin(), v.end(), key) - v.begin());
+    };
+    for (int key = -1; key <= 3001; ++key) {
+        assert(map.rank(key) == below(sorted, key) && set.rank(key) == below(sorted, key));
+        assert(multiMap.rank(key) == below(multiSorted, key) && multiSet.rank(key) == below(multiSorted, key));
+        assert(multiMap.count(key) == multiKeys.count(key));
+    }
+    for (size_t i = 0; i < sorted.size(); ++i) assert(map.select(i).key() == sorted[i] && set.select(i) == sorted[i]);
+    for (size_t i = 0; i < multiSorted.size(); ++i)
+        assert((*multiMap.select(i)).first == multiSorted[i] && (*multiSet.select(i)).first == multiSorted[i]);
+    for (int round = 0; round < 2000; ++round) {
+        int lo = static_cast<int>(rng() % 3100) - 50, hi = static_cast<int>(rng() % 3100) - 50;
+        size_t expected = lo < hi ? below(sorted, hi) - below(sorted, lo) : 0;
+        size_t multiExpected = lo < hi ? below(multiSorted, hi) - below(multiSorted, lo) : 0;
+        assert(map.count_range(lo, hi) == expected && set.count_range(lo, hi) == expected);
+        assert(multiMap.count_range(lo, hi) == multiExpected && multiSet.count_range(lo, hi) == multiExpected);
+    }
+
+    bool threw = false;
+    try {
+        map.select(map.size());
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+    threw = false;
+    try {
+        multiSet.select(multiSet.size());
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+
+    multiMap.clear();
+    assert(multiMap.empty() && multiMap.rank(100) == 0 && multiMap.count_range(0, 3000) == 0);
+}
+
+// Bounds, range erase and range visits follow std::map, on the pooled map
+// and on the ranked one whose range erase relinks without copying
+template<typename MapType>
+void checkRanges() {
+    std::mt19937 rng(44);
+    MapType map;
+    std::map<int, int> reference;
+    for (int i = 0; i < 5000; ++i) {
+        int key = static_cast<int>(rng() % 20000);
+        map.insert(key, i);
+        reference[key] = i;
+    }
+    auto sameAt = [&](typename MapType::iterator it, std::map<int, int>::iterator expected) {
+        return expected == reference.end() ? it == map.end() : it != map.end() && it.key() == expected->first;
+    };
+    for (int key = -5; key < 20005; key += 7) {
+        assert(sameAt(map.lower_bound(key), reference.lower_bound(key)));
+        assert(sameAt(map.upper_bound(key), reference.upper_bound(key)));
+        auto range = map.equal_range(key);
+        auto expected = reference.equal_range(key);
+        assert(sameAt(range.first, expected.first) && sameAt(range.second, expected.second));
+    }
+
+    for (int round = 0; round < 300 && !reference.empty(); ++round) {
+        int lo = static_cast<int>(rng() % 20000);
+        int hi = lo + static_cast<int>(rng() % 500);
+        std::vector<std::pair<int, int>> visited;
+        map.for_each_in_range(lo, hi, [&](const int &k, int &v) { visited.emplace_back(k, v); });
+        auto first = reference.lower_bound(lo), last = reference.lower_bound(hi);
+        assert(std::equal(visited.begin(), visited.end(), first, last,
+                          [](auto &a, auto &b) { return a.first == b.first && a.second == b.second; }));
+
+        auto next = map.erase(map.lower_bound(lo), map.lower_bound(hi));
+        auto expectedNext = reference.erase(first, last);
+        assert(sameAt(next, expectedNext));
+        if (round % 50 == 0) checkSame(map, reference);
+    }
+    checkSame(map, reference);
+    map.erase(map.begin(), map.end());
+    assert(map.empty() && map.begin() == map.end());
+    map.insert(1, 1);
+    assert(map.size() == 1);
+}
+
+void checkSetRanges() {
+    Set<int> set;
+    std::set<int> reference;
+    for (int i = 0; i < 1000; i += 3) {
+        set.insert(i);
+        reference.insert(i);
+    }
+    std::vector<int> visited;
+    set.for_each_in_range(100, 200, [&](const int &key) { visited.push_back(key); });
+    assert(std::equal(visited.begin(), visited.end(), reference.lower_bound(100), reference.lower_bound(200)));
+    auto range = set.equal_range(300);
+    assert(*range.first == 300 && *range.second == 303);
+    auto next = set.erase(set.lower_bound(100), set.upper_bound(500));
+    reference.erase(reference.lower_bound(100), reference.upper_bound(500));
+    assert(*next == *reference.upper_bound(99) && set.size() == reference.size());
+    auto it = reference.begin();
+    for (int key : set) assert(key == *it++);
+}
+
+// union_with, intersect_with and difference_with against the std::set_*
+// algorithms, for skewed sizes and past the threshold that runs them on
+// several threads
+template<typename MapType>
+void checkSetAlgebra() {
+    std::mt19937 rng(45);
+    for (auto [leftSize, rightSize, range] : {std::tuple{0, 100, 1000}, std::tuple{100, 0, 1000},
+                                              std::tuple{1000, 10, 5000}, std::tuple{10, 1000, 5000},
+                                              std::tuple{3000, 3000, 8000}, std::tuple{60000, 60000, 200000}}) {
+        std::map<int, int> left, right;
+        while (static_cast<int>(left.size()) < leftSize) left[static_cast<int>(rng() % range)] = 1;
+        while (static_cast<int>(right.size()) < rightSize) right[static_cast<int>(rng() % range)] = 2;
+        auto build = [](const std::map<int, int> &entries) {
+            MapType map;
+            for (auto &[k, v] : entries) map.insert(k, v);
+            return map;
+        };
+        auto byKey = [](auto &a, auto &b) { return a.first < b.first; };
+
+        // Keys in both take the value from the right operand
+        std::map<int, int> expected;
+        std::set_union(right.begin(), right.end(), left.begin(), left.end(),
+                       std::inserter(expected, expected.end()), byKey);
+        MapType united = build(left);
+        MapType other = build(right);
+        united.union_with(std::move(other));
+        assert(other.empty());
+        checkSame(united, expected);
+
+        expected.clear();
+        std::set_intersection(left.begin(), left.end(), right.begin(), right.end(),
+                              std::inserter(expected, expected.end()), byKey);
+        MapType common = build(left);
+        common.intersect_with(build(right));
+        checkSame(common, expected);
+
+        expected.clear();
+        std::set_difference(left.begin(), left.end(), right.begin(), right.end(),
+                            std::inserter(expected, expected.end()), byKey);
+        MapType rest = build(left);
+        rest.difference_with(build(right));
+        checkSame(rest, expected);
+
+        // The results stay usable trees
+        rest.insert(-1, 0);
+        rest.erase(-1);
+        checkSame(rest, expected);
+    }
+}
+
+// Counts copies, so handing out entries by value shows up
+struct CopyCounted {
+    static inline int copies = 0;
+
+    int value = 0;
+
+    CopyCounted() = default;
+
+    explicit CopyCounted(int value) : value(value) {}
+
+    CopyCounted(const CopyCounted &other) : value(other.value) { ++copies; }
+
+    CopyCounted &operator=(const CopyCounted &other) {
+        value = other.value;
+        ++copies;
+        return *this;
+    }
+};
+
+static_assert(std::is_same_v<Map<int, int>::iterator::reference, Pair<const int, int> &>);
+static_assert(std::is_same_v<MultiMap<int, int>::iterator::reference, Pair<const int, int> &>);
+
+// Iterators hand out references to the stored Pair<const K, V>, so scans and
+// in-place updates copy nothing and agree with find
+void checkEntryReferences() {
+    Map<int, CopyCounted> map;
+    MultiMap<int, CopyCounted> multiMap;
+    std::map<int, int> reference;
+    for (int i = 0; i < 1000; ++i) {
+        map.insert(i * 2, CopyCounted(i));
+        multiMap.insert(i % 100, CopyCounted(i));
+        reference[i * 2] = i;
+    }
+    CopyCounted::copies = 0;
+
+    for (auto &[key, value] : map) value.value += key;
+    for (auto it = map.begin(); it != map.end(); ++it) {
+        assert(&it->second == map.find(it->first) && &(*it).second == &it.value());
+        it->second.value -= it->first;
+    }
+    auto expected = reference.begin();
+    for (const auto &[key, value] : map) {
+        assert(key == expected->first && value.value == expected->second);
+        ++expected;
+    }
+    for (auto it = map.rbegin(); it != map.rend(); ++it) it->second.value *= 2;
+    assert(map.at(10).value == 10 && map.at(1998).value == 1998);
+
+    int last = 100;
+    for (auto it = multiMap.rbegin(); it != multiMap.rend(); ++it) {
+        // The reverse iterator yields the whole entry too
+        Pair<const int, CopyCounted> &entry = *it;
+        assert(entry.first <= last && entry.second.value % 100 == entry.first);
+        last = entry.first;
+        ++entry.second.value;
+    }
+    for (auto &[key, value] : multiMap) assert((value.value - 1) % 100 == key);
+    assert(CopyCounted::copies == 0);
+}
+
+int main() {
+    checkReverse();
+    checkHinted();
+    checkFromSorted();
+    checkOrderStatistics();
+    checkRanges<Map<int, int>>();
+    checkRanges<Map<int, int, std::less<int>, NoFilter, Allocator<Pair<int, int>>, true>>();
+    checkSetRanges();
+    checkEntryReferences();
+    checkSetAlgebra<Map<int, int>>();
+    checkSetAlgebra<Map<int, int, std::less<int>, NoFilter, Allocator<Pair<int, int>>, true>>();
+    checkHeterogeneous();
+    checkSplitJoin<Map<int, int>>();
+    checkSplitJoin<Map<int, int, std::less<int>, NoFilter, Allocator<Pair<int, int>>, true>>();
+    return 0;
+}
@@ -0,0 +1,136 @@
+#include <cassert>
+#include <map>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "../include/PersistentMap.h"
+
+using namespace MySTL;
+
+// Counts live values, so shared nodes and freed versions can be told apart
+struct Tracked {
+    static inline int live = 0;
+
+    int value;
+
+    explicit Tracked(int value = 0) : value(value) { ++live; }
+
+    Tracked(const Tracked &other) : value(other.value) { ++live; }
+
+    Tracked &operator=(const Tracked &other) = default;
+
+    ~Tracked() { --live; }
+};
+
+void checkSame(const PersistentMap<int, Tracked> &map, const std::map<int, int> &reference) {
+    assert(map.size() == reference.size() && map.empty() == reference.empty());
+    auto it = map.begin();
+    for (auto &[key, value] : reference) {
+        assert(it != map.end() && it.key() == key && it.value().value == value);
+        ++it;
+    }
+    assert(it == map.end());
+    auto expected = reference.begin();
+    map.for_each([&](const int &key, const Tracked &value) {
+        assert(key == expected->first && value.value == expected->second);
+        ++expected;
+    });
+}
+
+// Every version keeps the contents it had when it was made, however many
+// updates are built on it or on its successors
+void checkVersions() {
+    std::mt19937 rng(45);
+    std::vector<PersistentMap<int, Tracked>> versions(1);
+    std::vector<std::map<int, int>> references(1);
+    for (int i = 0; i < 3000; ++i) {
+        // Mostly extend the newest version, sometimes branch off an older one
+        size_t base = rng() % 16 ? versions.size() - 1 : rng() % versions.size();
+        int key = static_cast<int>(rng() % 500);
+        auto reference = references[base];
+        if (rng() % 3 == 0) {
+            versions.push_back(versions[base].erase(key));
+            reference.erase(key);
+        } else {
+            versions.push_back(versions[base].insert(key, Tracked(i)));
+            reference[key] = i;
+        }
+        references.push_back(std::move(reference));
+    }
+    for (size_t v = 0; v < versions.size(); v += 7) checkSame(versions[v], references[v]);
+    checkSame(versions.back(), references.back());
+
+    // Versions share nodes: far fewer values are alive than entries in all versions
+    size_t entries = 0;
+    for (auto &reference : references) entries += reference.size();
+    assert(static_cast<size_t>(Tracked::live) < entries / 10);
+
+    auto &last = versions.back();
+    auto &expected = references.back();
+    for (int key = -5; key < 505; ++key) {
+        auto found = expected.find(key);
+        assert(last.contains(key) == (found != expected.end()));
+        if (found != expected.end())
+            assert(last.find(key)->value == found->second && last.at(key).value == found->second);
+        auto lower = expected.lower_bound(key);
+        auto lastLower = last.lower_bound(key);
+        assert(lower == expected.end() ? lastLower == last.end() : lastLower.key() == lower->first);
+        auto upper = expected.upper_bound(key);
+        auto lastUpper = last.upper_bound(key);
+        assert(upper == expected.end() ? lastUpper == last.end() : lastUpper.key() == upper->first);
+    }
+    std::vector<int> visited;
+    last.for_each_in_range(100, 200, [&](const int &key, const Tracked &) { visited.push_back(key); });
+    auto it = expected.lower_bound(100);
+    for (int key : visited) assert(key == (it++)->first);
+    assert(it == expected.lower_bound(200));
+
+    // Erasing an absent key hands back the same tree
+    assert(last.erase(-1).begin() == last.begin());
+
+    bool threw = false;
+    try {
+        (void) last.at(-1);
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+
+    PersistentMap<int, Tracked> moved(std::move(versions.back()));
+    assert(versions.back().empty() && moved.size() == expected.size());
+    versions.clear();
+    references.clear();
+    moved = PersistentMap<int, Tracked>();
+    assert(Tracked::live == 0);
+}
+
+// Readers walk a version while the writer keeps building new ones from it
+void checkConcurrentReaders() {
+    PersistentMap<int, Tracked> version;
+    std::map<int, int> reference;
+    for (int i = 0; i < 2000; ++i) {
+        version = version.insert(i, Tracked(i));
+        reference[i] = i;
+    }
+    std::vector<std::thread> readers;
+    for (int t = 0; t < 4; ++t) {
+        readers.emplace_back([snapshot = version, &reference] {
+            for (int round = 0; round < 20; ++round) checkSame(snapshot, reference);
+        });
+    }
+    auto writer = version;
+    for (int i = 0; i < 2000; ++i) writer = i % 2 ? writer.erase(i) : writer.insert(i, Tracked(-i));
+    for (auto &reader : readers) reader.join();
+    checkSame(version, reference);
+    assert(writer.size() == 1000 && writer.at(0).value == 0 && writer.at(2).value == -2);
+}
+
+int main() {
+    checkVersions();
+    checkConcurrentReaders();
+    assert(Tracked::live == 0);
+    return 0;
+}
@@ -0,0 +1,162 @@
+#include <cassert>
+#include <map>
+#include <random>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "../include/Map.h"
+#include "../include/Memory/Allocator.h"
+#include "../include/Memory/PoolAllocator.h"
+#include "../include/MultiMap.h"
+#include "../include/MultiSet.h"
+#include "../include/Set.h"
+
+using namespace MySTL;
+
+// Counts live copies, so a pool that frees slabs without running
+// destructors shows up as a leak
+struct Tracked {
+    static inline int live = 0;
+
+    std::string text;
+
+    explicit Tracked(int n = 0) : text(std::to_string(n)) { ++live; }
+
+    Tracked(const Tracked &other) : text(other.text) { ++live; }
+
+    Tracked &operator=(const Tracked &other) = default;
+
+    ~Tracked() { --live; }
+};
+
+// Freed slots are reused before the pool grows, and release frees them all
+void checkPool() {
+    PoolAllocator<long> pool;
+    std::vector<long *> taken;
+    for (int i = 0; i < 1000; ++i) {
+        taken.push_back(pool.allocate());
+        *taken.back() = i;
+    }
+    size_t grown = pool.slabBytes();
+    assert(grown >= 1000 * sizeof(long));
+    for (int i = 0; i < 1000; ++i) assert(*taken[i] == i);
+    for (size_t i = 0; i < taken.size(); i += 2) pool.deallocate(taken[i]);
+    for (size_t i = 0; i < taken.size(); i += 2) taken[i] = pool.allocate();
+    assert(pool.slabBytes() == grown);
+
+    // Array requests bypass the slabs
+    long *array = pool.allocate(64);
+    assert(pool.slabBytes() == grown);
+    pool.deallocate(array, 64);
+
+    PoolAllocator<long> other;
+    long *adopted = other.allocate();
+    *adopted = -1;
+    pool.adopt(other);
+    assert(other.slabBytes() == 0 && pool.slabBytes() > grown && *adopted == -1);
+    pool.deallocate(adopted);
+
+    PoolAllocator<long> moved(std::move(pool));
+    assert(pool.slabBytes() == 0 && moved.slabBytes() > grown);
+    moved.release();
+    assert(moved.slabBytes() == 0);
+    long *fresh = moved.allocate();
+    *fresh = 7;
+    moved.deallocate(fresh);
+}
+
+// A pooled tree answers exactly like one on the plain allocator
+template<typename Alloc>
+void checkMap() {
+    std::mt19937 rng(40);
+    {
+        Map<int, Tracked, std::less<int>, NoFilter, Alloc> map;
+        std::map<int, std::string> reference;
+        for (int i = 0; i < 30000; ++i) {
+            int key = static_cast<int>(rng() % 5000);
+            if (rng() % 3 == 0) {
+                map.erase(key);
+                reference.erase(key);
+            } else {
+                map.insert(key, Tracked(i));
+                reference[key] = std::to_string(i);
+            }
+        }
+        assert(map.size() == reference.size() && Tracked::live == static_cast<int>(reference.size()));
+        auto it = reference.begin();
+        for (auto [key, value]: map) {
+            assert(key == it->first && value.text == it->second);
+            ++it;
+        }
+        map.clear();
+        assert(Tracked::live == 0 && map.empty());
+        for (int i = 0; i < 100; ++i) map.insert(i, Tracked(i));
+    }
+    assert(Tracked::live == 0);
+
+    Set<int, std::less<int>, typename Alloc::template rebind<int>::other> set;
+    std::set<int> keys;
+    for (int i = 0; i < 30000; ++i) {
+        int key = static_cast<int>(rng() % 5000);
+        if (rng() % 3 == 0) {
+            set.erase(key);
+            keys.erase(key);
+        } else {
+            set.insert(key);
+            keys.insert(key);
+        }
+    }
+    assert(set.size() == keys.size());
+    auto key = keys.begin();
+    for (int k: set) assert(k == *key++);
+}
+
+template<typename Alloc>
+void checkMultiMap() {
+    std::mt19937 rng(41);
+    {
+        MultiMap<int, Tracked, std::less<int>, Alloc> map;
+        std::multimap<int, std::string> reference;
+        for (int i = 0; i < 30000; ++i) {
+            int key = static_cast<int>(rng() % 1000);
+            if (rng() % 5 == 0) {
+                auto erased = map.erase(key);
+                assert(erased == reference.erase(key));
+            } else {
+                map.insert(key, Tracked(i));
+                reference.emplace(key, std::to_string(i));
+            }
+        }
+        assert(map.size() == reference.size() && Tracked::live == static_cast<int>(reference.size()));
+        // Equal keys keep their insertion order, as in std::multimap
+        auto it = reference.begin();
+        for (auto entry = map.begin(); entry != map.end(); ++entry, ++it)
+            assert((*entry).first == it->first && (*entry).second.text == it->second);
+        for (int k = 0; k < 1000; ++k) assert(map.count(k) == reference.count(k));
+    }
+    assert(Tracked::live == 0);
+
+    MultiSet<int, std::less<int>, typename Alloc::template rebind<int>::other> set;
+    std::multiset<int> keys;
+    for (int i = 0; i < 30000; ++i) {
+        int key = static_cast<int>(rng() % 1000);
+        set.insert(key);
+        keys.insert(key);
+    }
+    for (int k = 0; k < 1000; k += 3) assert(set.erase(k) == keys.erase(k));
+    assert(set.size() == keys.size());
+    auto key = keys.begin();
+    for (auto it = set.begin(); it != set.end(); ++it) assert((*it).first == *key++);
+    set.clear();
+    assert(set.empty() && set.begin() == set.end());
+}
+
+int main() {
+    checkPool();
+    checkMap<PoolAllocator<Pair<int, Tracked>>>();
+    checkMap<Allocator<Pair<int, Tracked>>>();
+    checkMultiMap<PoolAllocator<Pair<int, Tracked>>>();
+    checkMultiMap<Allocator<Pair<int, Tracked>>>();
+    return 0;
+}
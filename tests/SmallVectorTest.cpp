@@ -0,0 +1,124 @@
+#include <cassert>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/SmallVector.h"
+
+using namespace MySTL;
+
+// Copyable element whose move may throw, so growth copies it; copies throw
+// once the budget runs out. live counts constructed, undestroyed values.
+struct Fragile {
+    static inline int live = 0;
+    static inline int copyBudget = -1;
+
+    int value;
+
+    explicit Fragile(int value) : value(value) { ++live; }
+
+    Fragile(const Fragile &other) : value(other.value) {
+        if (copyBudget == 0) throw std::runtime_error("copy failed");
+        if (copyBudget > 0) --copyBudget;
+        ++live;
+    }
+
+    Fragile(Fragile &&other) : value(other.value) {
+        other.value = -1;
+        ++live;
+    }
+
+    ~Fragile() { --live; }
+};
+
+// A throw while growing leaves every element in place and leaks nothing
+void checkStrongGrowth() {
+    {
+        SmallVector<Fragile, 4> v;
+        for (int i = 0; i < 4; ++i) v.emplace_back(i);
+        Fragile::copyBudget = 2;
+        bool threw = false;
+        try {
+            v.emplace_back(4);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        Fragile::copyBudget = -1;
+        assert(threw && v.size() == 4 && v.capacity() == 4);
+        for (int i = 0; i < 4; ++i) assert(v[i].value == i);
+        assert(Fragile::live == 4);
+
+        // The same through reserve
+        Fragile::copyBudget = 1;
+        threw = false;
+        try {
+            v.reserve(64);
+        } catch (const std::runtime_error &) {
+            threw = true;
+        }
+        Fragile::copyBudget = -1;
+        assert(threw && v.capacity() == 4 && Fragile::live == 4);
+        for (int i = 0; i < 4; ++i) assert(v[i].value == i);
+
+        v.emplace_back(4);
+        assert(v.size() == 5 && v[4].value == 4 && v[0].value == 0);
+    }
+    assert(Fragile::live == 0);
+}
+
+// Growing from an element of the vector itself copies it before it moves
+void checkAliasing() {
+    SmallVector<std::string, 2> v;
+    v.push_back(std::string(40, 'a'));
+    v.push_back(std::string(40, 'b'));
+    v.push_back(v[0]);
+    v.emplace_back(v[1]);
+    assert(v.size() == 4 && v[2] == std::string(40, 'a') && v[3] == std::string(40, 'b'));
+}
+
+// Random operations match std::vector, across the inline/heap boundary
+void checkAgainstVector() {
+    std::mt19937 rng(9);
+    SmallVector<std::string, 3> v;
+    std::vector<std::string> reference;
+    for (int i = 0; i < 20000; ++i) {
+        switch (rng() % 5) {
+            case 0:
+                if (!reference.empty()) {
+                    v.pop_back();
+                    reference.pop_back();
+                }
+                break;
+            case 1:
+                if (!reference.empty()) {
+                    size_t index = rng() % reference.size();
+                    v.erase(index);
+                    reference.erase(reference.begin() + static_cast<std::ptrdiff_t>(index));
+                }
+                break;
+            case 2:
+                if (rng() % 50 == 0) {
+                    v.clear();
+                    reference.clear();
+                }
+                break;
+            default:
+                v.push_back("item" + std::to_string(i));
+                reference.push_back("item" + std::to_string(i));
+        }
+        assert(v.size() == reference.size());
+    }
+    for (size_t i = 0; i < reference.size(); ++i) assert(v.at(i) == reference[i]);
+
+    SmallVector<std::string, 3> copy(v);
+    SmallVector<std::string, 3> moved(std::move(copy));
+    assert(moved.size() == reference.size() && (reference.empty() || moved.back() == reference.back()));
+}
+
+int main() {
+    checkStrongGrowth();
+    checkAliasing();
+    checkAgainstVector();
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <cassert>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "../include/StaticMap.h"
+
+using namespace MySTL;
+
+enum class Color { Red, Green, Blue };
+
+constexpr Pair<std::string_view, int> MONTH_ENTRIES[] = {
+        {"jan", 1}, {"feb", 2}, {"mar", 3}, {"apr", 4}, {"may", 5}, {"jun", 6},
+        {"jul", 7}, {"aug", 8}, {"sep", 9}, {"oct", 10}, {"nov", 11}, {"dec", 12},
+};
+
+constexpr StaticMap<std::string_view, int, 12> months(MONTH_ENTRIES);
+
+// The table is built and queried during constant evaluation
+static_assert(months.size() == 12 && !months.empty());
+static_assert(months.at("jan") == 1 && months.at("dec") == 12);
+static_assert(!months.contains("foo") && months.find("") == nullptr);
+
+constexpr auto colors = makeStaticMap<Color, const char *>({
+        {Color::Red, "red"}, {Color::Green, "green"}, {Color::Blue, "blue"},
+});
+static_assert(colors.size() == 3 && colors.contains(Color::Blue));
+
+// Every key is found in its slot with its value, other keys miss
+template<size_t N>
+void checkIntegers() {
+    Pair<int, int> entries[N];
+    std::unordered_map<int, int> reference;
+    for (size_t i = 0; i < N; ++i) {
+        int key = static_cast<int>(i * i * 7919 + 13);
+        entries[i] = {key, static_cast<int>(i)};
+        reference[key] = static_cast<int>(i);
+    }
+    StaticMap<int, int, N> map(entries);
+    assert(map.size() == reference.size());
+    for (auto &[key, value]: reference) assert(map.contains(key) && map.at(key) == value);
+    for (size_t i = 0; i < N; ++i) assert(reference.at(map.keyAt(i)) == map.valueAt(i));
+    for (int key = -1000; key < 1000; ++key) assert(map.contains(key) == reference.contains(key));
+}
+
+int main() {
+    for (auto &[name, month]: MONTH_ENTRIES) assert(months.at(name) == month);
+    // Anything convertible to std::string_view looks up without a copy
+    std::string owned = "sep";
+    assert(*months.find(owned) == 9 && !months.contains(std::string("sept")));
+    assert(std::string_view(colors.at(Color::Green)) == "green");
+
+    bool threw = false;
+    try {
+        (void) months.at("none");
+    } catch (const std::out_of_range &) {
+        threw = true;
+    }
+    assert(threw);
+
+    threw = false;
+    try {
+        Pair<int, int> duplicates[] = {{1, 1}, {2, 2}, {1, 3}};
+        StaticMap<int, int, 3> map(duplicates);
+    } catch (const std::invalid_argument &) {
+        threw = true;
+    }
+    assert(threw);
+
+    checkIntegers<1>();
+    checkIntegers<2>();
+    checkIntegers<64>();
+    checkIntegers<1000>();
+    return 0;
+}